@@ -0,0 +1,66 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __HOST_H
+#define __HOST_H
+
+/* The host build of the firmware modules. The Makefile forces this file into every source before its own includes,
+ * so the modules are built against the real headers of the project with these changes:
+ * 	- the Cortex-M instructions of CMSIS are dropped, so the core registers can't be used;
+ * 	- the peripherals the tests touch are structures in the memory of the test;
+ * 	- the parts of the FreeRTOS port which need the Cortex-M core are replaced, the kernel and CMSIS-RTOS functions
+ * 	  are the fakes of host.c, they never block.
+ */
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+
+// The asm statements of cmsis_gcc.h stay in the code, but they are never compiled into it
+#define __ASM		if(0) __asm
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#include "stm32f4xx.h"
+#pragma GCC diagnostic pop
+#include "cmsis_os.h"
+#include <stdio.h>
+
+//---------------------------------------------------------------------------
+// Peripherals
+//---------------------------------------------------------------------------
+extern DMA_TypeDef hostDma1;
+extern DMA_TypeDef hostDma2;
+extern DMA2D_TypeDef hostDma2d;
+extern RCC_TypeDef hostRcc;
+
+#undef DMA1
+#define DMA1				(&hostDma1)
+#undef DMA2
+#define DMA2				(&hostDma2)
+#undef DMA2D
+#define DMA2D				(&hostDma2d)
+#undef RCC
+#define RCC					(&hostRcc)
+
+//---------------------------------------------------------------------------
+// FreeRTOS port
+//---------------------------------------------------------------------------
+#undef portYIELD
+#define portYIELD()
+#undef portSET_INTERRUPT_MASK_FROM_ISR
+#define portSET_INTERRUPT_MASK_FROM_ISR()		(0U)
+#undef portCLEAR_INTERRUPT_MASK_FROM_ISR
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)	((void)(x))
+#undef portDISABLE_INTERRUPTS
+#define portDISABLE_INTERRUPTS()
+#undef portENABLE_INTERRUPTS
+#define portENABLE_INTERRUPTS()
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+osSemaphoreId HOST_getSemaphore(uint8_t index);
+uint32_t HOST_getSemaphoreCount(osSemaphoreId semaphore_id);
+
+#endif /* __HOST_H */
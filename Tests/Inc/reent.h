@@ -0,0 +1,15 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __REENT_H
+#define __REENT_H
+
+/* FreeRTOSConfig.h keeps a newlib context in every thread (configUSE_NEWLIB_REENTRANT), the host C library has no
+ * such header. Only the size of the structure is needed by FreeRTOS.h.
+ */
+struct _reent
+{
+	int unused;
+};
+
+#endif /* __REENT_H */
@@ -0,0 +1,42 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __TEST_H
+#define __TEST_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+
+/* Every test file is a program: main runs the cases with TEST_RUN and returns TEST_RESULT. A failed check prints
+ * the file, the line and the expression, the case goes on, so one run shows all the failures.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define TEST_CHECK(EXPR)		do { if(!(EXPR)) { testFailures++; \
+									 printf("%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, testName, #EXPR); } \
+								} while(0)
+
+#define TEST_EQUAL(ACTUAL, EXPECTED)	do { long long actual_ = (long long)(ACTUAL), expected_ = (long long)(EXPECTED); \
+									 if(actual_ != expected_) { testFailures++; \
+									 printf("%s:%d: %s: %s is %lld, expected %lld\n", __FILE__, __LINE__, testName, \
+											#ACTUAL, actual_, expected_); } \
+								} while(0)
+
+#define TEST_RUN(CASE)			do { testName = #CASE; testCases++; CASE(); } while(0)
+
+#define TEST_RESULT				(printf("%s: %u cases, %u failed checks\n", __FILE__, testCases, testFailures), \
+								 (testFailures != 0) ? 1 : 0)
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+static const char *testName;
+static unsigned testCases;
+static unsigned testFailures;
+
+#endif /* __TEST_H */
@@ -0,0 +1,337 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "host.h"
+#include <stdlib.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define SEMAPHORE_COUNT			(8U)
+#define POOL_COUNT				(4U)
+#define POOL_MEMORY_SIZE		(2048U)
+#define QUEUE_COUNT				(4U)
+#define QUEUE_SIZE				(16U)
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief The memory pool, a bit of isUsed for every item
+ */
+typedef struct
+{
+	uint8_t *items;
+	uint32_t count;
+	uint32_t sizeItem;
+	uint32_t isUsed;
+} HOST_poolTypeDef;
+
+/**
+ * @brief The message queue
+ */
+typedef struct
+{
+	uint32_t items[QUEUE_SIZE];
+	uint32_t size;
+	uint32_t head;
+	uint32_t count;
+} HOST_queueTypeDef;
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+DMA_TypeDef hostDma1;
+DMA_TypeDef hostDma2;
+DMA2D_TypeDef hostDma2d;
+RCC_TypeDef hostRcc;
+
+static uint32_t semaphores[SEMAPHORE_COUNT];
+static uint8_t semaphoreCount;
+
+// The blocks are static, so their addresses survive the casts to uint32_t of the messages
+static uint8_t poolMemory[POOL_MEMORY_SIZE] __attribute__((aligned(8)));
+static uint32_t sizePoolMemory;
+static HOST_poolTypeDef pools[POOL_COUNT];
+static uint8_t poolCount;
+
+static HOST_queueTypeDef queues[QUEUE_COUNT];
+static uint8_t queueCount;
+
+static uint32_t sysTick;
+
+//---------------------------------------------------------------------------
+// CMSIS-RTOS
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function creates the semaphore as a counter.
+ * @retval	The semaphore.
+ */
+osSemaphoreId osSemaphoreCreate(const osSemaphoreDef_t *semaphore_def, int32_t count)
+{
+	(void)semaphore_def;
+
+	if(semaphoreCount == SEMAPHORE_COUNT) abort();
+
+	semaphores[semaphoreCount] = (uint32_t)count;
+
+	return (osSemaphoreId)&semaphores[semaphoreCount++];
+}
+
+/**
+ * @brief 	This function takes the semaphore. The tests are single threaded, so the wait for a taken semaphore
+ * 			would never end and the test is stopped instead.
+ * @retval	osOK.
+ */
+int32_t osSemaphoreWait(osSemaphoreId semaphore_id, uint32_t millisec)
+{
+	uint32_t *semaphore = (uint32_t*)semaphore_id;
+
+	(void)millisec;
+
+	if(*semaphore == 0)
+	{
+		printf("host: the wait for a taken semaphore never ends\n");
+		abort();
+	}
+
+	(*semaphore)--;
+
+	return osOK;
+}
+
+osStatus osSemaphoreRelease(osSemaphoreId semaphore_id)
+{
+	(*(uint32_t*)semaphore_id)++;
+
+	return osOK;
+}
+
+/**
+ * @brief 	This function returns the semaphore which the module has created.
+ * @param 	index - The number of the semaphore in the order of creation.
+ * @retval	The semaphore.
+ */
+osSemaphoreId HOST_getSemaphore(uint8_t index)
+{
+	if(index >= semaphoreCount) abort();
+
+	return (osSemaphoreId)&semaphores[index];
+}
+
+uint32_t HOST_getSemaphoreCount(osSemaphoreId semaphore_id)
+{
+	return *(uint32_t*)semaphore_id;
+}
+
+uint32_t osKernelSysTick(void)
+{
+	return sysTick;
+}
+
+osStatus osDelay(uint32_t millisec)
+{
+	sysTick += millisec;
+
+	return osOK;
+}
+
+/**
+ * @brief 	This function creates the pool in the static memory of the host.
+ * @retval	The pool.
+ */
+osPoolId osPoolCreate(const osPoolDef_t *pool_def)
+{
+	HOST_poolTypeDef *pool = &pools[poolCount];
+	uint32_t sizeItem = (pool_def->item_sz + 7U) & ~7U;
+
+	if((poolCount == POOL_COUNT) || (pool_def->pool_sz > 32U) ||
+	   ((sizePoolMemory + pool_def->pool_sz * sizeItem) > POOL_MEMORY_SIZE)) abort();
+
+	pool->items = &poolMemory[sizePoolMemory];
+	pool->count = pool_def->pool_sz;
+	pool->sizeItem = sizeItem;
+	pool->isUsed = 0;
+
+	sizePoolMemory += pool->count * sizeItem;
+	poolCount++;
+
+	return (osPoolId)pool;
+}
+
+void *osPoolAlloc(osPoolId pool_id)
+{
+	HOST_poolTypeDef *pool = (HOST_poolTypeDef*)pool_id;
+
+	for(uint32_t item = 0; item < pool->count; item++)
+	{
+		if(!(pool->isUsed & (1UL << item)))
+		{
+			pool->isUsed |= (1UL << item);
+			return &pool->items[item * pool->sizeItem];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief 	This function returns the block to the pool. The block which isn't taken from the pool stops the test.
+ * @retval	osOK.
+ */
+osStatus osPoolFree(osPoolId pool_id, void *block)
+{
+	HOST_poolTypeDef *pool = (HOST_poolTypeDef*)pool_id;
+	uint32_t item = (uint32_t)((uint8_t*)block - pool->items) / pool->sizeItem;
+
+	if(((uint8_t*)block < pool->items) || (item >= pool->count) || !(pool->isUsed & (1UL << item)))
+	{
+		printf("host: the block isn't taken from the pool\n");
+		abort();
+	}
+
+	pool->isUsed &= ~(1UL << item);
+
+	return osOK;
+}
+
+osMessageQId osMessageCreate(const osMessageQDef_t *queue_def, osThreadId thread_id)
+{
+	(void)thread_id;
+
+	if((queueCount == QUEUE_COUNT) || (queue_def->queue_sz > QUEUE_SIZE)) abort();
+
+	queues[queueCount].size = queue_def->queue_sz;
+
+	return (osMessageQId)&queues[queueCount++];
+}
+
+/**
+ * @brief 	This function puts the message into the queue. The full queue returns at once, as with the zero timeout.
+ * @retval	osOK or osErrorOS when the queue is full.
+ */
+osStatus osMessagePut(osMessageQId queue_id, uint32_t info, uint32_t millisec)
+{
+	HOST_queueTypeDef *queue = (HOST_queueTypeDef*)queue_id;
+
+	(void)millisec;
+
+	if(queue->count == queue->size) return osErrorOS;
+
+	queue->items[(queue->head + queue->count) % QUEUE_SIZE] = info;
+	queue->count++;
+
+	return osOK;
+}
+
+/**
+ * @brief 	This function takes the message from the queue. The empty queue returns osOK without the message,
+ * 			the wait for it would never end.
+ * @retval	The event.
+ */
+osEvent osMessageGet(osMessageQId queue_id, uint32_t millisec)
+{
+	HOST_queueTypeDef *queue = (HOST_queueTypeDef*)queue_id;
+	osEvent event = {0};
+
+	(void)millisec;
+
+	event.status = osOK;
+
+	if(queue->count != 0)
+	{
+		event.status = osEventMessage;
+		event.value.v = queue->items[queue->head];
+		queue->head = (queue->head + 1U) % QUEUE_SIZE;
+		queue->count--;
+	}
+
+	return event;
+}
+
+uint32_t osMessageAvailableSpace(osMessageQId queue_id)
+{
+	HOST_queueTypeDef *queue = (HOST_queueTypeDef*)queue_id;
+
+	return queue->size - queue->count;
+}
+
+/**
+ * @brief 	This function doesn't start the thread, the tests drive the modules themselves.
+ * @retval	NULL.
+ */
+osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument)
+{
+	(void)thread_def;
+	(void)argument;
+
+	return NULL;
+}
+
+osThreadId osThreadGetId(void)
+{
+	return NULL;
+}
+
+int32_t osSignalSet(osThreadId thread_id, int32_t signals)
+{
+	(void)thread_id;
+	(void)signals;
+
+	return 0;
+}
+
+osEvent osSignalWait(int32_t signals, uint32_t millisec)
+{
+	osEvent event = {0};
+
+	(void)signals;
+	(void)millisec;
+
+	event.status = osEventTimeout;
+
+	return event;
+}
+
+//---------------------------------------------------------------------------
+// FreeRTOS
+//---------------------------------------------------------------------------
+void vQueueAddToRegistry(QueueHandle_t xQueue, const char *pcQueueName)
+{
+	(void)xQueue;
+	(void)pcQueueName;
+}
+
+void vTaskSuspendAll(void)
+{
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+	return pdFALSE;
+}
+
+void vPortEnterCritical(void)
+{
+}
+
+void vPortExitCritical(void)
+{
+}
+
+//---------------------------------------------------------------------------
+// Drivers
+//---------------------------------------------------------------------------
+void MISC_NVIC_SetPriority(IRQn_Type IRQn, uint32_t preemptPriority, uint32_t subPriority)
+{
+	(void)IRQn;
+	(void)preemptPriority;
+	(void)subPriority;
+}
+
+void MISC_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	(void)IRQn;
+}
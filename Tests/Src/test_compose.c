@@ -0,0 +1,289 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+#include "test.h"
+#include <string.h>
+
+/* The compositing of the frames. Every rectangle which fits into the frame is filled, copied and blended, the result
+ * is compared with the reference, which works pixel by pixel. The rectangles which compose.c gives to DMA2D are done
+ * by runDma2d from the registers it has programmed, the way RM0090 describes the register-to-memory and
+ * memory-to-memory modes. So the fill of the even lines by the 16-bit ARGB4444 pixels has to give the same frame as
+ * the CPU path.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define MODULES					(16U)
+#define FRAME_PITCH				(MATRIX_HIGH)
+#define FRAME_SIZE				(MODULES * FRAME_PITCH)
+
+#define PATTERN					((uint8_t)0xA5)
+
+#define DMA2D_MODE_M2M			((uint32_t)0x00000000)
+#define DMA2D_MODE_R2M			(DMA2D_CR_MODE)
+#define DMA2D_CM_ARGB4444		((uint32_t)0x04)
+#define DMA2D_CM_L8				((uint32_t)0x05)
+#define DMA2D_PL_POSITION		(16U)
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+
+// The frames are static, so their addresses fit into the DMA2D registers
+static uint8_t frame[FRAME_SIZE];
+static uint8_t source[FRAME_SIZE];
+static uint8_t expected[FRAME_SIZE];
+static uint8_t layer[FRAME_SIZE];
+static uint8_t mask[FRAME_SIZE];
+
+static osSemaphoreId engineFree;
+static uint32_t dma2dRuns;
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function fills the buffer with a pattern which differs in every byte.
+ * @retval	None.
+ */
+static void fillNoise(uint8_t *buffer, uint8_t seed)
+{
+	for(uint16_t index = 0; index < FRAME_SIZE; index++)
+	{
+		buffer[index] = (uint8_t)(index * 37U + seed);
+	}
+}
+
+/**
+ * @brief 	This function runs the DMA2D operation which compose.c has started and raises its interrupt.
+ * @note	The pixel size is 2 bytes for ARGB4444 and 1 byte for L8, the offsets and the line length are in pixels.
+ * @retval	None.
+ */
+static void runDma2d(void)
+{
+	uint32_t pixels = (hostDma2d.NLR >> DMA2D_PL_POSITION) & 0x3FFFU;
+	uint32_t lines = hostDma2d.NLR & 0xFFFFU;
+	uint8_t *output = (uint8_t*)(uintptr_t)hostDma2d.OMAR;
+	const uint8_t *input = (const uint8_t*)(uintptr_t)hostDma2d.FGMAR;
+	uint32_t sizePixel = 0;
+
+	if(!(hostDma2d.CR & DMA2D_CR_START)) return;
+
+	dma2dRuns++;
+
+	if((hostDma2d.CR & DMA2D_CR_MODE) == DMA2D_MODE_R2M)
+	{
+		TEST_EQUAL(hostDma2d.OPFCCR, DMA2D_CM_ARGB4444);
+		sizePixel = 2U;
+
+		for(uint32_t line = 0; line < lines; line++)
+		{
+			for(uint32_t pixel = 0; pixel < pixels; pixel++)
+			{
+				// The colour register is the pixel, little endian
+				*output++ = (uint8_t)hostDma2d.OCOLR;
+				*output++ = (uint8_t)(hostDma2d.OCOLR >> 8);
+			}
+
+			output += hostDma2d.OOR * sizePixel;
+		}
+	} else
+	{
+		TEST_EQUAL(hostDma2d.CR & DMA2D_CR_MODE, DMA2D_MODE_M2M);
+		TEST_EQUAL(hostDma2d.FGPFCCR, DMA2D_CM_L8);
+		sizePixel = 1U;
+
+		for(uint32_t line = 0; line < lines; line++)
+		{
+			for(uint32_t pixel = 0; pixel < pixels; pixel++)
+			{
+				*output++ = *input++;
+			}
+
+			output += hostDma2d.OOR * sizePixel;
+			input += hostDma2d.FGOR * sizePixel;
+		}
+	}
+
+	hostDma2d.CR &= ~DMA2D_CR_START;
+	hostDma2d.ISR |= DMA2D_ISR_TCIF;
+	COMPOSE_IRQHandler();
+	hostDma2d.ISR = 0;
+}
+
+/**
+ * @brief 	This function tells whether compose.c has to give the fill to DMA2D.
+ * @retval	1 - DMA2D, 0 - CPU.
+ */
+static uint8_t isFillByDma2d(const COMPOSE_rectTypeDef *rect)
+{
+	return (((rect->line % 2U) == 0) && ((rect->lines % 2U) == 0) &&
+			(((uint16_t)rect->modules * rect->lines) >= COMPOSE_DMA2D_THRESHOLD)) ? 1U : 0U;
+}
+
+//---------------------------------------------------------------------------
+// Test cases
+//---------------------------------------------------------------------------
+static void fillMatchesReference(void)
+{
+	COMPOSE_rectTypeDef rect;
+	uint32_t runs = 0;
+	uint32_t dma2dFills = 0;
+
+	for(rect.module = 0; rect.module < MODULES; rect.module++)
+	for(rect.modules = 1; (rect.module + rect.modules) <= MODULES; rect.modules++)
+	for(rect.line = 0; rect.line < MATRIX_HIGH; rect.line++)
+	for(rect.lines = 1; (rect.line + rect.lines) <= MATRIX_HIGH; rect.lines++)
+	{
+		fillNoise(frame, rect.lines);
+		memcpy(expected, frame, FRAME_SIZE);
+
+		for(uint8_t module = rect.module; module < (rect.module + rect.modules); module++)
+		for(uint8_t line = rect.line; line < (rect.line + rect.lines); line++)
+		{
+			expected[module * FRAME_PITCH + line] = PATTERN;
+		}
+
+		runs = dma2dRuns;
+
+		COMPOSE_fill(frame, &rect, PATTERN);
+		runDma2d();
+
+		TEST_EQUAL(dma2dRuns - runs, isFillByDma2d(&rect));
+		TEST_CHECK(memcmp(frame, expected, FRAME_SIZE) == 0);
+		TEST_EQUAL(HOST_getSemaphoreCount(engineFree), 1);
+
+		dma2dFills += dma2dRuns - runs;
+	}
+
+	// Both paths have been taken
+	TEST_CHECK(dma2dFills != 0);
+}
+
+static void copyMatchesReference(void)
+{
+	COMPOSE_rectTypeDef rect;
+	uint8_t module = 0;
+	uint8_t line = 0;
+	uint32_t runs = 0;
+
+	fillNoise(source, 0x5AU);
+
+	for(rect.module = 0; rect.module < MODULES; rect.module++)
+	for(rect.modules = 1; (rect.module + rect.modules) <= MODULES; rect.modules++)
+	for(rect.line = 0; rect.line < MATRIX_HIGH; rect.line++)
+	for(rect.lines = 1; (rect.line + rect.lines) <= MATRIX_HIGH; rect.lines++)
+	{
+		// The destination is moved within the frame
+		module = (uint8_t)((rect.module + 3U) % (MODULES - rect.modules + 1U));
+		line = (uint8_t)((rect.line + 1U) % (MATRIX_HIGH - rect.lines + 1U));
+
+		fillNoise(frame, rect.modules);
+		memcpy(expected, frame, FRAME_SIZE);
+
+		for(uint8_t counter = 0; counter < rect.modules; counter++)
+		for(uint8_t index = 0; index < rect.lines; index++)
+		{
+			expected[(module + counter) * FRAME_PITCH + line + index] =
+					source[(rect.module + counter) * FRAME_PITCH + rect.line + index];
+		}
+
+		runs = dma2dRuns;
+
+		COMPOSE_copy(frame, source, &rect, module, line);
+		runDma2d();
+
+		TEST_EQUAL(dma2dRuns - runs, (((uint16_t)rect.modules * rect.lines) >= COMPOSE_DMA2D_THRESHOLD) ? 1 : 0);
+		TEST_CHECK(memcmp(frame, expected, FRAME_SIZE) == 0);
+		TEST_EQUAL(HOST_getSemaphoreCount(engineFree), 1);
+	}
+}
+
+static void blendMatchesReference(void)
+{
+	COMPOSE_rectTypeDef rect;
+	uint16_t index = 0;
+	uint8_t pixel = 0;
+
+	fillNoise(layer, 0x11U);
+	fillNoise(mask, 0x77U);
+
+	for(rect.module = 0; rect.module < MODULES; rect.module++)
+	for(rect.modules = 1; (rect.module + rect.modules) <= MODULES; rect.modules++)
+	for(rect.line = 0; rect.line < MATRIX_HIGH; rect.line++)
+	for(rect.lines = 1; (rect.line + rect.lines) <= MATRIX_HIGH; rect.lines++)
+	{
+		// Without the mask the lit pixels are drawn over the frame
+		fillNoise(frame, rect.line);
+		memcpy(expected, frame, FRAME_SIZE);
+
+		index = 0;
+		for(uint8_t module = rect.module; module < (rect.module + rect.modules); module++)
+		for(uint8_t line = rect.line; line < (rect.line + rect.lines); line++)
+		{
+			expected[module * FRAME_PITCH + line] |= layer[index++];
+		}
+
+		COMPOSE_blend(frame, &rect, layer, NULL);
+		TEST_CHECK(memcmp(frame, expected, FRAME_SIZE) == 0);
+
+		// With the mask every pixel comes either from the layer or from the frame
+		fillNoise(frame, rect.line);
+		memcpy(expected, frame, FRAME_SIZE);
+
+		index = 0;
+		for(uint8_t module = rect.module; module < (rect.module + rect.modules); module++)
+		for(uint8_t line = rect.line; line < (rect.line + rect.lines); line++, index++)
+		{
+			pixel = expected[module * FRAME_PITCH + line];
+			for(uint8_t bit = 0; bit < 8U; bit++)
+			{
+				if(mask[index] & (1U << bit))
+				{
+					pixel = (uint8_t)((pixel & ~(1U << bit)) | (layer[index] & (1U << bit)));
+				}
+			}
+			expected[module * FRAME_PITCH + line] = pixel;
+		}
+
+		COMPOSE_blend(frame, &rect, layer, mask);
+		TEST_CHECK(memcmp(frame, expected, FRAME_SIZE) == 0);
+		TEST_EQUAL(HOST_getSemaphoreCount(engineFree), 1);
+	}
+}
+
+static void fillOfOddLinesStaysOnCpu(void)
+{
+	// The widest rectangles which DMA2D can't fill because of the 16-bit pixels
+	COMPOSE_rectTypeDef oddLine = {0, 1, MODULES, 6};
+	COMPOSE_rectTypeDef oddLines = {0, 0, MODULES, 7};
+	uint32_t runs = dma2dRuns;
+
+	COMPOSE_fill(frame, &oddLine, PATTERN);
+	runDma2d();
+	COMPOSE_fill(frame, &oddLines, PATTERN);
+	runDma2d();
+
+	TEST_EQUAL(dma2dRuns, runs);
+}
+
+//---------------------------------------------------------------------------
+// Main
+//---------------------------------------------------------------------------
+int main(void)
+{
+	COMPOSE_freeRtosInit();
+
+	// The engine of compose.c is free while its semaphore is
+	engineFree = HOST_getSemaphore(0);
+
+	TEST_RUN(fillMatchesReference);
+	TEST_RUN(copyMatchesReference);
+	TEST_RUN(blendMatchesReference);
+	TEST_RUN(fillOfOddLinesStaysOnCpu);
+
+	return TEST_RESULT;
+}
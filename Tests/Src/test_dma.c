@@ -0,0 +1,170 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+#include "test.h"
+#include <string.h>
+
+/* The double buffer mode of the DMA driver. The stream is a structure in memory, runStream plays the hardware:
+ * NDTR counts the items of the current buffer down, at 0 CT switches to the other buffer and NDTR is reloaded.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define ITEMS					(32U)
+#define GUARD					(2U)
+
+#define MEMORY_0				((uint32_t)0x20000000)
+#define MEMORY_1				((uint32_t)0x20000100)
+#define MEMORY_NEW				((uint32_t)0x20000200)
+#define PERIPHERAL				((uint32_t)0x40011004)
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+
+// The first stream of its controller: the address decides which flags DMA_clearFlags writes
+static DMA_Stream_TypeDef stream __attribute__((aligned(256)));
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function starts the stream the way a driver does it.
+ * @retval	None.
+ */
+static void startStream(void)
+{
+	memset(&stream, 0, sizeof(stream));
+	memset(&hostDma1, 0, sizeof(hostDma1));
+
+	stream.CR = DMA_SxCR_DBM | DMA_SxCR_CIRC;
+	DMA_startDoubleBuffer(&stream, PERIPHERAL, MEMORY_0, MEMORY_1, ITEMS);
+}
+
+/**
+ * @brief 	This function moves the stream by the items, it switches the buffers at the end of every one.
+ * @retval	None.
+ */
+static void runStream(uint32_t items)
+{
+	while(items-- != 0)
+	{
+		if(--stream.NDTR == 0)
+		{
+			stream.CR ^= DMA_SxCR_CT;
+			stream.NDTR = ITEMS;
+		}
+	}
+}
+
+/**
+ * @brief 	This function returns the address of the buffer the stream is working with.
+ * @retval	The address.
+ */
+static uint32_t getCurrentBuffer(void)
+{
+	return (stream.CR & DMA_SxCR_CT) ? stream.M1AR : stream.M0AR;
+}
+
+//---------------------------------------------------------------------------
+// Test cases
+//---------------------------------------------------------------------------
+static void startProgramsBothTargets(void)
+{
+	startStream();
+
+	TEST_EQUAL(stream.PAR, PERIPHERAL);
+	TEST_EQUAL(stream.M0AR, MEMORY_0);
+	TEST_EQUAL(stream.M1AR, MEMORY_1);
+	TEST_EQUAL(stream.NDTR, ITEMS);
+	TEST_CHECK(stream.CR & DMA_SxCR_EN);
+	TEST_EQUAL(DMA_getCurrentTarget(&stream), 0);
+	TEST_EQUAL(hostDma1.LIFCR, DMA_FLAG_ALL);
+}
+
+static void currentTargetFollowsSwitch(void)
+{
+	startStream();
+
+	runStream(ITEMS - 1U);
+	TEST_EQUAL(DMA_getCurrentTarget(&stream), 0);
+
+	runStream(1U);
+	TEST_EQUAL(DMA_getCurrentTarget(&stream), 1);
+
+	runStream(ITEMS);
+	TEST_EQUAL(DMA_getCurrentTarget(&stream), 0);
+}
+
+static void idleBufferIsReplaced(void)
+{
+	startStream();
+
+	TEST_EQUAL(DMA_setIdleBuffer(&stream, MEMORY_NEW, GUARD), STATUS_OK);
+	TEST_EQUAL(stream.M0AR, MEMORY_0);
+	TEST_EQUAL(stream.M1AR, MEMORY_NEW);
+
+	runStream(ITEMS);
+	TEST_EQUAL(getCurrentBuffer(), MEMORY_NEW);
+
+	TEST_EQUAL(DMA_setIdleBuffer(&stream, MEMORY_1, GUARD), STATUS_OK);
+	TEST_EQUAL(stream.M0AR, MEMORY_1);
+	TEST_EQUAL(stream.M1AR, MEMORY_NEW);
+}
+
+static void guardKeepsSwitchingBuffer(void)
+{
+	startStream();
+
+	runStream(ITEMS - GUARD - 1U);
+	TEST_EQUAL(DMA_setIdleBuffer(&stream, MEMORY_NEW, GUARD), STATUS_OK);
+
+	startStream();
+
+	runStream(ITEMS - GUARD);
+	TEST_EQUAL(DMA_setIdleBuffer(&stream, MEMORY_NEW, GUARD), STATUS_BUSY);
+	TEST_EQUAL(stream.M1AR, MEMORY_1);
+
+	// The next try after the switch takes the new buffer
+	runStream(GUARD);
+	TEST_EQUAL(DMA_setIdleBuffer(&stream, MEMORY_NEW, GUARD), STATUS_OK);
+	TEST_EQUAL(stream.M0AR, MEMORY_NEW);
+}
+
+static void currentTargetIsNeverWritten(void)
+{
+	uint32_t current = 0;
+	uint32_t replaced = 0;
+
+	startStream();
+
+	// A replacement at every item of several buffers
+	for(uint32_t item = 0; item < 4U * ITEMS; item++)
+	{
+		current = getCurrentBuffer();
+
+		if(DMA_setIdleBuffer(&stream, MEMORY_NEW + item, GUARD) == STATUS_OK) replaced++;
+
+		TEST_EQUAL(getCurrentBuffer(), current);
+		runStream(1U);
+	}
+
+	TEST_EQUAL(replaced, 4U * (ITEMS - GUARD));
+}
+
+//---------------------------------------------------------------------------
+// Main
+//---------------------------------------------------------------------------
+int main(void)
+{
+	TEST_RUN(startProgramsBothTargets);
+	TEST_RUN(currentTargetFollowsSwitch);
+	TEST_RUN(idleBufferIsReplaced);
+	TEST_RUN(guardKeepsSwitchingBuffer);
+	TEST_RUN(currentTargetIsNeverWritten);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,253 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+#include "test.h"
+
+/* The heap statistics. heap.c is built with heap_4.c, so the trace hooks are called by the real allocator, the cases
+ * which need exact sizes call the hooks themselves. The state of heap.c lives through all the cases, so they
+ * compare the counters before and after.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define BLOCK_SIZE				(1000U)
+#define BLOCK_COUNT				(8U)
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+
+// The addresses which the hooks are called with, they are never dereferenced
+static uint8_t fakeBlocks[HEAP_TRACK_MAX + 4U];
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function returns the statistics of the tag.
+ * @retval	The statistics.
+ */
+static HEAP_tagTypeDef getTag(HEAP_tag tag)
+{
+	HEAP_tagTypeDef statistics = {0};
+
+	TEST_EQUAL(HEAP_getTag(tag, &statistics), 1);
+
+	return statistics;
+}
+
+//---------------------------------------------------------------------------
+// Test cases
+//---------------------------------------------------------------------------
+static void freeIsChargedToAllocatingTag(void)
+{
+	HEAP_tagTypeDef before = getTag(HEAP_TAG_COMPOSE);
+	HEAP_tagTypeDef after;
+
+	HEAP_setTag(HEAP_TAG_COMPOSE);
+	HEAP_traceMalloc(&fakeBlocks[0], 100U);
+
+	after = getTag(HEAP_TAG_COMPOSE);
+	TEST_EQUAL(after.allocations - before.allocations, 1);
+	TEST_EQUAL(after.bytes - before.bytes, 100);
+
+	// Another module frees it, heap_4 reports the size of the whole free block
+	HEAP_setTag(HEAP_TAG_LOG);
+	HEAP_traceFree(&fakeBlocks[0], 128U);
+
+	after = getTag(HEAP_TAG_COMPOSE);
+	TEST_EQUAL(after.frees - before.frees, 1);
+	TEST_EQUAL(after.bytes, before.bytes);
+	TEST_EQUAL(getTag(HEAP_TAG_LOG).frees, 0);
+
+	HEAP_setTag(HEAP_TAG_KERNEL);
+}
+
+static void failureIsCountedWithoutBlock(void)
+{
+	HEAP_tagTypeDef before = getTag(HEAP_TAG_UART);
+	HEAP_tagTypeDef after;
+
+	HEAP_setTag(HEAP_TAG_UART);
+	HEAP_traceMalloc(NULL, 64U);
+	HEAP_setTag(HEAP_TAG_KERNEL);
+
+	after = getTag(HEAP_TAG_UART);
+	TEST_EQUAL(after.failures - before.failures, 1);
+	TEST_EQUAL(after.allocations, before.allocations);
+	TEST_EQUAL(after.bytes, before.bytes);
+}
+
+static void mallocChargesGivenTag(void)
+{
+	HEAP_tagTypeDef before = getTag(HEAP_TAG_MEMDMA);
+	HEAP_tagTypeDef kernelBefore = getTag(HEAP_TAG_KERNEL);
+	void *block = NULL;
+
+	HEAP_setTag(HEAP_TAG_MONITOR);
+
+	block = HEAP_malloc(200U, HEAP_TAG_MEMDMA);
+	TEST_CHECK(block != NULL);
+	TEST_EQUAL(getTag(HEAP_TAG_MEMDMA).allocations - before.allocations, 1);
+	TEST_CHECK(getTag(HEAP_TAG_MEMDMA).bytes - before.bytes >= 200U);
+
+	// The tag of the caller is back for the blocks taken without HEAP_malloc
+	vPortFree(pvPortMalloc(16U));
+	TEST_EQUAL(getTag(HEAP_TAG_MONITOR).allocations, 1);
+
+	vPortFree(block);
+	TEST_EQUAL(getTag(HEAP_TAG_MEMDMA).bytes, before.bytes);
+	TEST_EQUAL(getTag(HEAP_TAG_MEMDMA).frees - before.frees, 1);
+	TEST_EQUAL(getTag(HEAP_TAG_KERNEL).allocations, kernelBefore.allocations);
+
+	HEAP_setTag(HEAP_TAG_KERNEL);
+}
+
+static void overflowIsUntracked(void)
+{
+	HEAP_statsTypeDef stats;
+	HEAP_tagTypeDef before = getTag(HEAP_TAG_HEARTBEAT);
+	HEAP_tagTypeDef after;
+	uint32_t untracked = 0;
+
+	HEAP_getStats(&stats);
+	untracked = stats.untracked;
+
+	// No block of heap_4 is alive, so the last 4 don't fit
+	HEAP_setTag(HEAP_TAG_HEARTBEAT);
+	for(uint8_t block = 0; block < sizeof(fakeBlocks); block++)
+	{
+		HEAP_traceMalloc(&fakeBlocks[block], 10U);
+	}
+
+	HEAP_getStats(&stats);
+	TEST_EQUAL(stats.untracked - untracked, 4);
+
+	// The free of the untracked block is lost, the tracked ones come back
+	HEAP_traceFree(&fakeBlocks[sizeof(fakeBlocks) - 1U], 10U);
+	after = getTag(HEAP_TAG_HEARTBEAT);
+	TEST_EQUAL(after.frees, before.frees);
+
+	for(uint8_t block = 0; block < sizeof(fakeBlocks); block++)
+	{
+		HEAP_traceFree(&fakeBlocks[block], 10U);
+	}
+
+	after = getTag(HEAP_TAG_HEARTBEAT);
+	TEST_EQUAL(after.allocations - before.allocations, sizeof(fakeBlocks));
+	TEST_EQUAL(after.frees - before.frees + (stats.untracked - untracked), sizeof(fakeBlocks));
+
+	// The bytes of the untracked blocks stay charged, so the leak report overstates by them
+	TEST_EQUAL(after.bytes - before.bytes, (stats.untracked - untracked) * 10U);
+
+	// A freed record takes the next block again
+	HEAP_getStats(&stats);
+	untracked = stats.untracked;
+	HEAP_traceMalloc(&fakeBlocks[0], 10U);
+	HEAP_traceFree(&fakeBlocks[0], 10U);
+	HEAP_getStats(&stats);
+	TEST_EQUAL(stats.untracked, untracked);
+
+	HEAP_setTag(HEAP_TAG_KERNEL);
+}
+
+static void sizeClassEdges(void)
+{
+	// Class k counts 2^(k-1)..2^k - 1 bytes, the last class all the bigger blocks
+	static const struct
+	{
+		uint32_t size;
+		uint8_t sizeClass;
+	} edges[] =
+	{
+		{1U, 1U}, {2U, 2U}, {3U, 2U}, {4U, 3U}, {7U, 3U}, {8U, 4U}, {2047U, 11U}, {2048U, 12U}, {4095U, 12U},
+		{4096U, 13U}, {8192U, 13U}, {configTOTAL_HEAP_SIZE, 13U}
+	};
+	HEAP_statsTypeDef before;
+	HEAP_statsTypeDef after;
+
+	for(uint8_t edge = 0; edge < (sizeof(edges) / sizeof(edges[0])); edge++)
+	{
+		HEAP_getStats(&before);
+		HEAP_traceMalloc(&fakeBlocks[0], edges[edge].size);
+		HEAP_traceFree(&fakeBlocks[0], edges[edge].size);
+		HEAP_getStats(&after);
+
+		for(uint8_t sizeClass = 0; sizeClass < HEAP_SIZE_CLASS_COUNT; sizeClass++)
+		{
+			TEST_EQUAL(after.sizeClasses[sizeClass] - before.sizeClasses[sizeClass],
+					   (sizeClass == edges[edge].sizeClass) ? 1 : 0);
+		}
+	}
+}
+
+static void fragmentationIsShareOutsideLargestBlock(void)
+{
+	HEAP_statsTypeDef stats;
+	void *blocks[BLOCK_COUNT];
+	size_t sizeTail = 0;
+	size_t sizeBlock = 0;
+	size_t sizeFree = 0;
+	size_t sizeLargest = 0;
+
+	// heap_4 sets the heap up at the first allocation, then the free space is one block
+	vPortFree(pvPortMalloc(BLOCK_SIZE));
+
+	HEAP_getStats(&stats);
+	TEST_EQUAL(stats.freeBlocks, 1);
+	TEST_EQUAL(stats.fragmentation, 0);
+
+	for(uint8_t block = 0; block < BLOCK_COUNT; block++)
+	{
+		blocks[block] = pvPortMalloc(BLOCK_SIZE);
+		TEST_CHECK(blocks[block] != NULL);
+	}
+
+	sizeTail = xPortGetFreeHeapSize();
+
+	// Every other block is freed, the last one keeps the holes apart from the tail
+	for(uint8_t block = 0; block < BLOCK_COUNT; block += 2U)
+	{
+		vPortFree(blocks[block]);
+	}
+
+	sizeBlock = (xPortGetFreeHeapSize() - sizeTail) / (BLOCK_COUNT / 2U);
+	sizeFree = sizeTail + sizeBlock * (BLOCK_COUNT / 2U);
+	sizeLargest = (sizeTail > sizeBlock) ? sizeTail : sizeBlock;
+
+	HEAP_getStats(&stats);
+	TEST_EQUAL(stats.freeBytes, sizeFree);
+	TEST_EQUAL(stats.freeBlocks, BLOCK_COUNT / 2U + 1U);
+	TEST_EQUAL(stats.largestFreeBlock, sizeLargest);
+	TEST_EQUAL(stats.fragmentation, 1000U - (sizeLargest * 1000U) / sizeFree);
+	TEST_CHECK(stats.fragmentation > 0);
+	TEST_CHECK(stats.minFreeBytes <= sizeTail);
+
+	// The holes merge back into one block
+	for(uint8_t block = 1; block < BLOCK_COUNT; block += 2U)
+	{
+		vPortFree(blocks[block]);
+	}
+
+	HEAP_getStats(&stats);
+	TEST_EQUAL(stats.freeBlocks, 1);
+	TEST_EQUAL(stats.fragmentation, 0);
+}
+
+//---------------------------------------------------------------------------
+// Main
+//---------------------------------------------------------------------------
+int main(void)
+{
+	TEST_RUN(fragmentationIsShareOutsideLargestBlock);
+	TEST_RUN(freeIsChargedToAllocatingTag);
+	TEST_RUN(failureIsCountedWithoutBlock);
+	TEST_RUN(mallocChargesGivenTag);
+	TEST_RUN(overflowIsUntracked);
+	TEST_RUN(sizeClassEdges);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,174 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "textcodec.h"
+#include "test.h"
+#include <string.h>
+
+/* The decoder of the packed text. The playlist of the tools is packed by Tools/textcodec.py, the host encoder, into
+ * Build/textcodec_vectors.h, and TEXTCODEC_decode has to give every line back. So the dictionaries of both sides
+ * are the same and the encoder uses the codes the way the decoder reads them. The other cases are the streams which
+ * the encoder never makes.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define REQUEST_MAX_COUNT		(8U)
+#define TEXT_MAX_SIZE			(4096U)
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief The request of PROTOCOL_CMD_SET_MESSAGE_PACKED: the flags and the codes
+ */
+typedef struct
+{
+	const char *payload;
+	uint16_t size;
+} TEXTCODEC_requestTypeDef;
+
+/**
+ * @brief The line of the playlist and the requests which show it
+ */
+typedef struct
+{
+	const char *text;
+	uint16_t sizeText;
+	TEXTCODEC_requestTypeDef requests[REQUEST_MAX_COUNT];
+	uint8_t requestCount;
+} TEXTCODEC_vectorTypeDef;
+
+#include "textcodec_vectors.h"
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+static uint8_t text[TEXT_MAX_SIZE];
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function decodes the codes after the text decoded before.
+ * @retval	The size of the text.
+ */
+static uint16_t decode(const void *codes, uint16_t size, uint16_t sizeText, uint16_t sizeMax)
+{
+	UART_messageTypeDef message = {0};
+
+	message.buffer = (const uint8_t*)codes;
+	message.sizeBuffer = size;
+	message.sizeMessage = size;
+	message.flags = UART_MESSAGE_PACKED;
+
+	return TEXTCODEC_decode(&message, text, sizeText, sizeMax);
+}
+
+//---------------------------------------------------------------------------
+// Test cases
+//---------------------------------------------------------------------------
+static void playlistRoundTrip(void)
+{
+	const TEXTCODEC_vectorTypeDef *vector = NULL;
+	uint32_t sizePlain = 0;
+	uint32_t sizePacked = 0;
+	uint16_t sizeText = 0;
+
+	for(uint8_t line = 0; line < TEXTCODEC_VECTOR_COUNT; line++)
+	{
+		vector = &vectors[line];
+		sizeText = 0;
+
+		for(uint8_t request = 0; request < vector->requestCount; request++)
+		{
+			// The flags of the request go to the protocol, the codes to the decoder
+			sizeText = decode(&vector->requests[request].payload[1], vector->requests[request].size - 1U, sizeText,
+							  TEXT_MAX_SIZE);
+			sizePacked += vector->requests[request].size - 1U;
+		}
+
+		TEST_EQUAL(sizeText, vector->sizeText);
+		TEST_CHECK(memcmp(text, vector->text, vector->sizeText) == 0);
+
+		sizePlain += vector->sizeText;
+	}
+
+	TEST_CHECK(sizePacked < sizePlain);
+}
+
+static void copyOverlapsItself(void)
+{
+	static const uint8_t codes[] = {'-', TEXTCODEC_COPY_BASE + 19U - TEXTCODEC_COPY_MIN_SIZE, 0, '|'};
+
+	TEST_EQUAL(decode(codes, sizeof(codes), 0, TEXT_MAX_SIZE), 21);
+	TEST_CHECK(memcmp(text, "--------------------|", 21) == 0);
+}
+
+static void copyReachesPreviousRequest(void)
+{
+	static const uint8_t first[] = {'E', 'U', 'R', TEXTCODEC_DICTIONARY_BASE + 19U};
+	static const uint8_t second[] = {TEXTCODEC_COPY_BASE, 5};
+	uint16_t sizeText = 0;
+
+	sizeText = decode(first, sizeof(first), sizeText, TEXT_MAX_SIZE);
+	sizeText = decode(second, sizeof(second), sizeText, TEXT_MAX_SIZE);
+
+	TEST_EQUAL(sizeText, 9);
+	TEST_CHECK(memcmp(text, "EUR | EUR", 9) == 0);
+}
+
+static void brokenCodesAreSkipped(void)
+{
+	// The copy from before the text, the entry beyond the dictionary, the copy without the distance
+	static const uint8_t codes[] = {'A', TEXTCODEC_COPY_BASE, 4, 'B', TEXTCODEC_COPY_BASE - 1U, 'C', TEXTCODEC_COPY_BASE};
+
+	TEST_EQUAL(decode(codes, sizeof(codes), 0, TEXT_MAX_SIZE), 3);
+	TEST_CHECK(memcmp(text, "ABC", 3) == 0);
+}
+
+static void textIsCutAtSizeMax(void)
+{
+	static const uint8_t entry[] = {'x', TEXTCODEC_DICTIONARY_BASE};
+	static const uint8_t copy[] = {'x', 'y', TEXTCODEC_COPY_BASE + 10U, 1};
+
+	memset(text, 0, sizeof(text));
+
+	// " USD" is cut after 2 symbols, the copy after 3
+	TEST_EQUAL(decode(entry, sizeof(entry), 0, 3), 3);
+	TEST_CHECK(memcmp(text, "x U", 3) == 0);
+
+	TEST_EQUAL(decode(copy, sizeof(copy), 0, 5), 5);
+	TEST_CHECK(memcmp(text, "xyxyx", 5) == 0);
+	TEST_EQUAL(text[5], 0);
+}
+
+//---------------------------------------------------------------------------
+// The other modules
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function reads the symbol of the message, the messages of the test never wrap.
+ * @retval	The symbol.
+ */
+uint8_t UART_getSymbol(const UART_messageTypeDef *message, uint16_t index)
+{
+	return message->buffer[message->offset + index];
+}
+
+//---------------------------------------------------------------------------
+// Main
+//---------------------------------------------------------------------------
+int main(void)
+{
+	TEST_RUN(playlistRoundTrip);
+	TEST_RUN(copyOverlapsItself);
+	TEST_RUN(copyReachesPreviousRequest);
+	TEST_RUN(brokenCodesAreSkipped);
+	TEST_RUN(textIsCutAtSizeMax);
+
+	return TEST_RESULT;
+}
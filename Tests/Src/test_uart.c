@@ -0,0 +1,457 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The module is included, so the test runs its parser the way idleIRQTask does
+#include "uart.c"
+
+/* The receive path of the U(S)ART. The test plays the host and the RX DMA: the host sends bursts of lines and
+ * binary frames, the DMA writes them into the circular buffer, counts NDTR down and raises the events of the
+ * driver: half transfer and transfer complete in the middle of the burst, IDLE at its end. Every event runs the
+ * parser, and the display takes the messages from the queue right after it. Every symbol sent is kept in stream,
+ * so the symbol the message starts with is stream[message->mark].
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define SOAK_SIZE				((uint32_t)1 << 20)		// 1024 laps of the RX buffer
+#define LAG_SIZE				((uint32_t)1 << 18)
+#define BURST_MAX_SIZE			(2U * UART_MESSAGE_QUEUE_SIZE * LINE_MAX_SIZE)
+#define STREAM_SIZE				(SOAK_SIZE + LAG_SIZE + BURST_MAX_SIZE)
+
+#define LINE_MAX_SIZE			(3U * MESSAGE_CHUNK_SIZE)
+#define DISPLAY_LAG				(3U)		// The parser runs the display misses in the late display case
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+static DMA_Stream_TypeDef rxStream;
+static USH_USART_errorsTypeDef errors;
+
+static uint8_t stream[STREAM_SIZE];
+static uint32_t sizeStream;
+static uint32_t sent;			// The symbols which the DMA has written
+static uint32_t seed = 0x2545F491;
+
+// The lines and the frames (2 bytes of the size and the bytes) as the host sends them and as they come out
+static uint8_t expectedText[STREAM_SIZE];
+static uint8_t receivedText[STREAM_SIZE];
+static uint32_t sizeExpectedText;
+static uint32_t sizeReceivedText;
+static uint32_t expectedLines;
+static uint32_t receivedLines;
+static uint8_t isLineOpen;
+
+static uint8_t expectedFrames[STREAM_SIZE];
+static uint8_t receivedFrames[STREAM_SIZE];
+static uint32_t sizeExpectedFrames;
+static uint32_t sizeReceivedFrames;
+static uint32_t expectedFrameCount;
+
+static uint8_t isAssembling;
+static uint8_t displayLag;
+static uint8_t parserRuns;
+static uint32_t intactMessages;
+static uint32_t overwrittenCopies;
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function returns the next pseudo-random number, xorshift32.
+ * @param 	range - The number of the values.
+ * @retval	The number from 0 to range - 1.
+ */
+static uint32_t getRandom(uint32_t range)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed % range;
+}
+
+/**
+ * @brief 	This function appends the symbol to the stream which the host sends.
+ * @retval	None.
+ */
+static void put(uint8_t symbol)
+{
+	if(sizeStream == STREAM_SIZE) abort();
+
+	stream[sizeStream++] = symbol;
+}
+
+/**
+ * @brief 	This function sends the line of the printable symbols, sometimes after an empty line.
+ * @note	The parser passes the first delimiter to the display.
+ * @param 	size - The number of the symbols without the delimiter.
+ * @retval	None.
+ */
+static void putLine(uint16_t size)
+{
+	uint8_t symbol = 0;
+
+	if(getRandom(8U) == 0) put('\n');
+
+	for(uint16_t index = 0; index < size; index++)
+	{
+		symbol = (uint8_t)(' ' + getRandom('~' - ' ' + 1U));
+		put(symbol);
+		expectedText[sizeExpectedText++] = symbol;
+	}
+
+	put('\r');
+	if(getRandom(2U) == 0) put('\n');
+
+	expectedText[sizeExpectedText++] = '\r';
+	expectedLines++;
+}
+
+/**
+ * @brief 	This function sends the frame of the random bytes, sometimes after a repeated delimiter.
+ * @retval	None.
+ */
+static void putFrame(void)
+{
+	uint16_t size = (uint16_t)(1U + getRandom(PROTOCOL_FRAME_MAX_SIZE));
+
+	if(getRandom(4U) == 0) put(PROTOCOL_FRAME_DELIMITER);
+	put(PROTOCOL_FRAME_DELIMITER);
+
+	expectedFrames[sizeExpectedFrames++] = (uint8_t)(size >> 8);
+	expectedFrames[sizeExpectedFrames++] = (uint8_t)size;
+
+	for(uint16_t index = 0; index < size; index++)
+	{
+		expectedFrames[sizeExpectedFrames] = (uint8_t)(1U + getRandom(255U));
+		put(expectedFrames[sizeExpectedFrames++]);
+	}
+
+	put(PROTOCOL_FRAME_DELIMITER);
+	expectedFrameCount++;
+}
+
+/**
+ * @brief 	This function renders the messages in the queue the way LedMatrix.c does: the message is copied,
+ * 			then checked. The check has to tell exactly whether the DMA has overwritten the first symbol.
+ * @retval	None.
+ */
+static void render(void)
+{
+	static uint8_t copy[RX_BUFFER_SIZE];
+	UART_messageTypeDef *message = NULL;
+	osEvent event = osMessageGet(fromUartToMatrixHandle, 0);
+	uint8_t isIntact = 0;
+
+	for(; event.status == osEventMessage; event = osMessageGet(fromUartToMatrixHandle, 0))
+	{
+		message = (UART_messageTypeDef*)event.value.p;
+
+		for(uint16_t index = 0; index < message->sizeMessage; index++)
+		{
+			copy[index] = UART_getSymbol(message, index);
+		}
+
+		isIntact = UART_checkMessage(message);
+
+		if(message->buffer == rxBuffer)
+		{
+			TEST_CHECK(message->mark < sent);
+			TEST_EQUAL(isIntact, (sent - message->mark) <= RX_BUFFER_SIZE);
+
+			if(isIntact && (message->mark < sent))
+			{
+				TEST_CHECK(memcmp(copy, &stream[message->mark], message->sizeMessage) == 0);
+				intactMessages++;
+			} else
+			{
+				overwrittenCopies++;
+			}
+		}
+
+		if(isAssembling)
+		{
+			TEST_CHECK(isIntact);
+			TEST_EQUAL(isLineOpen, (message->flags & UART_MESSAGE_FIRST_CHUNK) ? 0 : 1);
+
+			memcpy(&receivedText[sizeReceivedText], copy, message->sizeMessage);
+			sizeReceivedText += message->sizeMessage;
+
+			isLineOpen = (message->flags & UART_MESSAGE_LAST_CHUNK) ? 0 : 1;
+			if(!isLineOpen) receivedLines++;
+		}
+
+		UART_releaseMessage(message);
+	}
+}
+
+/**
+ * @brief 	This function runs the parser for every event, as the loop of idleIRQTask does, then the display.
+ * @retval	None.
+ */
+static void runParser(void)
+{
+	while(HOST_getSemaphoreCount(idleIRQHandle) != 0)
+	{
+		osSemaphoreWait(idleIRQHandle, osWaitForever);
+		messageCapture(USED_UART, rxBuffer, sizeof(rxBuffer));
+	}
+
+	if(++parserRuns > displayLag)
+	{
+		render();
+		parserRuns = 0;
+	}
+}
+
+/**
+ * @brief 	This function writes the symbols of the stream into the RX buffer the way the DMA does.
+ * @note	NDTR is reloaded in the circular mode when the buffer is full. The line goes idle after the burst.
+ * @param 	size - The number of the symbols.
+ * @retval	None.
+ */
+static void receive(uint32_t size)
+{
+	uint16_t position = 0;
+
+	while(size-- != 0)
+	{
+		position = (uint16_t)((sent % RX_BUFFER_SIZE) + 1U);
+		rxBuffer[position - 1U] = stream[sent++];
+		rxStream.NDTR = RX_BUFFER_SIZE - (position % RX_BUFFER_SIZE);
+
+		if(position == (RX_BUFFER_SIZE / 2U))
+		{
+			USART_rxHalfCompleteCallback(USED_UART);
+			runParser();
+
+		} else if(position == RX_BUFFER_SIZE)
+		{
+			USART_rxCompleteCallback(USED_UART);
+			runParser();
+		}
+	}
+
+	USART_idleCallback(USED_UART);
+	runParser();
+}
+
+//---------------------------------------------------------------------------
+// Test cases
+//---------------------------------------------------------------------------
+static void soakLosesNothing(void)
+{
+	const UART_rxStatisticsTypeDef *statistics = UART_getRxStatistics();
+	uint32_t credits = 0;
+	uint16_t sizeLine = 0;
+
+	isAssembling = 1;
+
+	while(sizeStream < SOAK_SIZE)
+	{
+		// The host sends as many chunks as the display has credits for, the frames in between are free
+		credits = UART_getCredits();
+		TEST_EQUAL(credits, UART_MESSAGE_QUEUE_SIZE);
+
+		do
+		{
+			if(getRandom(4U) == 0)
+			{
+				putFrame();
+				continue;
+			}
+
+			sizeLine = (uint16_t)(1U + getRandom(LINE_MAX_SIZE));
+			if((sizeLine / MESSAGE_CHUNK_SIZE + 1U) > credits) break;
+
+			putLine(sizeLine);
+			credits -= sizeLine / MESSAGE_CHUNK_SIZE + 1U;
+
+		} while((getRandom(8U) != 0) && ((sizeStream - sent) < (BURST_MAX_SIZE / 2U)));
+
+		receive(sizeStream - sent);
+	}
+
+	TEST_EQUAL(receivedLines, expectedLines);
+	TEST_EQUAL(sizeReceivedText, sizeExpectedText);
+	TEST_CHECK(memcmp(receivedText, expectedText, sizeExpectedText) == 0);
+	TEST_CHECK(!isLineOpen);
+
+	TEST_EQUAL(statistics->receivedFrames, expectedFrameCount);
+	TEST_EQUAL(sizeReceivedFrames, sizeExpectedFrames);
+	TEST_CHECK(memcmp(receivedFrames, expectedFrames, sizeExpectedFrames) == 0);
+
+	TEST_EQUAL(statistics->droppedLines, 0);
+	TEST_EQUAL(statistics->droppedFrames, 0);
+	TEST_EQUAL(statistics->droppedMessages, 0);
+	TEST_EQUAL(statistics->overwrittenMessages, 0);
+	TEST_EQUAL(overwrittenCopies, 0);
+	TEST_CHECK(expectedLines > 1000U);
+
+	isAssembling = 0;
+}
+
+static void lateDisplayIsCaught(void)
+{
+	const UART_rxStatisticsTypeDef *statistics = UART_getRxStatistics();
+	uint32_t overwritten = statistics->overwrittenMessages;
+	uint32_t intact = intactMessages;
+
+	// The host doesn't follow the credits and the display misses the parser runs
+	displayLag = DISPLAY_LAG;
+
+	while(sizeStream < (SOAK_SIZE + LAG_SIZE))
+	{
+		for(uint8_t item = (uint8_t)getRandom(8U); item != 0; item--)
+		{
+			if(getRandom(4U) == 0)
+			{
+				putFrame();
+			} else
+			{
+				putLine((uint16_t)(1U + getRandom(LINE_MAX_SIZE)));
+			}
+		}
+
+		receive(sizeStream - sent);
+	}
+
+	displayLag = 0;
+	render();
+
+	// Both kinds are met and every overwritten message is counted
+	TEST_EQUAL(statistics->overwrittenMessages - overwritten, overwrittenCopies);
+	TEST_CHECK(overwrittenCopies != 0);
+	TEST_CHECK(intactMessages != intact);
+	TEST_CHECK(statistics->droppedMessages != 0);
+}
+
+//---------------------------------------------------------------------------
+// The other modules
+//---------------------------------------------------------------------------
+void USART_init(USH_USART_initTypeDef *initStructure)
+{
+	(void)initStructure;
+}
+
+USH_peripheryStatus USART_setBaudRate(USART_TypeDef* usart, uint32_t baudrate)
+{
+	(void)usart;
+	(void)baudrate;
+
+	return STATUS_OK;
+}
+
+uint32_t USART_getMaxBaudRate(USART_TypeDef* usart)
+{
+	(void)usart;
+
+	return 5625000U;
+}
+
+USH_peripheryStatus USART_receiveToIdleDMA(USART_TypeDef* usart, uint8_t* data, uint16_t size)
+{
+	(void)usart;
+	(void)data;
+	(void)size;
+
+	return STATUS_OK;
+}
+
+USH_peripheryStatus USART_transmitDMA(USART_TypeDef* usart, uint8_t* data, uint16_t size)
+{
+	(void)usart;
+	(void)data;
+	(void)size;
+
+	return STATUS_OK;
+}
+
+DMA_Stream_TypeDef* USART_getDmaStream(USART_TypeDef* usart, USH_USART_mode mode)
+{
+	(void)usart;
+	(void)mode;
+
+	return &rxStream;
+}
+
+const USH_USART_errorsTypeDef* USART_getErrors(USART_TypeDef* usart)
+{
+	(void)usart;
+
+	return &errors;
+}
+
+/**
+ * @brief 	This function takes the frame instead of the protocol module, it's always valid.
+ * @retval	1.
+ */
+uint8_t PROTOCOL_processFrame(uint8_t *frame, uint16_t size)
+{
+	receivedFrames[sizeReceivedFrames++] = (uint8_t)(size >> 8);
+	receivedFrames[sizeReceivedFrames++] = (uint8_t)size;
+
+	memcpy(&receivedFrames[sizeReceivedFrames], frame, size);
+	sizeReceivedFrames += size;
+
+	return 1;
+}
+
+void PROTOCOL_waitReply(void)
+{
+}
+
+void PROTOCOL_confirmBaudRate(uint32_t baudrate, uint8_t isApplied)
+{
+	(void)baudrate;
+	(void)isApplied;
+}
+
+void LOG_print(uint8_t level, const char *format, ...)
+{
+	(void)level;
+	(void)format;
+}
+
+uint16_t BOOT_getReport(uint8_t *buffer, uint16_t size)
+{
+	(void)buffer;
+	(void)size;
+
+	return 0;
+}
+
+void PROFILE_record(PROFILE_region region, uint32_t cycles)
+{
+	(void)region;
+	(void)cycles;
+}
+
+uint32_t MISC_timebaseNow(void)
+{
+	return 0;
+}
+
+//---------------------------------------------------------------------------
+// Main
+//---------------------------------------------------------------------------
+int main(void)
+{
+	UART_freeRtosInit();
+
+	// The token the semaphore is created with, see idleIRQTask
+	osSemaphoreWait(idleIRQHandle, osWaitForever);
+	rxStream.NDTR = RX_BUFFER_SIZE;
+
+	TEST_RUN(soakLosesNothing);
+	TEST_RUN(lateDisplayIsCaught);
+
+	return TEST_RESULT;
+}
@@ -10,6 +10,9 @@
 #if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
   #include <stdint.h>
   extern uint32_t SystemCoreClock;
+  extern uint32_t MISC_timebaseNow(void);
+  extern void HEAP_traceMalloc(void *address, uint32_t size);
+  extern void HEAP_traceFree(void *address, uint32_t size);
 #endif
 
 //---------------------------------------------------------------------------
@@ -30,7 +33,7 @@
 #define configTASK_NOTIFICATION_ARRAY_ENTRIES  			1
 #define configUSE_MUTEXES                        		1
 #define configUSE_RECURSIVE_MUTEXES						0
-#define configUSE_COUNTING_SEMAPHORES          			0
+#define configUSE_COUNTING_SEMAPHORES          			1
 #define configQUEUE_REGISTRY_SIZE                		10
 #define configUSE_QUEUE_SETS                    		0
 #define configUSE_TIME_SLICING      	            	1
@@ -54,7 +57,11 @@
 // Hook function related definitions
 #define configUSE_IDLE_HOOK                     		0
 #define configUSE_TICK_HOOK                      		0
-#define configCHECK_FOR_STACK_OVERFLOW          		0
+#ifdef DEBUG
+    #define configCHECK_FOR_STACK_OVERFLOW          	2	// The end of the stack is checked at every context switch
+#else
+    #define configCHECK_FOR_STACK_OVERFLOW          	0	// The monitor module watches the high-water marks instead
+#endif
 #define configUSE_MALLOC_FAILED_HOOK          			0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      		0
 #define configUSE_SB_COMPLETED_CALLBACK         		0
@@ -62,11 +69,19 @@
 // Run time and task stats gathering related definitions
 #ifdef DEBUG
     #define configRECORD_STACK_HIGH_ADDRESS				1
-  	#define configUSE_TRACE_FACILITY                	1
 #endif
 
-#define configGENERATE_RUN_TIME_STATS          			0
-#define configUSE_STATS_FORMATTING_FUNCTIONS    		0
+#define configUSE_TRACE_FACILITY                		1	// uxTaskGetSystemState for the monitor module
+#define configGENERATE_RUN_TIME_STATS          			1
+#define configUSE_STATS_FORMATTING_FUNCTIONS    		0	// The monitor module makes a binary report instead
+
+// The run time is counted in microseconds by the timebase which main() starts before the scheduler
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()				MISC_timebaseNow()
+
+// Every block of heap_4 is counted by the heap module, the hooks are called with the scheduler suspended
+#define traceMALLOC(pvAddress, uiSize)					HEAP_traceMalloc((pvAddress), (uiSize))
+#define traceFREE(pvAddress, uiSize)					HEAP_traceFree((pvAddress), (uiSize))
 
 // Co-routine related definitions
 #define configUSE_CO_ROUTINES                    		0
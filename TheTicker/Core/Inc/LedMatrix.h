@@ -13,14 +13,26 @@
 //---------------------------------------------------------------------------
 // Defines
 //---------------------------------------------------------------------------
-#define OUTPUT_BUFFER_MIN_ROW		MATRIX_DIGITS
+#define OUTPUT_BUFFER_MIN_ROW		(MAX7219_getDigits())
 #define OUTPUT_BUFFER_COLUMN		MATRIX_HIGH
 
+#define LEDMATRIX_FRAME_MAX_SIZE	(MATRIX_MAX_DIGITS * MATRIX_HIGH)
+
+#define LEDMATRIX_THREAD_COUNT		(2U)		// The threads of LEDMATRIX_freeRtosInit, see monitor.c
+
 //---------------------------------------------------------------------------
 // External function prototypes
 //---------------------------------------------------------------------------
 void LEDMATRIX_freeRtosInit(void);
 void sendToTheMatrixTask(void const *argument);
 void convertStringIntoDataForMatrixTask(void const *argument);
+void LEDMATRIX_setSpeed(uint8_t speed);
+void LEDMATRIX_setIntensity(USH_MAX7219_REG_INTENSITY newIntensity);
+uint8_t LEDMATRIX_writeFrame(uint16_t offset, const uint8_t *data, uint16_t size);
+void LEDMATRIX_presentFrame(void);
+uint16_t LEDMATRIX_getFrameSize(void);
+uint8_t LEDMATRIX_fillFrame(const COMPOSE_rectTypeDef *rect, uint8_t pattern);
+uint8_t LEDMATRIX_copyFrame(const COMPOSE_rectTypeDef *rect, uint8_t module, uint8_t line);
+uint8_t LEDMATRIX_blendFrame(const COMPOSE_rectTypeDef *rect, const uint8_t *layer, const uint8_t *mask);
 
 #endif /* __LEDMATRIX_H */
@@ -0,0 +1,48 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __BOOT_H
+#define __BOOT_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define BOOT_REPORT_SIZE			(128U)
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Boot stages enumeration
+ */
+typedef enum
+{
+	BOOT_STAGE_RESET = 0,			/* The main function is entered */
+	BOOT_STAGE_CLOCK_READY,			/* The system clock is switched to PLL */
+	BOOT_STAGE_SCHEDULER_START,		/* The FreeRTOS scheduler is about to start */
+	BOOT_STAGE_DISPLAY_READY,		/* The MAX7219 chain is initialized */
+	BOOT_STAGE_FIRST_FRAME,			/* The first frame is latched by the matrix, even under the self-test */
+	BOOT_STAGE_SELF_TEST_END,		/* The self-test of the matrix is over, the frames can be seen */
+	BOOT_STAGE_COUNT
+} BOOT_stage;
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+void BOOT_init(void);
+void BOOT_mark(BOOT_stage stage);
+uint32_t BOOT_getStageTime(BOOT_stage stage);
+uint16_t BOOT_getReport(uint8_t *buffer, uint16_t size);
+
+//---------------------------------------------------------------------------
+// Callbacks
+//---------------------------------------------------------------------------
+__WEAK void BOOT_completeCallback(void);
+
+#endif /* __BOOT_H */
@@ -0,0 +1,61 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __COMPOSE_H
+#define __COMPOSE_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "stm32f4xx.h"		// Not main.h, LedMatrix.h takes the types from here
+
+/* Compositing of the frames in the layout of LEDMATRIX_writeFrame: MATRIX_HIGH bytes per module, a byte is a line
+ * of 8 pixels. The rectangle is given in modules horizontally and in lines vertically.
+ *
+ * The fills and the copies of the big rectangles are done by DMA2D (Chrom-ART) in the background, the calling thread
+ * goes on with its own work and COMPOSE_wait blocks until the engine is free again. Every next operation waits for
+ * the previous one, so the operations on the same frame keep their order. DMA2D sees a module as a line of MATRIX_HIGH
+ * 8-bit pixels:
+ * 	- the copy runs in memory-to-memory mode, the pixel size is the one of the L8 foreground, so any rectangle fits;
+ * 	- the fill runs in register-to-memory mode, the output can't be narrower than 16 bits, so it's done by DMA2D
+ * 	  only when the first line and the number of lines are even.
+ * The blending of a layer is pixel by pixel with a mask, DMA2D blends alpha into 16..32-bit colours only, so it's
+ * always done by CPU. The small rectangles and the ones DMA2D can't do are done by CPU with the same result.
+ *
+ * Comment out COMPOSE_DMA2D to do everything by CPU, then the module doesn't touch the DMA2D registers.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define COMPOSE_DMA2D
+
+// The smaller rectangles are done by CPU, the setup of DMA2D and the interrupt cost more than the work itself
+#define COMPOSE_DMA2D_THRESHOLD		((uint16_t)64)		// bytes
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Rectangle of the frame structure
+ */
+typedef struct
+{
+	uint8_t module;						/* The first module */
+	uint8_t line;						/* The first line, 0..MATRIX_HIGH - 1 */
+	uint8_t modules;					/* The number of modules */
+	uint8_t lines;						/* The number of lines */
+} COMPOSE_rectTypeDef;
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+void COMPOSE_freeRtosInit(void);
+void COMPOSE_fill(uint8_t *frame, const COMPOSE_rectTypeDef *rect, uint8_t pattern);
+void COMPOSE_copy(uint8_t *destination, const uint8_t *source, const COMPOSE_rectTypeDef *rect, uint8_t module, uint8_t line);
+void COMPOSE_blend(uint8_t *frame, const COMPOSE_rectTypeDef *rect, const uint8_t *layer, const uint8_t *mask);
+void COMPOSE_wait(void);
+void COMPOSE_IRQHandler(void);
+
+#endif /* __COMPOSE_H */
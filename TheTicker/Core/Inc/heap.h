@@ -0,0 +1,91 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __HEAP_H
+#define __HEAP_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+
+/* The statistics of the FreeRTOS heap (heap_4). heap_4 calls the traceMALLOC and traceFREE hooks (see FreeRTOSConfig.h)
+ * with the scheduler suspended, so every block is counted here without locks. Allocations are never made from
+ * interrupts.
+ *
+ * Every block is charged to the tag of its caller. The threads, queues and mutexes are created before the scheduler
+ * starts, so freeRtosInit sets the tag of every module with HEAP_setTag around its initialization. The blocks taken
+ * while the threads run come from HEAP_malloc, which gets the tag from its caller. The others get HEAP_TAG_KERNEL.
+ * The blocks are freed with vPortFree as usual: the address is found in the table of the live blocks, so the free
+ * is charged to the same tag. A tag whose allocations minus frees keep growing leaks. The blocks which don't fit
+ * into the table stay charged to their tag after the free, untracked counts them, so the host knows when the leak
+ * report overstates.
+ *
+ * The sizes are the ones of the heap_4 blocks, with the header and the alignment. The size classes are power of two
+ * buckets: bucket k counts the blocks of 2^(k-1)..2^k - 1 bytes, the last one counts all the bigger blocks.
+ * The free space, the largest free block and the number of free blocks come from vPortGetHeapStats, the
+ * fragmentation is the share of the free space which is outside of the largest free block.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define HEAP_SIZE_CLASS_COUNT		(14U)		// The last class starts at 2^12 bytes
+#define HEAP_TRACK_MAX				(48U)		// Two blocks for every thread, one for every queue, mutex and semaphore
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Allocation tags enumeration
+ */
+typedef enum
+{
+	HEAP_TAG_KERNEL = 0,				/* The blocks without a tag */
+	HEAP_TAG_MEMDMA,
+	HEAP_TAG_COMPOSE,
+	HEAP_TAG_MONITOR,
+	HEAP_TAG_HEARTBEAT,
+	HEAP_TAG_LEDMATRIX,
+	HEAP_TAG_UART,
+	HEAP_TAG_LOG,
+	HEAP_TAG_COUNT
+} HEAP_tag;
+
+/**
+ * @brief Tag statistics structure
+ */
+typedef struct
+{
+	uint32_t allocations;				/* The number of blocks taken */
+	uint32_t frees;						/* The number of blocks returned */
+	uint16_t failures;					/* The number of allocations the heap couldn't serve */
+	uint32_t bytes;						/* The size of the blocks which are still taken */
+} HEAP_tagTypeDef;
+
+/**
+ * @brief Heap statistics structure
+ */
+typedef struct
+{
+	uint32_t freeBytes;					/* The free space now */
+	uint32_t minFreeBytes;				/* The smallest free space since the start */
+	uint32_t largestFreeBlock;			/* The biggest block the heap can give now */
+	uint32_t freeBlocks;				/* The number of free blocks */
+	uint16_t fragmentation;				/* The share of the free space outside of the largest block, permille */
+	uint32_t untracked;					/* The blocks which didn't fit into the table since the start */
+	uint32_t sizeClasses[HEAP_SIZE_CLASS_COUNT];	/* The histogram of the sizes of all the blocks taken */
+} HEAP_statsTypeDef;
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+void HEAP_setTag(HEAP_tag tag);
+void* HEAP_malloc(size_t size, HEAP_tag tag);
+void HEAP_getStats(HEAP_statsTypeDef *stats);
+uint8_t HEAP_getTag(HEAP_tag tag, HEAP_tagTypeDef *statistics);
+void HEAP_traceMalloc(void *address, uint32_t size);
+void HEAP_traceFree(void *address, uint32_t size);
+
+#endif /* __HEAP_H */
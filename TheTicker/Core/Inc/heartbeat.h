@@ -9,6 +9,11 @@
 //---------------------------------------------------------------------------
 #include "main.h"
 
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define HEARTBEAT_THREAD_COUNT		(1U)		// The threads of HEARTBEAT_freeRtosInit, see monitor.c
+
 //---------------------------------------------------------------------------
 // External function prototypes
 //---------------------------------------------------------------------------
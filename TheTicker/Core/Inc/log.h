@@ -0,0 +1,71 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __LOG_H
+#define __LOG_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+
+/* The log records are formatted by the caller into a short line and copied into a ring buffer without locks,
+ * so the macros can be used from threads and interrupts and never block. A background thread drains the ring
+ * through the U(S)ART TX queue (DMA). When the ring is full, the record is dropped and counted.
+ *
+ * Format: %d, %i, %u, %x, %X, %c, %s and %%, the numbers can have a width with an optional leading 0 (%08x).
+ * The records share the U(S)ART with the text replies, they never contain 0x00, so the binary frames stay apart.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define LOG_LEVEL_NONE			(0)
+#define LOG_LEVEL_ERROR			(1)
+#define LOG_LEVEL_WARNING		(2)
+#define LOG_LEVEL_INFO			(3)
+#define LOG_LEVEL_DEBUG			(4)
+
+// The records above this level aren't compiled at all
+#ifndef LOG_LEVEL
+#define LOG_LEVEL				LOG_LEVEL_INFO
+#endif
+
+#define LOG_LINE_SIZE			(64U)		// The longest record including the prefix and \r\n, it lives on the caller's stack
+
+#define LOG_THREAD_COUNT		(1U)		// The threads of LOG_freeRtosInit, see monitor.c
+
+#if (LOG_LEVEL >= LOG_LEVEL_ERROR)
+#define LOG_ERROR(...)			LOG_print(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...)			((void)0)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_WARNING)
+#define LOG_WARNING(...)		LOG_print(LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...)		((void)0)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_INFO)
+#define LOG_INFO(...)			LOG_print(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...)			((void)0)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_DEBUG)
+#define LOG_DEBUG(...)			LOG_print(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...)			((void)0)
+#endif
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+void LOG_freeRtosInit(void);
+void logTask(void const *argument);
+void LOG_print(uint8_t level, const char *format, ...);
+uint16_t LOG_write(const char *data, uint16_t size);
+uint32_t LOG_getDropped(void);
+
+#endif /* __LOG_H */
@@ -24,6 +24,14 @@ extern "C" {
 //---------------------------------------------------------------------------
 // Module's includes
 //---------------------------------------------------------------------------
+#include "boot.h"
+#include "log.h"
+#include "memdma.h"
+#include "compose.h"
+#include "profile.h"
+#include "monitor.h"
+#include "heap.h"
+
 #ifdef HEARTBEAT
 	#include "heartbeat.h"
 #endif
@@ -34,6 +42,7 @@ extern "C" {
 
 #ifdef UART
 	#include "uart.h"
+	#include "protocol.h"
 #endif
 
 //---------------------------------------------------------------------------
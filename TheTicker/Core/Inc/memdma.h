@@ -0,0 +1,51 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __MEMDMA_H
+#define __MEMDMA_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+
+/* Memory-to-memory copies and fills on a DMA2 stream. The transfer is started and the caller goes on with its own
+ * work, MEMDMA_wait blocks until the engine is free again. One transfer runs at a time, the next copy or fill waits
+ * for the previous one.
+ *
+ * The word transfers with 4-beat bursts through the FIFO are used when both addresses and the size are aligned to
+ * 16 bytes, the word transfers when they are aligned to 4 bytes, the byte transfers otherwise. The blocks shorter
+ * than MEMDMA_CPU_THRESHOLD are copied by CPU right away. DMA can't reach CCM RAM, so the buffers live in SRAM.
+ *
+ * The threshold. Both paths take the engine, then the CPU path costs memcpy or memset of the block, the DMA path costs
+ * the thread the programming of the stream (PROFILE_REGION_MEMDMA_START) and the completion interrupt
+ * (PROFILE_REGION_ISR_MEMDMA), the transfer itself runs in parallel with the thread. So the stream pays off from the
+ * size where the CPU copy (PROFILE_REGION_MEMDMA_CPU) gets longer than the start and the interrupt together.
+ * MEMDMA_benchmark runs both paths at any size, Tools/memdma.py sweeps the sizes with PROTOCOL_CMD_BENCH_MEMDMA and
+ * prints that size for the copy and the fill.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+
+// The shorter blocks are copied by CPU, the setup of the stream and the interrupt cost more than the copy itself
+#define MEMDMA_CPU_THRESHOLD		((uint16_t)64)
+
+#define MEMDMA_BENCHMARK_MAX_SIZE	((uint16_t)1024)	// The blocks of MEMDMA_benchmark, both of them are in SRAM
+
+#define MEMDMA_CCM_SIZE				((uint32_t)0x10000)		// 64 KB of CCM RAM
+
+#define IS_MEMDMA_ADDRESS(ADDRESS)	(((uint32_t)(ADDRESS) < CCMDATARAM_BASE) || \
+									 ((uint32_t)(ADDRESS) >= (CCMDATARAM_BASE + MEMDMA_CCM_SIZE)))
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+void MEMDMA_freeRtosInit(void);
+void MEMDMA_copy(void *destination, const void *source, uint16_t size);
+void MEMDMA_fill(void *destination, uint8_t value, uint16_t size);
+void MEMDMA_wait(void);
+uint8_t MEMDMA_benchmark(uint8_t isFill, uint16_t size, uint8_t runs);		// Built with PROFILE only
+
+#endif /* __MEMDMA_H */
@@ -0,0 +1,71 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __MONITOR_H
+#define __MONITOR_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+
+/* The state of the RTOS for the host. The CPU usage of every thread comes from the FreeRTOS run-time stats which are
+ * counted in microseconds by the timebase. The usage is given for the interval since the previous query, so the host
+ * sees the current load, the share of the IDLE thread is the headroom. The first query covers the time since the start.
+ * The counters wrap every 71 minutes, the host has to query more often to get the right numbers.
+ *
+ * The stacks are filled with a known value when the threads are created, so the high-water mark of a thread is the
+ * smallest number of free words it has ever had. The monitor thread samples them every MONITOR_STACK_PERIOD and logs
+ * a warning once for every thread which has less than MONITOR_STACK_MARGIN words left. The host reads the same numbers
+ * with PROTOCOL_CMD_QUERY_STACKS after a run through all the features, the smallest safe stack of a thread is
+ * its size in osThreadDef - the free words + MONITOR_STACK_MARGIN, Tools/stacks.py prints it for every thread.
+ * In the DEBUG build FreeRTOS checks the stack at every context switch too and stops in vApplicationStackOverflowHook,
+ * see freertos.c.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+
+// It can't be less than the number of the threads including IDLE, otherwise FreeRTOS reports none of them.
+// monitor.c checks it against the threads of the modules, protocol.c against the size of the replies.
+#define MONITOR_MAX_TASKS			(8U)
+#define MONITOR_THREAD_COUNT		(1U)		// The threads of MONITOR_freeRtosInit
+
+#define MONITOR_STACK_PERIOD		(1000U)		// ms
+#define MONITOR_STACK_MARGIN		(32U)		// words, the interrupts and the paths which haven't run yet
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Thread CPU usage structure
+ */
+typedef struct
+{
+	const char *name;					/* The name of the thread */
+	uint8_t number;						/* The number of the thread, unique since the start */
+	uint32_t runTime;					/* The time the thread has run during the interval, us */
+	uint16_t permille;					/* The share of the interval, 0..1000 */
+} MONITOR_taskUsageTypeDef;
+
+/**
+ * @brief Thread stack usage structure
+ */
+typedef struct
+{
+	const char *name;					/* The name of the thread */
+	uint8_t number;						/* The number of the thread, unique since the start */
+	uint16_t minFree;					/* The smallest number of free words of the stack since the start */
+} MONITOR_stackUsageTypeDef;
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+void MONITOR_freeRtosInit(void);
+void monitorTask(void const *argument);
+uint8_t MONITOR_getTaskUsage(MONITOR_taskUsageTypeDef *usage, uint32_t *interval);
+uint8_t MONITOR_getStackUsage(MONITOR_stackUsageTypeDef *usage);
+
+#endif /* __MONITOR_H */
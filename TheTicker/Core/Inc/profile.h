@@ -0,0 +1,103 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+
+/* The regions of code are measured in core cycles by the DWT cycle counter, which BOOT_init starts. Every region keeps
+ * the number of runs, the minimum, the maximum, the sum for the mean and a histogram with power of two buckets:
+ * bucket k counts the runs of 2^(k-1)..2^k - 1 cycles, the last one counts all the longer runs.
+ *
+ * 		PROFILE_BEGIN(PROFILE_REGION_SHIFT);
+ * 		shiftOutputBuffer(...);
+ * 		PROFILE_END(PROFILE_REGION_SHIFT);
+ *
+ * A region is recorded from one thread or from interrupts of one priority only, so no lock is taken. The host reads
+ * the regions with PROTOCOL_CMD_QUERY_PROFILE. Comment out PROFILE and the macros compile to nothing. The memdma
+ * regions are recorded by the thread which holds the engine, so they are taken one at a time as well.
+ *
+ * The latency regions are in microseconds of the timebase (see ush_stm32f4xx_misc.h). A new message is stamped at
+ * the RX event which brought its end (IDLE, half or complete of the RX DMA), when the parser queues it and when it's
+ * decoded into the text. The first frame with its beginning is stamped when its last row is latched by the matrix.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define PROFILE
+
+#define PROFILE_BUCKET_COUNT		(24U)		// The last bucket starts at 2^22 cycles, 23 ms at 180 MHz
+
+#ifdef PROFILE
+#define PROFILE_BEGIN(REGION)		uint32_t profileStart_##REGION = DWT->CYCCNT
+#define PROFILE_END(REGION)			PROFILE_record((REGION), DWT->CYCCNT - profileStart_##REGION)
+#define PROFILE_STAMP(STAMP)		((STAMP) = MISC_timebaseNow())
+#else
+#define PROFILE_BEGIN(REGION)		((void)0)
+#define PROFILE_END(REGION)			((void)0)
+#define PROFILE_STAMP(STAMP)		((void)0)
+#endif
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Profiled regions enumeration
+ */
+typedef enum
+{
+	PROFILE_REGION_OUTPUT = 0,			/* The preparation of the SPI words of a frame for the matrix */
+	PROFILE_REGION_SHIFT,				/* The shift of the creeping line */
+	PROFILE_REGION_CONVERT,				/* The copy or decoding of a message into the text */
+	PROFILE_REGION_CAPTURE,				/* The search for the messages in the circular RX buffer */
+	PROFILE_REGION_ISR_USART,			/* The U(S)ART interrupt */
+	PROFILE_REGION_ISR_USART_DMA,		/* The U(S)ART RX and TX DMA interrupts */
+	PROFILE_REGION_ISR_SPI_DMA,			/* The SPI TX DMA interrupt which chains the rows of the matrix */
+	PROFILE_REGION_LATENCY_PARSE,		/* From the RX event to the message in the display queue, us */
+	PROFILE_REGION_LATENCY_DECODE,		/* From the display queue to the message in the text, us */
+	PROFILE_REGION_LATENCY_DISPLAY,		/* From the text to the first frame on the matrix, us */
+	PROFILE_REGION_LATENCY_TOTAL,		/* From the RX event to the first frame on the matrix, us */
+	PROFILE_REGION_MEMDMA_CPU,			/* A copy or fill of memdma done by CPU */
+	PROFILE_REGION_MEMDMA_START,		/* The programming of the stream for a copy or fill of memdma */
+	PROFILE_REGION_MEMDMA_TRANSFER,		/* From the start of the stream to its completion interrupt */
+	PROFILE_REGION_ISR_MEMDMA,			/* The interrupt of the memdma stream */
+	PROFILE_REGION_COUNT
+} PROFILE_region;
+
+/**
+ * @brief Region statistics structure
+ */
+typedef struct
+{
+	uint32_t count;						/* The number of runs */
+	uint32_t min;						/* The shortest run in cycles */
+	uint32_t max;						/* The longest run in cycles */
+	uint64_t sum;						/* The sum of all the runs in cycles */
+	uint32_t buckets[PROFILE_BUCKET_COUNT];	/* The histogram of the runs */
+} PROFILE_regionTypeDef;
+
+/**
+ * @brief Message latency stamps structure
+ */
+typedef struct
+{
+	uint32_t received;					/* The RX event which brought the end of the message, us */
+	uint32_t parsed;					/* The message is put into the display queue, us */
+	uint32_t decoded;					/* The message is copied or decoded into the text, us */
+} PROFILE_latencyTypeDef;
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+void PROFILE_record(PROFILE_region region, uint32_t cycles);
+uint8_t PROFILE_read(PROFILE_region region, PROFILE_regionTypeDef *statistics);
+void PROFILE_reset(PROFILE_region region);
+void PROFILE_recordLatency(const PROFILE_latencyTypeDef *latency);
+
+#endif /* __PROFILE_H */
@@ -0,0 +1,135 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __PROTOCOL_H
+#define __PROTOCOL_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+
+/* The binary protocol works on the same U(S)ART as the text lines. Every frame starts and ends with 0x00
+ * and is COBS encoded between them, so the frame has no zeros inside and the text lines have no zeros at all.
+ *
+ * The decoded frame.
+ * 		   ___________________________________________________
+ * Request |  command  |      payload      | CRC-32/MPEG-2	  |
+ * 		   |  1 byte   |    0..N bytes     | 4 bytes, MSB first |
+ * 		   ___________________________________________________
+ * Reply   | command | 0x80 | status | payload | CRC-32/MPEG-2 |
+ *
+ * The CRC covers the command and the payload. A frame with a wrong CRC is dropped without a reply.
+ *
+ * Flow control. The host has as many credits as the display queue has free slots. Every set-message takes one credit
+ * and its reply returns the credits left, query-credits returns them at any time. A set-message without credits
+ * is rejected with PROTOCOL_STATUS_NO_CREDITS and counted. RTS/CTS keep the bytes from being lost on the line.
+ *
+ * Frames. The host can draw the whole chain itself, 8 bytes per module (see LEDMATRIX_writeFrame). A frame can be
+ * sent in several requests, the one with PROTOCOL_FRAME_PRESENT shows it at the next frame tick. set-frame writes
+ * whole modules, set-frame-delta writes runs of changed bytes on top of the last frame:
+ * 		   ______________________________________________________________
+ * Delta   | flags | offset, 2 bytes MSB first | length | data | offset ... |
+ *
+ * A whole 4-module frame takes 42 bytes on the wire, so 115200 baud carries over 250 fps, more than the frame tick
+ * of the display (100 fps). Any text message brings the creeping line back.
+ *
+ * Compositing. The zones of a big chain are drawn on the back frame by the display (see compose.h), the rectangle
+ * is 4 bytes: the first module, the first line, the number of modules, the number of lines.
+ * 		   _____________________________________________________________________
+ * Fill    | flags | rectangle | pattern                                      |
+ * Copy    | flags | rectangle of the last frame | destination module, line   |
+ * Blend   | flags | rectangle | layer, lines x modules | mask, if PROTOCOL_FRAME_MASKED |
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define PROTOCOL_VERSION_MAJOR			((uint8_t)1)
+#define PROTOCOL_VERSION_MINOR			((uint8_t)11)
+
+#define PROTOCOL_PAYLOAD_MAX_SIZE		(128U)
+#define PROTOCOL_FRAME_MAX_SIZE			(PROTOCOL_PAYLOAD_MAX_SIZE + 8U)	// + command, status, CRC, COBS overhead
+
+// The signal of the thread which processes the frames (idleIRQTask), uart.c uses 0x01
+#define PROTOCOL_SIGNAL_REPLY_SENT		((int32_t)0x02)
+
+#define PROTOCOL_FRAME_DELIMITER		((uint8_t)0x00)
+#define PROTOCOL_REPLY_FLAG				((uint8_t)0x80)
+
+#define PROTOCOL_FRAME_PRESENT			((uint8_t)0x01)		// The flag of the frame requests, the frame is complete
+#define PROTOCOL_FRAME_MASKED			((uint8_t)0x02)		// The flag of the blend request, the mask follows the layer
+#define PROTOCOL_TEXT_MORE				((uint8_t)0x01)		// The flag of the packed text, the next request continues it
+#define PROTOCOL_PROFILE_RESET			((uint8_t)0x01)		// The flag of the profile query, the region is cleared after reading
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Protocol commands enumeration
+ */
+typedef enum
+{
+	PROTOCOL_CMD_SET_MESSAGE = 0x01,	/* payload: the text of the message, reply: 1 byte, the credits left */
+	PROTOCOL_CMD_SET_SPEED,				/* payload: 1 byte, the delay between shifts in ms */
+	PROTOCOL_CMD_SET_INTENSITY,			/* payload: 1 byte, 0..15 */
+	PROTOCOL_CMD_QUERY_STATS,			/* reply: dropped lines, received frames, dropped frames, dropped messages,
+										   rejected messages, overwritten messages as 32-bit MSB first numbers */
+	PROTOCOL_CMD_QUERY_VERSION,			/* reply: protocol major and minor version, the number of modules */
+	PROTOCOL_CMD_QUERY_BOOT,			/* reply: the boot timeline as a text line */
+	PROTOCOL_CMD_SET_BAUDRATE,			/* payload: 4 bytes MSB first, the reply is sent before the switch. The second reply
+										   with the baud rate as the payload confirms the switch at the new baud rate,
+										   or comes at the old one with PROTOCOL_STATUS_FAILED */
+	PROTOCOL_CMD_QUERY_CREDITS,			/* reply: 1 byte, the number of messages the display can take now */
+	PROTOCOL_CMD_QUERY_ERRORS,			/* reply: parity, framing, noise and overrun errors of the U(S)ART
+										   as 32-bit MSB first numbers */
+	PROTOCOL_CMD_SET_FRAME,				/* payload: flags, the first module, 8 bytes for every module */
+	PROTOCOL_CMD_SET_FRAME_DELTA,		/* payload: flags, the runs of changed bytes */
+	PROTOCOL_CMD_SET_MESSAGE_PACKED,	/* payload: flags, the packed text (see textcodec.h), reply: 1 byte, the credits left.
+										   The text longer than a request is sent in several with PROTOCOL_TEXT_MORE */
+	PROTOCOL_CMD_FILL_FRAME,			/* payload: flags, the rectangle, the pattern of every line */
+	PROTOCOL_CMD_COPY_FRAME,			/* payload: flags, the rectangle of the last frame, the destination module and line */
+	PROTOCOL_CMD_BLEND_FRAME,			/* payload: flags, the rectangle, the layer and the mask */
+	PROTOCOL_CMD_QUERY_PROFILE,			/* payload: the region (see profile.h), optional flags. reply: runs, min, max and mean
+										   cycles and the histogram buckets as 32-bit MSB first numbers.
+										   PROTOCOL_STATUS_UNKNOWN_COMMAND if the firmware is built without PROFILE */
+	PROTOCOL_CMD_QUERY_TASKS,			/* reply: the interval since the previous query in us, then for every thread: its number,
+										   run time in us, share of the interval in permille, 8 bytes of its name padded
+										   with zeros. The numbers are MSB first, see monitor.h */
+	PROTOCOL_CMD_QUERY_STACKS,			/* reply: MONITOR_STACK_MARGIN in words, then for every thread: its number, the smallest
+										   number of free words of its stack since the start, 8 bytes of its name padded with
+										   zeros. The numbers are MSB first, see monitor.h */
+	PROTOCOL_CMD_QUERY_HEAP,			/* reply: free bytes, the smallest free bytes since the start, the largest free block,
+										   the number of free blocks, 2 bytes of fragmentation in permille, the untracked
+										   blocks and the size class histogram. The numbers are MSB first, see heap.h */
+	PROTOCOL_CMD_QUERY_HEAP_TAGS,		/* reply: for every tag (see heap.h): the allocations, the frees, 2 bytes of failures
+										   and the bytes which are still taken. The numbers are MSB first */
+	PROTOCOL_CMD_BENCH_MEMDMA,			/* payload: 1 to fill or 0 to copy, 2 bytes of the size MSB first, the number of runs.
+										   Both paths of memdma run on the blocks of the benchmark, the host reads the
+										   memdma regions of the profile. PROTOCOL_STATUS_UNKNOWN_COMMAND if the firmware
+										   is built without PROFILE */
+	PROTOCOL_CMD_COUNT
+} PROTOCOL_command;
+
+/**
+ * @brief Protocol reply statuses enumeration
+ */
+typedef enum
+{
+	PROTOCOL_STATUS_OK = 0,				/* The command is done */
+	PROTOCOL_STATUS_UNKNOWN_COMMAND,	/* The command isn't supported */
+	PROTOCOL_STATUS_WRONG_SIZE,			/* The payload size doesn't suit the command */
+	PROTOCOL_STATUS_WRONG_VALUE,		/* The payload value is out of range */
+	PROTOCOL_STATUS_NO_CREDITS,			/* The display queue is full, the message is rejected */
+	PROTOCOL_STATUS_FAILED				/* The command is accepted, but it couldn't be done */
+} PROTOCOL_status;
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+uint8_t PROTOCOL_processFrame(uint8_t *frame, uint16_t size);
+void PROTOCOL_waitReply(void);
+void PROTOCOL_confirmBaudRate(uint32_t baudrate, uint8_t isApplied);
+
+#endif /* __PROTOCOL_H */
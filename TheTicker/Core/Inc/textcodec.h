@@ -0,0 +1,37 @@
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __TEXTCODEC_H
+#define __TEXTCODEC_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "main.h"
+
+/* The packed text is a stream of codes which are decoded straight into the text of the LedMatrix module.
+ *
+ * 		  code	  |		 meaning
+ * 	______________|_____________________________________________________________________
+ * 	0x00 - 0x7F	  | the symbol itself
+ * 	0x80 - 0xBF	  | the entry of the static dictionary (code - 0x80), see textcodec.c
+ * 	0xC0 - 0xFF	  | the copy of (code - 0xC0 + 3) symbols decoded before, the next byte is the distance - 1,
+ * 				  | so up to 66 symbols from up to 256 symbols back. The copy can overlap itself ("-" x 20).
+ *
+ * The copies reach into the previous chunks of the same message, so the repeated symbols and prices of a playlist
+ * are sent once. A copy from before the beginning of the message is skipped.
+ */
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define TEXTCODEC_DICTIONARY_BASE		((uint8_t)0x80)
+#define TEXTCODEC_COPY_BASE				((uint8_t)0xC0)
+#define TEXTCODEC_COPY_MIN_SIZE			(3U)
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+uint16_t TEXTCODEC_decode(const UART_messageTypeDef *message, uint8_t *text, uint16_t sizeText, uint16_t sizeMax);
+
+#endif /* __TEXTCODEC_H */
@@ -9,24 +9,75 @@
 //---------------------------------------------------------------------------
 #include "main.h"
 
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define UART_MESSAGE_QUEUE_SIZE		(4U)
+#define UART_MESSAGE_POOL_SIZE		(UART_MESSAGE_QUEUE_SIZE + 2U)	// + the message being rendered + the message being captured
+
+#define UART_THREAD_COUNT			(1U)		// The threads of UART_freeRtosInit, see monitor.c
+
 //---------------------------------------------------------------------------
 // Typedefs and enumerations
 //---------------------------------------------------------------------------
 
+/**
+ * @brief UART message flags enumeration
+ * @note  A line which is longer than a chunk is sent in several messages, a short line has both flags.
+ */
+typedef enum
+{
+	UART_MESSAGE_FIRST_CHUNK	= 0x01U,	/* The message starts a new line */
+	UART_MESSAGE_LAST_CHUNK		= 0x02U,	/* The message ends the line */
+	UART_MESSAGE_PACKED			= 0x04U,	/* The message is packed, see textcodec.h */
+	UART_MESSAGE_WHOLE			= (UART_MESSAGE_FIRST_CHUNK | UART_MESSAGE_LAST_CHUNK)
+} UART_messageFlags;
+
 /**
  * @brief UART message structure
+ * @note  The message isn't copied out of the RX buffer, the structure describes where it lies. When the message
+ * 		  wraps the end of the circular buffer, the last sizeWrap symbols are at the beginning of the buffer.
+ * 		  The new data can overwrite it before it's copied, UART_checkMessage tells it after the copy.
  */
 typedef struct
 {
-	uint8_t *message;		/* The pointer to received message */
-	uint8_t sizeMessage;	/* The size of received message */
+	const uint8_t *buffer;	/* The pointer to the buffer which contains the message */
+	uint16_t sizeBuffer;	/* The size of the buffer */
+	uint16_t offset;		/* The index of the first symbol of the message in the buffer */
+	uint16_t sizeMessage;	/* The size of received message */
+	uint16_t sizeWrap;		/* The number of symbols which are continued from the beginning of the buffer */
+	uint8_t flags;			/* The part of the line. This parameter can be a combination of @ref UART_messageFlags */
+	uint32_t mark;			/* The number of symbols the RX DMA had written before the first one of the message */
+#ifdef PROFILE
+	PROFILE_latencyTypeDef latency;	/* The stamps of the message, see profile.h */
+#endif
 } UART_messageTypeDef;
 
+/**
+ * @brief UART receive statistics structure
+ */
+typedef struct
+{
+	uint32_t droppedLines;		/* The number of lines which were cut by an overrun or by the full display queue */
+	uint32_t receivedFrames;	/* The number of valid binary frames */
+	uint32_t droppedFrames;		/* The number of binary frames which were too long or broken */
+	uint32_t droppedMessages;	/* The number of messages which were dropped because the display queue was full */
+	uint32_t overwrittenMessages;	/* The number of messages which the new data overwrote before the display copied them */
+} UART_rxStatisticsTypeDef;
+
 //---------------------------------------------------------------------------
 // External function prototypes
 //---------------------------------------------------------------------------
 void UART_freeRtosInit(void);
 void idleIRQTask(void const *argument);
-uint8_t* getPointerDefaultString(void);
+uint8_t UART_getSymbol(const UART_messageTypeDef *message, uint16_t index);
+uint8_t UART_checkMessage(const UART_messageTypeDef *message);
+void UART_releaseMessage(UART_messageTypeDef *message);
+const UART_rxStatisticsTypeDef* UART_getRxStatistics(void);
+const USH_USART_errorsTypeDef* UART_getErrors(void);
+uint8_t UART_putMessage(const uint8_t *text, uint16_t size, uint8_t flags);
+uint8_t UART_getCredits(void);
+void UART_transmit(const uint8_t *data, uint16_t size, int32_t signal);
+uint8_t UART_requestBaudRate(uint32_t baudrate);
 
 #endif /* __UART_H */
@@ -4,6 +4,7 @@
 #include "LedMatrix.h"
 #include "string.h"
 #include "fonts_max7219.h"
+#include "textcodec.h"
 
 //---------------------------------------------------------------------------
 // Defines
@@ -14,10 +15,24 @@
 #define USED_PINSPACK		((SPI_PINSPACK_1))
 #define USED_PRESCALER		((SPI_BAUDRATE_PRESCALER_16))
 
-#define SPEED_SHIFT			((uint8_t)60)
+#define SPEED_SHIFT			((uint8_t)60)		// ms, the default delay between shifts
 
 #define SHIFT_BYTE			((uint8_t)7)
 
+// The text of the message is kept instead of its image, the symbols are rasterized as they come into view.
+// A message which arrives in chunks is appended till its last chunk, the rest of a longer one is cut off.
+#define TEXT_SIZE			((uint16_t)4096)
+
+// The frames from the host are presented at this period, it limits the frame rate to 100 fps
+#define FRAME_PERIOD		((uint8_t)10)		// ms
+
+#define SIGNAL_OUTPUT_SENT	((int32_t)0x01)
+
+// Power-on self-test. It runs alongside the rest of the initialization and the first frames, which it hides
+// for its duration. Comment out LEDMATRIX_SELF_TEST to skip the test.
+#define LEDMATRIX_SELF_TEST
+#define SELF_TEST_DURATION	((uint32_t)250)		// ms
+
 //---------------------------------------------------------------------------
 // Descriptions of FreeRTOS elements
 //---------------------------------------------------------------------------
@@ -29,15 +44,38 @@ extern osMessageQId fromUartToMatrixHandle;
 //---------------------------------------------------------------------------
 // Static function prototypes
 //---------------------------------------------------------------------------
-static void outputOnMatrix(uint8_t** outputBuffer);
+static void fillOutputRows(uint8_t** outputBuffer, uint8_t rowOutputBuffer);
 static void shiftOutputBuffer(uint8_t** outputBuffer, uint8_t rowOutputBuffer, uint8_t columnOutputBuffer);
-static uint8_t** convertStringIntoDataForMatrix(UART_messageTypeDef *message, const uint8_t fontArray[][ASCII_COLUMN]);
+static uint8_t** createOutputBuffer(uint8_t rowOutputBuffer);
+static void resetOutputBuffer(uint8_t** outputBuffer, uint8_t rowOutputBuffer);
+static void loadSymbol(uint8_t* outputRow, const uint8_t fontArray[][ASCII_COLUMN]);
+static void appendText(const UART_messageTypeDef *message);
+static void fillOutputRowsFromFrame(const uint8_t* frame);
+static uint8_t isRectInFrame(const COMPOSE_rectTypeDef *rect);
 
 //---------------------------------------------------------------------------
 // Variables
 //---------------------------------------------------------------------------
 static uint8_t **outputBuffer;
-static uint8_t rowBuffer;
+static uint8_t rowBuffer;				// The modules in the chain + the row which the next symbol comes from
+static uint8_t shiftCount;				// The number of shifts since the next symbol was loaded
+static uint8_t text[TEXT_SIZE];
+static uint16_t sizeText;
+static uint16_t nextSymbol;				// The index of the symbol to be loaded next
+static uint8_t isTextComplete;			// The last chunk of the message has been received
+static uint8_t isLineBroken;			// A chunk of the message was overwritten in the RX buffer before the copy
+static volatile uint8_t speedShift = SPEED_SHIFT;
+static volatile uint8_t intensity = INTENSITY_13_32;
+static volatile uint8_t intensityChanged;
+static __ALIGNED(16) uint8_t frames[2][LEDMATRIX_FRAME_MAX_SIZE];	// Aligned for the burst copies
+static uint8_t frontFrame;				// The index of the frame being shown, the other one is written by the host
+static uint8_t isFramePending;			// The back frame is complete and is shown at the next frame tick
+static uint8_t isFrameMode;				// The frames from the host are shown instead of the text
+#ifdef PROFILE
+static PROFILE_latencyTypeDef pendingLatency;	// The stamps of the new message which hasn't been shown yet
+static uint8_t isLatencyPending;
+#endif
+static __ALIGNED(16) uint16_t outputRows[MATRIX_HIGH][MATRIX_MAX_DIGITS];	// The SPI words, aligned for the burst reads
 
 //---------------------------------------------------------------------------
 // FreeRTOS's threads
@@ -50,19 +88,111 @@ static uint8_t rowBuffer;
  */
 void sendToTheMatrixTask(void const *argument)
 {
+	uint8_t selfTestActive = 0;
+	uint32_t selfTestStart = 0;
+	uint8_t isOutput = 0;
+#ifdef PROFILE
+	PROFILE_latencyTypeDef latency;
+	uint8_t isLatencyShown = 0;
+#endif
+
 	MAX7219_init(USED_SPI, USED_PINSPACK, USED_PRESCALER);
 
+	// The size of the output buffer depends only on the chain, not on the message
+	osMutexWait(pVarsMutexHandle, osWaitForever);
+	rowBuffer = OUTPUT_BUFFER_MIN_ROW + 1U;
+	outputBuffer = createOutputBuffer(rowBuffer);
+	resetOutputBuffer(outputBuffer, rowBuffer);
+	osMutexRelease(pVarsMutexHandle);
+
+	BOOT_mark(BOOT_STAGE_DISPLAY_READY);
+
+#ifdef LEDMATRIX_SELF_TEST
+	MAX7219_displayTest(ALL_DIGITS, DISPLAY_TEST_MODE);
+	selfTestStart = osKernelSysTick();
+	selfTestActive = 1;
+#else
+	BOOT_mark(BOOT_STAGE_SELF_TEST_END);
+#endif
+
 	/* Infinite loop */
 	for(;;)
 	{
+		if(selfTestActive && ((osKernelSysTick() - selfTestStart) >= SELF_TEST_DURATION))
+		{
+			MAX7219_displayTest(ALL_DIGITS, NORMAL_OPERATION);
+			selfTestActive = 0;
+			BOOT_mark(BOOT_STAGE_SELF_TEST_END);
+		}
+
+		// The brightness is changed from this thread, because it owns the SPI
+		if(intensityChanged)
+		{
+			intensityChanged = 0;
+			MAX7219_intensity(ALL_DIGITS, intensity);
+		}
+
 		osMutexWait(pVarsMutexHandle, osWaitForever);
 
-		outputOnMatrix(outputBuffer);
-		shiftOutputBuffer(outputBuffer, rowBuffer, MATRIX_HIGH);
+		isOutput = 0;
+
+		if(isFrameMode)
+		{
+			// The frames are swapped only at the tick, so a half-written frame is never shown
+			if(isFramePending)
+			{
+				// The compositing into the back frame has to be over before it's shown
+				COMPOSE_wait();
+
+				frontFrame ^= 1U;
+				isFramePending = 0;
+
+				// The back frame catches up with the front one by DMA while the front one is sent to the matrix
+				MEMDMA_copy(frames[frontFrame ^ 1U], frames[frontFrame], LEDMATRIX_getFrameSize());
+			}
+
+			PROFILE_BEGIN(PROFILE_REGION_OUTPUT);
+			fillOutputRowsFromFrame(frames[frontFrame]);
+			PROFILE_END(PROFILE_REGION_OUTPUT);
+			isOutput = 1;
+
+		} else if(sizeText != 0)	// Nothing is shown until the first message is received
+		{
+			PROFILE_BEGIN(PROFILE_REGION_OUTPUT);
+			fillOutputRows(outputBuffer, rowBuffer);
+			PROFILE_END(PROFILE_REGION_OUTPUT);
+
+			PROFILE_BEGIN(PROFILE_REGION_SHIFT);
+			shiftOutputBuffer(outputBuffer, rowBuffer, MATRIX_HIGH);
+			PROFILE_END(PROFILE_REGION_SHIFT);
+			isOutput = 1;
+
+#ifdef PROFILE
+			// The first frame after the reset of the output buffer has the beginning of the new message
+			isLatencyShown = isLatencyPending;
+			latency = pendingLatency;
+			isLatencyPending = 0;
+#endif
+		}
 
 		osMutexRelease(pVarsMutexHandle);
 
-		osDelay(SPEED_SHIFT);
+		// The rows are sent by DMA without the mutex, the thread sleeps until the last one is latched
+		if(isOutput)
+		{
+			MAX7219_sendRowsDMA(outputRows, SIGNAL_OUTPUT_SENT);
+			osSignalWait(SIGNAL_OUTPUT_SENT, osWaitForever);
+
+			// The chain has the frame even while the self-test lights it up, the end of the test is its own stage
+			BOOT_mark(BOOT_STAGE_FIRST_FRAME);
+
+#ifdef PROFILE
+			if(isLatencyShown) PROFILE_recordLatency(&latency);
+			isLatencyShown = 0;
+#endif
+		}
+
+		osDelay(isFrameMode ? FRAME_PERIOD : speedShift);
 	}
 }
 
@@ -75,7 +205,6 @@ void convertStringIntoDataForMatrixTask(void const *argument)
 {
 	osEvent evt;
 	UART_messageTypeDef *message;
-	uint8_t firstStart = 1;
 
 	/* Infinite loop */
 	for(;;)
@@ -87,15 +216,29 @@ void convertStringIntoDataForMatrixTask(void const *argument)
 			osMutexWait(pVarsMutexHandle, osWaitForever);
 
 			message = evt.value.p;
-			rowBuffer = message->sizeMessage;
 
-			if(!firstStart) vPortFree(outputBuffer);
-			outputBuffer = convertStringIntoDataForMatrix(message, font_ASCII);
+			PROFILE_BEGIN(PROFILE_REGION_CONVERT);
+			appendText(message);
+			PROFILE_END(PROFILE_REGION_CONVERT);
+
+#ifdef PROFILE
+			if(message->flags & UART_MESSAGE_FIRST_CHUNK)
+			{
+				pendingLatency = message->latency;
+				PROFILE_STAMP(pendingLatency.decoded);
+				isLatencyPending = 1;
+			}
+#endif
+
+			// The text takes the matrix back from the frames
+			if(message->flags & UART_MESSAGE_FIRST_CHUNK) isFrameMode = 0;
+
+			// A new message starts from the beginning, the chunks of the same one just extend the text
+			if((message->flags & UART_MESSAGE_FIRST_CHUNK) && (outputBuffer != NULL)) resetOutputBuffer(outputBuffer, rowBuffer);
 
 			osMutexRelease(pVarsMutexHandle);
 
-			if(!firstStart && message->message != getPointerDefaultString()) vPortFree(message->message);
-			firstStart = 0;
+			UART_releaseMessage(message);
 		}
 	}
 }
@@ -135,26 +278,163 @@ void LEDMATRIX_freeRtosInit(void)
 //---------------------------------------------------------------------------
 
 /**
- * @brief	This function outputs information from the output buffer to the LED matrix.
- * @note	A pointer to a dynamic 2D buffer is passed to this function without specifying its size,
- * 			since the "output window" of information corresponds to the number of digits of the LED matrix.
- * 			For example, if a LED matrix module with 4 digits is available, then a dynamic array must be created
- * 			for at least 4 characters. !!!If you create a dynamic array smaller than the LED matrix "output window",
- * 			then this will lead to an overflow of the array!!!.
+ * @brief	This function sets the speed of the creeping line.
+ * @param 	speed - The delay between two shifts of the line in ms. 0 isn't allowed.
+ * @retval	None.
+ */
+void LEDMATRIX_setSpeed(uint8_t speed)
+{
+	if(speed != 0) speedShift = speed;
+}
+
+/**
+ * @brief	This function sets the brightness of the matrix. It is applied before the next frame.
+ * @param 	newIntensity - The brightness. This parameter can be a value of @ref USH_MAX7219_REG_INTENSITY.
+ * @retval	None.
+ */
+void LEDMATRIX_setIntensity(USH_MAX7219_REG_INTENSITY newIntensity)
+{
+	intensity = newIntensity;
+	intensityChanged = 1;
+}
+
+/**
+ * @brief	This function writes the data from the host into the back frame.
+ * @note	The back frame starts as a copy of the last presented one, so only the changed bytes have to be sent.
+ * 			The frame has MATRIX_HIGH bytes per module: module 0 is the extreme one (the first symbol of the text),
+ * 			byte 0 is the line of the first digit register, bit 0 is the column where the text comes from.
+ * @param 	offset - The index of the first byte to be written.
+ * @param 	data - A pointer to the data.
+ * @param 	size - The size of the data.
+ * @retval	1 if the data fits into the frame of the chain, otherwise 0.
+ */
+uint8_t LEDMATRIX_writeFrame(uint16_t offset, const uint8_t *data, uint16_t size)
+{
+	if((offset + size) > LEDMATRIX_getFrameSize()) return 0;
+
+	osMutexWait(pVarsMutexHandle, osWaitForever);
+
+	// The copy of the presented frame into the back one and the compositing may still be running
+	MEMDMA_wait();
+	COMPOSE_wait();
+
+	memcpy(&frames[frontFrame ^ 1U][offset], data, size);
+
+	osMutexRelease(pVarsMutexHandle);
+
+	return 1;
+}
+
+/**
+ * @brief	This function presents the back frame at the next frame tick and switches the matrix to the frames.
+ * @note	When the next frame is written before the tick, the pending one is updated and shown instead.
+ * @retval	None.
+ */
+void LEDMATRIX_presentFrame(void)
+{
+	osMutexWait(pVarsMutexHandle, osWaitForever);
+
+	isFramePending = 1;
+	isFrameMode = 1;
+
+	osMutexRelease(pVarsMutexHandle);
+}
+
+/**
+ * @brief	This function returns the size of the frame of the chain.
+ * @retval	The size of the frame in bytes.
+ */
+uint16_t LEDMATRIX_getFrameSize(void)
+{
+	return (uint16_t)OUTPUT_BUFFER_MIN_ROW * OUTPUT_BUFFER_COLUMN;
+}
+
+/**
+ * @brief	This function fills the rectangle of the back frame with the pattern.
+ * @note	The fill goes on in the background, the frame is presented only after it's over.
+ * @param 	rect - A pointer to the rectangle, see compose.h.
+ * @param 	pattern - The 8 pixels of every line of every module.
+ * @retval	1 if the rectangle fits into the frame of the chain, otherwise 0.
+ */
+uint8_t LEDMATRIX_fillFrame(const COMPOSE_rectTypeDef *rect, uint8_t pattern)
+{
+	if(!isRectInFrame(rect)) return 0;
+
+	osMutexWait(pVarsMutexHandle, osWaitForever);
+
+	MEMDMA_wait();
+	COMPOSE_fill(frames[frontFrame ^ 1U], rect, pattern);
+
+	osMutexRelease(pVarsMutexHandle);
+
+	return 1;
+}
+
+/**
+ * @brief	This function copies the rectangle of the presented frame to another place of the back frame.
+ * @note	The zones are scrolled this way without sending them again. The copy goes on in the background,
+ * 			the frame is presented only after it's over.
+ * @param 	rect - A pointer to the rectangle of the presented frame, see compose.h.
+ * @param 	module - The first module of the rectangle in the back frame.
+ * @param 	line - The first line of the rectangle in the back frame.
+ * @retval	1 if both rectangles fit into the frame of the chain, otherwise 0.
+ */
+uint8_t LEDMATRIX_copyFrame(const COMPOSE_rectTypeDef *rect, uint8_t module, uint8_t line)
+{
+	COMPOSE_rectTypeDef destination = {module, line, rect->modules, rect->lines};
+
+	if(!isRectInFrame(rect) || !isRectInFrame(&destination)) return 0;
+
+	osMutexWait(pVarsMutexHandle, osWaitForever);
+
+	MEMDMA_wait();
+	COMPOSE_copy(frames[frontFrame ^ 1U], frames[frontFrame], rect, module, line);
+
+	osMutexRelease(pVarsMutexHandle);
+
+	return 1;
+}
+
+/**
+ * @brief	This function blends the layer into the rectangle of the back frame.
+ * @param 	rect - A pointer to the rectangle, see compose.h.
+ * @param 	layer - A pointer to the layer, rect->lines bytes for every module of the rectangle.
+ * @param 	mask - A pointer to the mask of the same size or NULL, see COMPOSE_blend.
+ * @retval	1 if the rectangle fits into the frame of the chain, otherwise 0.
+ */
+uint8_t LEDMATRIX_blendFrame(const COMPOSE_rectTypeDef *rect, const uint8_t *layer, const uint8_t *mask)
+{
+	if(!isRectInFrame(rect)) return 0;
+
+	osMutexWait(pVarsMutexHandle, osWaitForever);
+
+	MEMDMA_wait();
+	COMPOSE_blend(frames[frontFrame ^ 1U], rect, layer, mask);
+
+	osMutexRelease(pVarsMutexHandle);
+
+	return 1;
+}
+
+/**
+ * @brief	This function prepares the SPI words of the output buffer for the LED matrix.
+ * @note	The "output window" of information corresponds to the number of modules in the chain which is
+ * 			detected at runtime. If the output buffer has fewer rows than the chain, the rest of the modules
+ * 			are blanked.
  * @param 	outputBuffer - A pointer to output buffer that contains the useful information for
  * 						   outputting to the LED matrix.
+ * @param 	rowOutputBuffer - The number of rows in the dynamic output buffer.
  * @retval	None.
  */
-static void outputOnMatrix(uint8_t** outputBuffer)
+static void fillOutputRows(uint8_t** outputBuffer, uint8_t rowOutputBuffer)
 {
 	for(uint8_t column = 0; column < OUTPUT_BUFFER_COLUMN; column++)
 	{
-		SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, LOW);
-		for(int8_t row = OUTPUT_BUFFER_MIN_ROW - 1; row >= 0; row--)
+		// The word of the farthest module goes first
+		for(uint8_t word = 0, row = OUTPUT_BUFFER_MIN_ROW - 1; word < OUTPUT_BUFFER_MIN_ROW; word++, row--)
 		{
-			SPI_writeData(MATRIX_SPI, column + 1, outputBuffer[row][column]);
+			outputRows[column][word] = (uint16_t)((column + 1U) << 8) | ((row < rowOutputBuffer) ? outputBuffer[row][column] : 0x00U);
 		}
-		SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, HIGH);
 	}
 }
 
@@ -167,7 +447,9 @@ static void outputOnMatrix(uint8_t** outputBuffer)
  * 			shifted to the right. Also, when we check the extreme bit for a 1 in order to move it to the adjacent
  * 			matrix, then we need to keep track of the low bit in the code, and not the high bit.
  * 			And move it to the place of the older one in the adjacent matrix, and not the younger one.
- * 			!!!Note about the pointer. Read outputOnMatrix function's description.
+ * 			!!!Note about the pointer. Read fillOutputRows function's description.
+ * @note	The extreme matrix pushes its column out, the last row takes the next symbol of the text when
+ * 			the previous one has been shifted out of it.
  * @param 	outputBuffer - A pointer to output buffer that contains the useful information for
  * 						   outputting to the LED matrix.
  * @param 	rowOutputBuffer - The number of rows in the dynamic output buffer.
@@ -176,62 +458,156 @@ static void outputOnMatrix(uint8_t** outputBuffer)
  */
 static void shiftOutputBuffer(uint8_t** outputBuffer, uint8_t rowOutputBuffer, uint8_t columnOutputBuffer)
 {
-	uint8_t *tempBuffer = (uint8_t*)pvPortMalloc(columnOutputBuffer * sizeof(uint8_t));
-
 	for(uint8_t row = 0; row < rowOutputBuffer; row++)
 	{
 		for(uint8_t column = 0; column < columnOutputBuffer; column++)
 		{
-			if(row == 0)				// For the extreme matrix, we move the transitional 1 array from the buffer.
-			{
-				tempBuffer[column] = outputBuffer[row][column] & 0x01;
-				outputBuffer[row][column] = outputBuffer[row][column] >> 1;
-			} else
+			if(row != 0)				// The extreme matrix loses its column
 			{
 				outputBuffer[row - 1][column] |= (outputBuffer[row][column] & 0x01) << SHIFT_BYTE;
-				outputBuffer[row][column] = outputBuffer[row][column] >> 1;
 			}
 
-			if(row == rowOutputBuffer - 1)	// For the last matrix, add transition units from the buffer.
-			{
-				outputBuffer[row][column] = outputBuffer[row][column] | (tempBuffer[column] << SHIFT_BYTE);
-			}
+			outputBuffer[row][column] = outputBuffer[row][column] >> 1;
 		}
 	}
-	vPortFree(tempBuffer);
+
+	if(++shiftCount == ASCII_COLUMN)
+	{
+		loadSymbol(outputBuffer[rowOutputBuffer - 1], font_ASCII);
+		shiftCount = 0;
+	}
 }
 
 /**
- * @brief 	This function converts the received message into the special data for the LED matrix.
- * @param 	message - A pointer to the message structure.
- * @param 	fontArray - The special array that has ASCII font information.
+ * @brief 	This function allocates the output buffer.
+ * @param 	rowOutputBuffer - The number of rows in the dynamic output buffer.
  * @retval	A pointer to a dynamic 2D buffer.
  */
-static uint8_t** convertStringIntoDataForMatrix(UART_messageTypeDef *message, const uint8_t fontArray[][ASCII_COLUMN])
+static uint8_t** createOutputBuffer(uint8_t rowOutputBuffer)
+{
+	uint8_t **outputBuffer = (uint8_t**)HEAP_malloc(rowOutputBuffer * sizeof(uint8_t*) + sizeof(uint8_t) * OUTPUT_BUFFER_COLUMN * rowOutputBuffer, HEAP_TAG_LEDMATRIX);
+	uint8_t *startData = ((uint8_t*)outputBuffer + rowOutputBuffer * sizeof(uint8_t*));
+
+	for(uint8_t counter = 0; counter < rowOutputBuffer; counter++)
+		outputBuffer[counter] = startData + counter * OUTPUT_BUFFER_COLUMN;
+
+	return outputBuffer;
+}
+
+/**
+ * @brief 	This function fills the output buffer with the beginning of the text.
+ * @param 	outputBuffer - A pointer to output buffer.
+ * @param 	rowOutputBuffer - The number of rows in the dynamic output buffer.
+ * @retval	None.
+ */
+static void resetOutputBuffer(uint8_t** outputBuffer, uint8_t rowOutputBuffer)
+{
+	nextSymbol = 0;
+	shiftCount = 0;
+
+	for(uint8_t row = 0; row < rowOutputBuffer; row++)
+	{
+		loadSymbol(outputBuffer[row], font_ASCII);
+	}
+}
+
+/**
+ * @brief 	This function rasterizes the next symbol of the text into the row of the output buffer.
+ * @note	A short message is padded with spaces up to the number of modules in the chain, then the text
+ * 			starts again. While the chunks of the message are still coming, spaces are loaded after the
+ * 			received part, so the text continues as soon as the next chunk comes.
+ * @param 	outputRow - A pointer to the row of the output buffer.
+ * @param 	fontArray - The special array that has ASCII font information.
+ * @retval	None.
+ */
+static void loadSymbol(uint8_t* outputRow, const uint8_t fontArray[][ASCII_COLUMN])
 {
-	uint8_t sizeMessage = message->sizeMessage;
+	uint16_t sizeLoop = (sizeText < OUTPUT_BUFFER_MIN_ROW) ? OUTPUT_BUFFER_MIN_ROW : sizeText;
 	uint8_t symbol = 0;
 
-/* -------------------------------- Dynamic allocation memory ---------------------------------------*/
+	if(nextSymbol < sizeText)
+	{
+		symbol = (uint8_t)(text[nextSymbol] - ASCII_SHIFT);
+		if(symbol >= ASCII_ROW) symbol = 0;	// see font_ASCII buffer for more information
+	}
 
-	uint8_t **outputBuffer = (uint8_t**)pvPortMalloc(sizeMessage * sizeof(uint8_t*) + sizeof(uint8_t) * OUTPUT_BUFFER_COLUMN * sizeMessage);
-	uint8_t *startData = ((uint8_t*)outputBuffer + sizeMessage * sizeof(uint8_t*));
+	memcpy(outputRow, fontArray[symbol], OUTPUT_BUFFER_COLUMN);
 
-	for(uint8_t counter = 0; counter < sizeMessage; counter++)
-		outputBuffer[counter] = startData + counter * OUTPUT_BUFFER_COLUMN;
+	if((nextSymbol < sizeText) || isTextComplete) nextSymbol++;
+	if(isTextComplete && (nextSymbol >= sizeLoop)) nextSymbol = 0;
+}
+
+/**
+ * @brief 	This function copies the chunk of the received message into the text.
+ * @note	A packed message is decoded straight into the text, see textcodec.h.
+ * @note	The message has to be copied right after it is received from the queue, because the region
+ * 			of the circular RX buffer is written again as the new data comes. The chunk which was overwritten
+ * 			before the copy is dropped with the rest of its line.
+ * @param 	message - A pointer to the message structure.
+ * @retval	None.
+ */
+static void appendText(const UART_messageTypeDef *message)
+{
+	uint16_t sizeBefore = 0;
+
+	if(message->flags & UART_MESSAGE_FIRST_CHUNK)
+	{
+		sizeText = 0;
+		isLineBroken = 0;
+	}
 
-/* ------ Filling the created array with information about symbols for output to the LED matrix -----*/
+	// The rest of the line which lost a chunk is skipped, the text ends where the lost chunk began
+	if(isLineBroken) return;
 
-	for(uint8_t row = 0; row < sizeMessage; row++)
+	sizeBefore = sizeText;
+
+	if(message->flags & UART_MESSAGE_PACKED)
+	{
+		sizeText = TEXTCODEC_decode(message, text, sizeText, TEXT_SIZE);
+	} else
 	{
-		for(uint8_t column = 0; column < OUTPUT_BUFFER_COLUMN; column++)
+		for(uint16_t index = 0; (index < message->sizeMessage) && (sizeText < TEXT_SIZE); index++)
 		{
-			symbol = (uint8_t)(message->message[row] - ASCII_SHIFT);
-			if(symbol >= ASCII_ROW) symbol = 0;	// see font_ASCII buffer for more information
+			text[sizeText++] = UART_getSymbol(message, index);
+		}
+	}
 
-			outputBuffer[row][column] = font_ASCII[symbol][column];
+	if(!UART_checkMessage(message))
+	{
+		sizeText = sizeBefore;
+		isLineBroken = 1;
+		isTextComplete = 1;
+		return;
+	}
+
+	isTextComplete = (message->flags & UART_MESSAGE_LAST_CHUNK) ? 1 : 0;
+}
+
+/**
+ * @brief	This function prepares the SPI words of the frame from the host for the LED matrix.
+ * @param 	frame - A pointer to the frame, see LEDMATRIX_writeFrame for its layout.
+ * @retval	None.
+ */
+static void fillOutputRowsFromFrame(const uint8_t* frame)
+{
+	for(uint8_t column = 0; column < OUTPUT_BUFFER_COLUMN; column++)
+	{
+		// The word of the farthest module goes first
+		for(uint8_t word = 0, row = OUTPUT_BUFFER_MIN_ROW - 1; word < OUTPUT_BUFFER_MIN_ROW; word++, row--)
+		{
+			outputRows[column][word] = (uint16_t)((column + 1U) << 8) | frame[row * OUTPUT_BUFFER_COLUMN + column];
 		}
 	}
+}
 
-	return outputBuffer;
+/**
+ * @brief	This function checks the rectangle against the frame of the chain.
+ * @param 	rect - A pointer to the rectangle.
+ * @retval	1 if the rectangle isn't empty and fits into the frame, otherwise 0.
+ */
+static uint8_t isRectInFrame(const COMPOSE_rectTypeDef *rect)
+{
+	return (rect->modules != 0) && (rect->lines != 0) &&
+		   (((uint16_t)rect->module + rect->modules) <= OUTPUT_BUFFER_MIN_ROW) &&
+		   (((uint16_t)rect->line + rect->lines) <= OUTPUT_BUFFER_COLUMN);
 }
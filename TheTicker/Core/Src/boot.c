@@ -0,0 +1,224 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "boot.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define CLOCKS_PER_US(CLOCK)		((CLOCK) / 1000000U)
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Boot timeline record structure
+ */
+typedef struct
+{
+	uint32_t cycles;		/* DWT cycle counter value at the moment of the mark */
+	uint32_t coreClock;		/* Core clock frequency at the moment of the mark */
+	uint8_t isMarked;		/* The stage has been reached */
+} BOOT_recordTypeDef;
+
+//---------------------------------------------------------------------------
+// Static function prototypes
+//---------------------------------------------------------------------------
+static uint16_t appendString(uint8_t *buffer, uint16_t index, uint16_t size, const char *string);
+static uint16_t appendNumber(uint8_t *buffer, uint16_t index, uint16_t size, uint32_t number);
+static uint32_t getElapsed(uint8_t stage);
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+static BOOT_recordTypeDef timeline[BOOT_STAGE_COUNT];
+static const char* const stageNames[BOOT_STAGE_COUNT] = {"reset ", ", clock ", ", scheduler ", ", display ", ", first frame ",
+														 ", self-test "};
+
+//---------------------------------------------------------------------------
+// Initialization functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function starts the DWT cycle counter and marks the reset stage.
+ * @note	It has to be called as the first instruction of the main function. Time spent in
+ * 			the startup code before main is not taken into account.
+ * @retval	None.
+ */
+void BOOT_init(void)
+{
+	// Enable the DWT cycle counter
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0U;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	BOOT_mark(BOOT_STAGE_RESET);
+}
+
+//---------------------------------------------------------------------------
+// Others functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function records the moment when the boot stage is reached.
+ * @note	Only the first call for every stage is recorded. When the last of the stages is marked,
+ * 			BOOT_completeCallback is called.
+ * @param 	stage - The boot stage. This parameter can be a value of @ref BOOT_stage.
+ * @retval	None.
+ */
+void BOOT_mark(BOOT_stage stage)
+{
+	if((stage >= BOOT_STAGE_COUNT) || timeline[stage].isMarked) return;
+
+	timeline[stage].cycles		= DWT->CYCCNT;
+	timeline[stage].coreClock	= SystemCoreClock;
+	timeline[stage].isMarked	= 1;
+
+	for(uint8_t current = BOOT_STAGE_RESET; current < BOOT_STAGE_COUNT; current++)
+	{
+		if(!timeline[current].isMarked) return;
+	}
+
+	BOOT_completeCallback();
+}
+
+/**
+ * @brief 	This function returns the time from the reset to the boot stage.
+ * @note	Every interval is converted with the core clock which was used at its beginning, so
+ * 			the interval from the reset to the clock switch is counted with the HSI frequency.
+ * 			The stages are walked in the order they were reached, the first frame and the end of the
+ * 			self-test can come in either order.
+ * @param 	stage - The boot stage. This parameter can be a value of @ref BOOT_stage.
+ * @retval	The time in us or 0 if the stage hasn't been reached yet.
+ */
+uint32_t BOOT_getStageTime(BOOT_stage stage)
+{
+	uint32_t time = 0;
+	uint8_t previous = BOOT_STAGE_RESET;
+	uint8_t next = BOOT_STAGE_RESET;
+
+	if((stage >= BOOT_STAGE_COUNT) || !timeline[stage].isMarked) return 0;
+
+	while(previous != stage)
+	{
+		next = stage;
+
+		// The earliest stage after the previous one which isn't later than the requested one
+		for(uint8_t current = BOOT_STAGE_RESET + 1; current < BOOT_STAGE_COUNT; current++)
+		{
+			if(!timeline[current].isMarked || (getElapsed(current) <= getElapsed(previous))) continue;
+			if(getElapsed(current) < getElapsed(next)) next = current;
+		}
+
+		time += (timeline[next].cycles - timeline[previous].cycles) / CLOCKS_PER_US(timeline[previous].coreClock);
+		previous = next;
+	}
+
+	return time;
+}
+
+/**
+ * @brief 	This function prints the boot timeline into the buffer as a text line.
+ * @param 	buffer - A pointer to the buffer for the report.
+ * @param 	size - The size of the buffer. BOOT_REPORT_SIZE is enough for the full report.
+ * @retval	The length of the report.
+ */
+uint16_t BOOT_getReport(uint8_t *buffer, uint16_t size)
+{
+	uint16_t index = 0;
+
+	index = appendString(buffer, index, size, "Boot timeline (us): ");
+
+	for(uint8_t stage = BOOT_STAGE_RESET; stage < BOOT_STAGE_COUNT; stage++)
+	{
+		index = appendString(buffer, index, size, stageNames[stage]);
+
+		if(timeline[stage].isMarked)
+		{
+			index = appendNumber(buffer, index, size, BOOT_getStageTime(stage));
+		} else
+		{
+			index = appendString(buffer, index, size, "-");
+		}
+	}
+
+	index = appendString(buffer, index, size, "\r\n");
+
+	return index;
+}
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function copies the string to the buffer.
+ * @param 	buffer - A pointer to the destination buffer.
+ * @param 	index - The position in the buffer to start from.
+ * @param 	size - The size of the buffer.
+ * @param 	string - A pointer to the null-terminated string.
+ * @retval	The position in the buffer after the copied string.
+ */
+static uint16_t appendString(uint8_t *buffer, uint16_t index, uint16_t size, const char *string)
+{
+	while((*string != '\0') && (index < size))
+	{
+		buffer[index++] = (uint8_t)*string++;
+	}
+
+	return index;
+}
+
+/**
+ * @brief 	This function prints the decimal number to the buffer.
+ * @param 	buffer - A pointer to the destination buffer.
+ * @param 	index - The position in the buffer to start from.
+ * @param 	size - The size of the buffer.
+ * @param 	number - The number to be printed.
+ * @retval	The position in the buffer after the printed number.
+ */
+static uint16_t appendNumber(uint8_t *buffer, uint16_t index, uint16_t size, uint32_t number)
+{
+	char digits[10];
+	uint8_t count = 0;
+
+	do
+	{
+		digits[count++] = (char)('0' + (number % 10U));
+		number /= 10U;
+	} while(number != 0U);
+
+	while((count > 0) && (index < size))
+	{
+		buffer[index++] = (uint8_t)digits[--count];
+	}
+
+	return index;
+}
+
+/**
+ * @brief 	This function returns the cycles from the reset to the stage.
+ * @note	The cycle counter wraps in 23 s at 180 MHz, the boot is much shorter.
+ * @param 	stage - The boot stage. This parameter can be a value of @ref BOOT_stage.
+ * @retval	The number of cycles.
+ */
+static uint32_t getElapsed(uint8_t stage)
+{
+	return timeline[stage].cycles - timeline[BOOT_STAGE_RESET].cycles;
+}
+
+//---------------------------------------------------------------------------
+// Callbacks
+//---------------------------------------------------------------------------
+
+/**
+  * @brief  Boot complete callback. It is called when the last of the stages is marked.
+  * 		NOTE: This function should not be modified, when the callback is needed,
+           	   	  the BOOT_completeCallback could be implemented in the user file.
+  * @retval None.
+  */
+__WEAK void BOOT_completeCallback(void)
+{
+
+}
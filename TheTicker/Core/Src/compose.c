@@ -0,0 +1,271 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "compose.h"
+#include "main.h"
+#include "string.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define FRAME_PITCH				(MATRIX_HIGH)		// The bytes of a module in the frame
+
+#define PREEMPTION_PRIORITY		(5U)
+#define SUBPRIORITY				(0U)
+
+#define DMA2D_MODE_M2M			((uint32_t)0x00000000)
+#define DMA2D_MODE_R2M			(DMA2D_CR_MODE)
+#define DMA2D_CM_ARGB4444		((uint32_t)0x04)	// The narrowest output of the fill, 2 bytes per pixel
+#define DMA2D_CM_L8				((uint32_t)0x05)	// 1 byte per pixel
+#define DMA2D_PL_POSITION		(16U)
+
+#define DMA2D_INTERRUPTS		(DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE)
+
+// The flags have the same bits in ISR and IFCR
+#define DMA2D_FLAGS				(DMA2D_IFCR_CTCIF | DMA2D_IFCR_CTEIF | DMA2D_IFCR_CCEIF)
+
+//---------------------------------------------------------------------------
+// Descriptions of FreeRTOS elements
+//---------------------------------------------------------------------------
+static osSemaphoreId engineFreeHandle;
+
+//---------------------------------------------------------------------------
+// Static function prototypes
+//---------------------------------------------------------------------------
+static void fillByCpu(uint8_t *frame, const COMPOSE_rectTypeDef *rect, uint8_t pattern);
+static void copyByCpu(uint8_t *destination, const uint8_t *source, const COMPOSE_rectTypeDef *rect, uint8_t module, uint8_t line);
+
+#ifdef COMPOSE_DMA2D
+static void startTransfer(uint32_t mode);
+#endif
+
+//---------------------------------------------------------------------------
+// Initialization functions
+//---------------------------------------------------------------------------
+
+/**
+  * @brief  FreeRTOS initialization for compose module
+  * @param  None
+  * @retval None
+  */
+void COMPOSE_freeRtosInit(void)
+{
+	// Create the semaphore(s)
+	// definition and creation of the semaphore which is free while no operation is running
+	osSemaphoreDef(composeFree);
+	engineFreeHandle = osSemaphoreCreate(osSemaphore(composeFree), 1);
+
+#ifdef DEBUG
+	vQueueAddToRegistry(engineFreeHandle, "compose engine");
+#endif
+
+#ifdef COMPOSE_DMA2D
+	// Enable DMA2D clock
+	RCC->AHB1ENR |= RCC_AHB1ENR_DMA2DEN;
+
+	// DMA2D interrupt init
+	MISC_NVIC_SetPriority(DMA2D_IRQn, PREEMPTION_PRIORITY, SUBPRIORITY);
+	MISC_NVIC_EnableIRQ(DMA2D_IRQn);
+#endif
+}
+
+//---------------------------------------------------------------------------
+// Others functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function starts filling every line of the rectangle with the pattern.
+ * @note	The previous operation is waited for. The rectangle which DMA2D doesn't take is filled by CPU before
+ * 			the function returns. The frame can't be touched until COMPOSE_wait returns.
+ * @param 	frame - A pointer to the frame.
+ * @param 	rect - A pointer to the rectangle. It has to be inside the frame.
+ * @param 	pattern - The 8 pixels of every line of every module.
+ * @retval	None.
+ */
+void COMPOSE_fill(uint8_t *frame, const COMPOSE_rectTypeDef *rect, uint8_t pattern)
+{
+	osSemaphoreWait(engineFreeHandle, osWaitForever);
+
+#ifdef COMPOSE_DMA2D
+	assert_param(IS_MEMDMA_ADDRESS(frame));
+
+	if((((rect->line | rect->lines) & 0x01U) == 0) && (((uint16_t)rect->modules * rect->lines) >= COMPOSE_DMA2D_THRESHOLD))
+	{
+		// Two lines make a pixel
+		DMA2D->OPFCCR = DMA2D_CM_ARGB4444;
+		DMA2D->OCOLR = pattern * 0x0101U;
+		DMA2D->OMAR = (uint32_t)&frame[rect->module * FRAME_PITCH + rect->line];
+		DMA2D->OOR = (FRAME_PITCH - rect->lines) / 2U;
+		DMA2D->NLR = ((uint32_t)(rect->lines / 2U) << DMA2D_PL_POSITION) | rect->modules;
+
+		startTransfer(DMA2D_MODE_R2M);
+		return;
+	}
+#endif
+
+	fillByCpu(frame, rect, pattern);
+
+	osSemaphoreRelease(engineFreeHandle);
+}
+
+/**
+ * @brief 	This function starts copying the rectangle of one frame into another.
+ * @note	The previous operation is waited for. The rectangle which DMA2D doesn't take is copied by CPU before
+ * 			the function returns. The frames can't be touched until COMPOSE_wait returns.
+ * @param 	destination - A pointer to the destination frame. It can't be the source frame.
+ * @param 	source - A pointer to the source frame.
+ * @param 	rect - A pointer to the rectangle of the source frame. It has to be inside the frame.
+ * @param 	module - The first module of the rectangle in the destination frame.
+ * @param 	line - The first line of the rectangle in the destination frame.
+ * @retval	None.
+ */
+void COMPOSE_copy(uint8_t *destination, const uint8_t *source, const COMPOSE_rectTypeDef *rect, uint8_t module, uint8_t line)
+{
+	osSemaphoreWait(engineFreeHandle, osWaitForever);
+
+#ifdef COMPOSE_DMA2D
+	assert_param(IS_MEMDMA_ADDRESS(destination));
+	assert_param(IS_MEMDMA_ADDRESS(source));
+
+	if(((uint16_t)rect->modules * rect->lines) >= COMPOSE_DMA2D_THRESHOLD)
+	{
+		// Without the conversion the pixel size is the one of the foreground, a byte
+		DMA2D->FGPFCCR = DMA2D_CM_L8;
+		DMA2D->FGMAR = (uint32_t)&source[rect->module * FRAME_PITCH + rect->line];
+		DMA2D->FGOR = FRAME_PITCH - rect->lines;
+		DMA2D->OMAR = (uint32_t)&destination[module * FRAME_PITCH + line];
+		DMA2D->OOR = FRAME_PITCH - rect->lines;
+		DMA2D->NLR = ((uint32_t)rect->lines << DMA2D_PL_POSITION) | rect->modules;
+
+		startTransfer(DMA2D_MODE_M2M);
+		return;
+	}
+#endif
+
+	copyByCpu(destination, source, rect, module, line);
+
+	osSemaphoreRelease(engineFreeHandle);
+}
+
+/**
+ * @brief 	This function blends the layer into the rectangle of the frame pixel by pixel.
+ * @note	The previous operation is waited for, the layer is blended by CPU before the function returns.
+ * @param 	frame - A pointer to the frame.
+ * @param 	rect - A pointer to the rectangle. It has to be inside the frame.
+ * @param 	layer - A pointer to the layer, rect->lines bytes for every module of the rectangle.
+ * @param 	mask - A pointer to the mask of the same size as the layer, its set bits take the pixels of the layer and
+ * 				   the clear ones keep the pixels of the frame. NULL - the lit pixels of the layer are drawn over the frame.
+ * @retval	None.
+ */
+void COMPOSE_blend(uint8_t *frame, const COMPOSE_rectTypeDef *rect, const uint8_t *layer, const uint8_t *mask)
+{
+	uint8_t *destination = NULL;
+
+	osSemaphoreWait(engineFreeHandle, osWaitForever);
+
+	for(uint8_t module = 0; module < rect->modules; module++)
+	{
+		destination = &frame[(rect->module + module) * FRAME_PITCH + rect->line];
+
+		for(uint8_t line = 0; line < rect->lines; line++)
+		{
+			if(mask == NULL)
+			{
+				destination[line] |= *layer;
+			} else
+			{
+				destination[line] = (destination[line] & (uint8_t)~*mask) | (*layer & *mask);
+				mask++;
+			}
+
+			layer++;
+		}
+	}
+
+	osSemaphoreRelease(engineFreeHandle);
+}
+
+/**
+ * @brief 	This function blocks the calling thread until the running operation is over.
+ * @retval	None.
+ */
+void COMPOSE_wait(void)
+{
+	osSemaphoreWait(engineFreeHandle, osWaitForever);
+	osSemaphoreRelease(engineFreeHandle);
+}
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function fills every line of the rectangle with the pattern by CPU.
+ * @param 	frame - A pointer to the frame.
+ * @param 	rect - A pointer to the rectangle.
+ * @param 	pattern - The 8 pixels of every line of every module.
+ * @retval	None.
+ */
+static void fillByCpu(uint8_t *frame, const COMPOSE_rectTypeDef *rect, uint8_t pattern)
+{
+	for(uint8_t module = rect->module; module < (rect->module + rect->modules); module++)
+	{
+		memset(&frame[module * FRAME_PITCH + rect->line], pattern, rect->lines);
+	}
+}
+
+/**
+ * @brief 	This function copies the rectangle of one frame into another by CPU.
+ * @param 	destination - A pointer to the destination frame.
+ * @param 	source - A pointer to the source frame.
+ * @param 	rect - A pointer to the rectangle of the source frame.
+ * @param 	module - The first module of the rectangle in the destination frame.
+ * @param 	line - The first line of the rectangle in the destination frame.
+ * @retval	None.
+ */
+static void copyByCpu(uint8_t *destination, const uint8_t *source, const COMPOSE_rectTypeDef *rect, uint8_t module, uint8_t line)
+{
+	for(uint8_t counter = 0; counter < rect->modules; counter++)
+	{
+		memcpy(&destination[(module + counter) * FRAME_PITCH + line],
+			   &source[(rect->module + counter) * FRAME_PITCH + rect->line], rect->lines);
+	}
+}
+
+#ifdef COMPOSE_DMA2D
+/**
+ * @brief 	This function starts DMA2D with the addresses and the sizes which are already programmed.
+ * @param 	mode - DMA2D_MODE_M2M or DMA2D_MODE_R2M.
+ * @retval	None.
+ */
+static void startTransfer(uint32_t mode)
+{
+	// Clear interrupt flags
+	DMA2D->IFCR = DMA2D_FLAGS;
+
+	// Enable interrupts and start
+	DMA2D->CR = mode | DMA2D_INTERRUPTS | DMA2D_CR_START;
+}
+#endif
+
+//---------------------------------------------------------------------------
+// Interrupt handlers
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function handles the end of the DMA2D operation. The engine is free for the next operation.
+ * @note	A transfer error can happen only with the addresses DMA2D can't reach, it frees the engine as well.
+ * @retval	None.
+ */
+void COMPOSE_IRQHandler(void)
+{
+#ifdef COMPOSE_DMA2D
+	if(DMA2D->ISR & DMA2D_FLAGS)
+	{
+		DMA2D->IFCR = DMA2D_FLAGS;
+		DMA2D->CR &= ~DMA2D_INTERRUPTS;
+
+		osSemaphoreRelease(engineFreeHandle);
+	}
+#endif
+}
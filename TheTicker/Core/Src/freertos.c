@@ -22,6 +22,23 @@ void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackTy
 	*pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
 }
 
+#if (configCHECK_FOR_STACK_OVERFLOW != 0)
+// vApplicationStackOverflowHook prototype (linked to configCHECK_FOR_STACK_OVERFLOW)
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName);
+
+// The name of the thread for the debugger, the memory around the broken stack can't be trusted anymore
+static const char * volatile overflowedTaskName;
+
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
+{
+	(void)xTask;
+
+	taskDISABLE_INTERRUPTS();
+	overflowedTaskName = pcTaskName;
+	for( ;; );
+}
+#endif
+
 //---------------------------------------------------------------------------
 // Initialization functions
 //---------------------------------------------------------------------------
@@ -33,16 +50,31 @@ void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackTy
   */
 void freeRtosInit(void)
 {
+	// The threads, queues and mutexes of every module are charged to its tag of the heap statistics
+	HEAP_setTag(HEAP_TAG_MEMDMA);
+	MEMDMA_freeRtosInit();
+	HEAP_setTag(HEAP_TAG_COMPOSE);
+	COMPOSE_freeRtosInit();
+	HEAP_setTag(HEAP_TAG_MONITOR);
+	MONITOR_freeRtosInit();
+
 #ifdef HEARTBEAT
+	HEAP_setTag(HEAP_TAG_HEARTBEAT);
 	HEARTBEAT_freeRtosInit();
 #endif
 
 #ifdef LEDMATRIX
+	HEAP_setTag(HEAP_TAG_LEDMATRIX);
 	LEDMATRIX_freeRtosInit();
 #endif
 
 #ifdef UART
+	HEAP_setTag(HEAP_TAG_UART);
 	UART_freeRtosInit();
+	HEAP_setTag(HEAP_TAG_LOG);
+	LOG_freeRtosInit();		// The log is drained through the U(S)ART
 #endif
 
+	HEAP_setTag(HEAP_TAG_KERNEL);
+
 }
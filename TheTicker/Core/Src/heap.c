@@ -0,0 +1,205 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "heap.h"
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Live block structure
+ */
+typedef struct
+{
+	void *address;						/* The address given to the caller, NULL if the record is free */
+	uint16_t size;						/* The size of the block */
+	uint8_t tag;						/* The tag the block is charged to */
+} HEAP_blockTypeDef;
+
+//---------------------------------------------------------------------------
+// Static function prototypes
+//---------------------------------------------------------------------------
+static uint8_t getSizeClass(uint32_t size);
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+static HEAP_tag currentTag;
+static HEAP_blockTypeDef blocks[HEAP_TRACK_MAX];
+static HEAP_tagTypeDef tags[HEAP_TAG_COUNT];
+static uint32_t sizeClasses[HEAP_SIZE_CLASS_COUNT];
+static uint32_t untracked;
+
+//---------------------------------------------------------------------------
+// Others functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function sets the tag of the blocks which are taken without HEAP_malloc.
+ * @note	It's called before the scheduler starts only, see freertos.c.
+ * @param 	tag - The tag. This parameter can be a value of @ref HEAP_tag.
+ * @retval	None.
+ */
+void HEAP_setTag(HEAP_tag tag)
+{
+	assert_param(tag < HEAP_TAG_COUNT);
+
+	currentTag = tag;
+}
+
+/**
+ * @brief 	This function takes a block from the heap and charges it to the tag.
+ * @note	The block is returned with vPortFree.
+ * @param 	size - The size of the block.
+ * @param 	tag - The tag. This parameter can be a value of @ref HEAP_tag.
+ * @retval	A pointer to the block, NULL if the heap can't give it.
+ */
+void* HEAP_malloc(size_t size, HEAP_tag tag)
+{
+	HEAP_tag previousTag;
+	void *block = NULL;
+
+	assert_param(tag < HEAP_TAG_COUNT);
+
+	// No other thread can allocate between the tag and the hook
+	vTaskSuspendAll();
+
+	previousTag = currentTag;
+	currentTag = tag;
+
+	block = pvPortMalloc(size);
+
+	currentTag = previousTag;
+
+	(void)xTaskResumeAll();
+
+	return block;
+}
+
+/**
+ * @brief 	This function copies the statistics of the heap.
+ * @param 	stats - A pointer to the structure for the copy.
+ * @retval	None.
+ */
+void HEAP_getStats(HEAP_statsTypeDef *stats)
+{
+	HeapStats_t heapStats;
+
+	vPortGetHeapStats(&heapStats);
+
+	stats->freeBytes		= heapStats.xAvailableHeapSpaceInBytes;
+	stats->minFreeBytes		= heapStats.xMinimumEverFreeBytesRemaining;
+	stats->largestFreeBlock	= heapStats.xSizeOfLargestFreeBlockInBytes;
+	stats->freeBlocks		= heapStats.xNumberOfFreeBlocks;
+	stats->fragmentation	= (heapStats.xAvailableHeapSpaceInBytes != 0) ?
+			(uint16_t)(1000U - ((uint64_t)heapStats.xSizeOfLargestFreeBlockInBytes * 1000U) / heapStats.xAvailableHeapSpaceInBytes) : 0U;
+
+	vTaskSuspendAll();
+
+	stats->untracked = untracked;
+
+	for(uint8_t sizeClass = 0; sizeClass < HEAP_SIZE_CLASS_COUNT; sizeClass++)
+	{
+		stats->sizeClasses[sizeClass] = sizeClasses[sizeClass];
+	}
+
+	(void)xTaskResumeAll();
+}
+
+/**
+ * @brief 	This function copies the statistics of the tag.
+ * @param 	tag - The tag. This parameter can be a value of @ref HEAP_tag.
+ * @param 	statistics - A pointer to the structure for the copy.
+ * @retval	1 if the tag exists, otherwise 0.
+ */
+uint8_t HEAP_getTag(HEAP_tag tag, HEAP_tagTypeDef *statistics)
+{
+	if(tag >= HEAP_TAG_COUNT) return 0;
+
+	vTaskSuspendAll();
+
+	*statistics = tags[tag];
+
+	(void)xTaskResumeAll();
+
+	return 1;
+}
+
+/**
+ * @brief 	This function charges the taken block to the current tag.
+ * @note	It's the traceMALLOC hook of heap_4, it's called with the scheduler suspended.
+ * @param 	address - A pointer to the block, NULL if the heap couldn't give it.
+ * @param 	size - The size of the block.
+ * @retval	None.
+ */
+void HEAP_traceMalloc(void *address, uint32_t size)
+{
+	HEAP_tagTypeDef *statistics = &tags[currentTag];
+	uint8_t block = 0;
+
+	if(address == NULL)
+	{
+		statistics->failures++;
+		return;
+	}
+
+	statistics->allocations++;
+	statistics->bytes += size;
+	sizeClasses[getSizeClass(size)]++;
+
+	while((block < HEAP_TRACK_MAX) && (blocks[block].address != NULL)) block++;
+
+	// Its free can't be found, so the block stays charged to the tag until the restart
+	if(block == HEAP_TRACK_MAX)
+	{
+		untracked++;
+		return;
+	}
+
+	blocks[block].address	= address;
+	blocks[block].size		= (uint16_t)size;
+	blocks[block].tag		= (uint8_t)currentTag;
+}
+
+/**
+ * @brief 	This function releases the returned block from its tag.
+ * @note	It's the traceFREE hook of heap_4, it's called with the scheduler suspended.
+ * @param 	address - A pointer to the block.
+ * @param 	size - The size of the block, it can be bigger than the taken one if heap_4 didn't split the free block.
+ * @retval	None.
+ */
+void HEAP_traceFree(void *address, uint32_t size)
+{
+	HEAP_tagTypeDef *statistics = NULL;
+
+	for(uint8_t block = 0; block < HEAP_TRACK_MAX; block++)
+	{
+		if(blocks[block].address != address) continue;
+
+		// The size of the allocation, so the bytes of the tag go back to 0
+		statistics = &tags[blocks[block].tag];
+		statistics->frees++;
+		statistics->bytes -= blocks[block].size;
+
+		blocks[block].address = NULL;
+
+		return;
+	}
+}
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function finds the size class of the block.
+ * @param 	size - The size of the block.
+ * @retval	The size class, 0..HEAP_SIZE_CLASS_COUNT - 1.
+ */
+static uint8_t getSizeClass(uint32_t size)
+{
+	uint32_t sizeClass = 32U - __CLZ(size);
+
+	return (sizeClass >= HEAP_SIZE_CLASS_COUNT) ? (uint8_t)(HEAP_SIZE_CLASS_COUNT - 1U) : (uint8_t)sizeClass;
+}
@@ -0,0 +1,386 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "log.h"
+#include <stdarg.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define LOG_BUFFER_SIZE			(1024U)		// It has to be a power of two not bigger than 32768
+#define LOG_BUFFER_MASK			(LOG_BUFFER_SIZE - 1U)
+
+#define LOG_FLUSH_PERIOD		((uint32_t)20)		// ms
+#define SIGNAL_LOG_SENT			((int32_t)0x01)
+
+// The reservation word keeps the head of the ring and the number of writers which are copying their records,
+// so both are changed by one exclusive store
+#define WRITERS_SHIFT			(16U)
+#define WRITER					((uint32_t)1 << WRITERS_SHIFT)
+#define HEAD_MASK				((uint32_t)0xFFFF)
+
+//---------------------------------------------------------------------------
+// Descriptions of FreeRTOS elements
+//---------------------------------------------------------------------------
+static osThreadId logTaskHandle;
+
+//---------------------------------------------------------------------------
+// Static function prototypes
+//---------------------------------------------------------------------------
+static void publishHead(uint16_t head);
+static uint16_t formatString(char *buffer, uint16_t index, uint16_t size, const char *format, va_list args);
+static uint16_t appendString(char *buffer, uint16_t index, uint16_t size, const char *string);
+static uint16_t appendNumber(char *buffer, uint16_t index, uint16_t size, uint32_t number, uint8_t base,
+							 uint8_t width, char pad, const char *digitSet);
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+static uint8_t ring[LOG_BUFFER_SIZE];
+static volatile uint32_t reservation;		// [31:16] - writers in progress, [15:0] - head
+static volatile uint16_t committed;			// All the bytes before it are written
+static volatile uint16_t tail;				// All the bytes before it are transmitted
+static volatile uint32_t dropped;
+static const char levelPrefixes[] = {' ', 'E', 'W', 'I', 'D'};
+static const char lowerDigits[] = "0123456789abcdef";
+static const char upperDigits[] = "0123456789ABCDEF";
+
+//---------------------------------------------------------------------------
+// FreeRTOS's threads
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	Function implementing the draining of the log ring.
+ * @note	The written part of the ring is handed over to the U(S)ART TX queue straight from the ring,
+ * 			its space is freed when DMA has transmitted it.
+ * @param 	argument - Not used.
+ * @retval  None.
+ */
+void logTask(void const *argument)
+{
+	uint16_t size = 0;
+	uint16_t position = 0;
+
+	/* Infinite loop */
+	for(;;)
+	{
+		osDelay(LOG_FLUSH_PERIOD);
+
+		while(committed != tail)
+		{
+			// The part up to the end of the ring is sent first
+			position = tail & LOG_BUFFER_MASK;
+			size = (uint16_t)(committed - tail);
+			if(size > (LOG_BUFFER_SIZE - position)) size = LOG_BUFFER_SIZE - position;
+
+			UART_transmit(&ring[position], size, SIGNAL_LOG_SENT);
+			osSignalWait(SIGNAL_LOG_SENT, osWaitForever);
+
+			tail += size;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+// Initialization functions
+//---------------------------------------------------------------------------
+
+/**
+  * @brief  FreeRTOS initialization for log module
+  * @param  None
+  * @retval None
+  */
+void LOG_freeRtosInit(void)
+{
+	// Create the thread(s)
+	// definition and creation of logTask
+	osThreadDef(log, logTask, osPriorityIdle, 0, 128);
+	logTaskHandle = osThreadCreate(osThread(log), NULL);
+}
+
+//---------------------------------------------------------------------------
+// Others functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function formats the record and puts it into the log.
+ * @note	The record is prefixed with the system tick and the level and ends with \r\n. The text which doesn't
+ * 			fit into LOG_LINE_SIZE is cut off. Use the LOG_ERROR..LOG_DEBUG macros, so the records above
+ * 			LOG_LEVEL are not compiled.
+ * @param 	level - The level of the record, LOG_LEVEL_ERROR..LOG_LEVEL_DEBUG.
+ * @param 	format - The format string, see log.h.
+ * @retval	None.
+ */
+void LOG_print(uint8_t level, const char *format, ...)
+{
+	char line[LOG_LINE_SIZE];
+	uint16_t index = 0;
+	va_list args;
+
+	if(level >= sizeof(levelPrefixes)) level = LOG_LEVEL_DEBUG;
+
+	// The room for \r\n is kept
+	index = appendNumber(line, index, LOG_LINE_SIZE - 2U, osKernelSysTick(), 10U, 0, ' ', lowerDigits);
+	index = appendString(line, index, LOG_LINE_SIZE - 2U, " ");
+	if(index < (LOG_LINE_SIZE - 2U)) line[index++] = levelPrefixes[level];
+	index = appendString(line, index, LOG_LINE_SIZE - 2U, ": ");
+
+	va_start(args, format);
+	index = formatString(line, index, LOG_LINE_SIZE - 2U, format, args);
+	va_end(args);
+
+	line[index++] = '\r';
+	line[index++] = '\n';
+
+	LOG_write(line, index);
+}
+
+/**
+ * @brief 	This function copies the data into the log ring without blocking.
+ * @note	The space is reserved by an exclusive store, so the function can be called from any thread and
+ * 			interrupt. The data becomes visible to the drain when every writer which reserved space before
+ * 			has finished copying.
+ * @param 	data - A pointer to the data.
+ * @param 	size - The size of the data.
+ * @retval	The size of the data or 0 if the ring is full and the data is dropped.
+ */
+uint16_t LOG_write(const char *data, uint16_t size)
+{
+	uint32_t word = 0;
+	uint16_t head = 0;
+
+	if((size == 0) || (size > LOG_BUFFER_SIZE)) return 0;
+
+	// Reserve the space and register as a writer
+	do
+	{
+		word = __LDREXW(&reservation);
+		head = (uint16_t)(word & HEAD_MASK);
+
+		if(((uint16_t)(head - tail) + size) > LOG_BUFFER_SIZE)
+		{
+			__CLREX();
+
+			do
+			{
+				word = __LDREXW(&dropped);
+			} while(__STREXW(word + 1U, &dropped));
+
+			return 0;
+		}
+
+	} while(__STREXW(((word & ~HEAD_MASK) + WRITER) | (uint16_t)(head + size), &reservation));
+
+	for(uint16_t index = 0; index < size; index++)
+	{
+		ring[(uint16_t)(head + index) & LOG_BUFFER_MASK] = (uint8_t)data[index];
+	}
+
+	__DMB();
+
+	// Leave. The last writer publishes everything which has been reserved so far.
+	do
+	{
+		word = __LDREXW(&reservation) - WRITER;
+	} while(__STREXW(word, &reservation));
+
+	if((word >> WRITERS_SHIFT) == 0) publishHead((uint16_t)(word & HEAD_MASK));
+
+	return size;
+}
+
+/**
+ * @brief 	This function returns the number of records which were dropped because the ring was full.
+ * @retval	The number of dropped records.
+ */
+uint32_t LOG_getDropped(void)
+{
+	return dropped;
+}
+
+/**
+ * @brief 	This function sends the printf output to the log instead of ITM.
+ * @note	It doesn't block, the output which doesn't fit into the ring is dropped.
+ */
+int _write(int file, char *ptr, int len)
+{
+	(void)file;
+
+	LOG_write(ptr, (len > (int)LOG_BUFFER_SIZE) ? (uint16_t)LOG_BUFFER_SIZE : (uint16_t)len);
+
+	return len;
+}
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function moves the committed head forward.
+ * @note	The writer which published the older head can be preempted by the one which publishes the newer
+ * 			head, so the head is never moved back.
+ * @param 	head - The head up to which all the records are written.
+ * @retval	None.
+ */
+static void publishHead(uint16_t head)
+{
+	uint16_t current = 0;
+
+	do
+	{
+		current = __LDREXH(&committed);
+
+		if((int16_t)(head - current) <= 0)
+		{
+			__CLREX();
+			return;
+		}
+
+	} while(__STREXH(head, &committed));
+}
+
+/**
+ * @brief 	This function prints the arguments into the buffer according to the format.
+ * @param 	buffer - A pointer to the destination buffer.
+ * @param 	index - The position in the buffer to start from.
+ * @param 	size - The size of the buffer.
+ * @param 	format - The format string, see log.h.
+ * @param 	args - The arguments.
+ * @retval	The position in the buffer after the printed text.
+ */
+static uint16_t formatString(char *buffer, uint16_t index, uint16_t size, const char *format, va_list args)
+{
+	uint8_t width = 0;
+	char pad = ' ';
+	int32_t number = 0;
+	const char *string = NULL;
+
+	for(; (*format != '\0') && (index < size); format++)
+	{
+		if(*format != '%')
+		{
+			buffer[index++] = *format;
+			continue;
+		}
+
+		format++;
+		pad = ' ';
+		width = 0;
+
+		if(*format == '0')
+		{
+			pad = '0';
+			format++;
+		}
+
+		while((*format >= '0') && (*format <= '9'))
+		{
+			width = (uint8_t)(width * 10U + (uint8_t)(*format++ - '0'));
+		}
+
+		if(*format == 'l') format++;	// long is the same as int
+
+		switch(*format)
+		{
+			case 'd':
+			case 'i':
+				number = va_arg(args, int32_t);
+
+				if(number < 0)
+				{
+					index = appendString(buffer, index, size, "-");
+					index = appendNumber(buffer, index, size, (0U - (uint32_t)number), 10U, (width != 0) ? (width - 1U) : 0, pad, lowerDigits);
+				} else
+				{
+					index = appendNumber(buffer, index, size, (uint32_t)number, 10U, width, pad, lowerDigits);
+				}
+				break;
+
+			case 'u':
+				index = appendNumber(buffer, index, size, va_arg(args, uint32_t), 10U, width, pad, lowerDigits);
+				break;
+
+			case 'x':
+				index = appendNumber(buffer, index, size, va_arg(args, uint32_t), 16U, width, pad, lowerDigits);
+				break;
+
+			case 'X':
+				index = appendNumber(buffer, index, size, va_arg(args, uint32_t), 16U, width, pad, upperDigits);
+				break;
+
+			case 'c':
+				buffer[index++] = (char)va_arg(args, int);
+				break;
+
+			case 's':
+				string = va_arg(args, const char*);
+				index = appendString(buffer, index, size, (string != NULL) ? string : "(null)");
+				break;
+
+			case '%':
+				buffer[index++] = '%';
+				break;
+
+			default:	// The unknown conversion or the end of the format
+				return index;
+		}
+	}
+
+	return index;
+}
+
+/**
+ * @brief 	This function copies the string to the buffer.
+ * @param 	buffer - A pointer to the destination buffer.
+ * @param 	index - The position in the buffer to start from.
+ * @param 	size - The size of the buffer.
+ * @param 	string - A pointer to the null-terminated string.
+ * @retval	The position in the buffer after the copied string.
+ */
+static uint16_t appendString(char *buffer, uint16_t index, uint16_t size, const char *string)
+{
+	while((*string != '\0') && (index < size))
+	{
+		buffer[index++] = *string++;
+	}
+
+	return index;
+}
+
+/**
+ * @brief 	This function prints the number to the buffer.
+ * @param 	buffer - A pointer to the destination buffer.
+ * @param 	index - The position in the buffer to start from.
+ * @param 	size - The size of the buffer.
+ * @param 	number - The number to be printed.
+ * @param 	base - 10 or 16.
+ * @param 	width - The minimum number of symbols, 0 - as many as the number has.
+ * @param 	pad - The symbol which the number is padded with up to the width.
+ * @param 	digitSet - The symbols of the digits.
+ * @retval	The position in the buffer after the printed number.
+ */
+static uint16_t appendNumber(char *buffer, uint16_t index, uint16_t size, uint32_t number, uint8_t base,
+							 uint8_t width, char pad, const char *digitSet)
+{
+	char digits[10];
+	uint8_t count = 0;
+
+	do
+	{
+		digits[count++] = digitSet[number % base];
+		number /= base;
+	} while(number != 0U);
+
+	while((width > count) && (index < size))
+	{
+		buffer[index++] = pad;
+		width--;
+	}
+
+	while((count > 0) && (index < size))
+	{
+		buffer[index++] = digits[--count];
+	}
+
+	return index;
+}
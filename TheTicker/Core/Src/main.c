@@ -43,22 +43,27 @@ static ErrorStatus initSystemClock(void);
   */
 int main(void)
 {
+	// Start the boot timeline
+	BOOT_init();
+
 	// Initialize Flash and cashes
 	initMicrocontroller();
 
 	// Initialize system clock
 	initSystemClock();
+	BOOT_mark(BOOT_STAGE_CLOCK_READY);
 
 	// Initialize sysTick timer
 	initSysTick(SYS_TICK_PRIORITY);
 
-	// Initialize timeout timer
-	MISC_timeoutTimer();
+	// Initialize the timebase of the driver timeouts
+	MISC_timebaseInit();
 
 	// Call init function for freertos objects (in freertos.c)
 	freeRtosInit();
 
 	// Start scheduler
+	BOOT_mark(BOOT_STAGE_SCHEDULER_START);
 	osKernelStart();
 
     // Loop forever
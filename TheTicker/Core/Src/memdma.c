@@ -0,0 +1,306 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "memdma.h"
+#include "string.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+
+// Only DMA2 can do memory-to-memory transfers, the stream isn't used by any U(S)ART
+#define USED_STREAM				(DMA2_Stream0)
+#define USED_STREAM_IRQ			(DMA2_Stream0_IRQn)
+
+#define PREEMPTION_PRIORITY		(5U)
+#define SUBPRIORITY				(0U)
+
+#define BURST_ALIGNMENT			((uint32_t)0x0F)	// 4 beats of words, the burst never crosses a 1 KB boundary
+#define WORD_ALIGNMENT			((uint32_t)0x03)
+
+//---------------------------------------------------------------------------
+// Descriptions of FreeRTOS elements
+//---------------------------------------------------------------------------
+static osSemaphoreId engineFreeHandle;
+
+//---------------------------------------------------------------------------
+// Static function prototypes
+//---------------------------------------------------------------------------
+static void runTransfer(void *destination, const void *source, uint16_t size, USH_DMA_periphIncrement sourceInc,
+						uint8_t isCpu);
+static void startTransfer(void *destination, const void *source, uint16_t size, USH_DMA_periphIncrement sourceInc);
+static void transferCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+static uint8_t isReady;						// The stream is claimed and configured
+static __ALIGNED(16) uint32_t fillPattern;	// The source of the fill, it isn't incremented
+
+#ifdef PROFILE
+static uint32_t transferStart;				// The cycle counter when the stream was enabled
+static __ALIGNED(16) uint8_t benchmarkSource[MEMDMA_BENCHMARK_MAX_SIZE];
+static __ALIGNED(16) uint8_t benchmarkDestination[MEMDMA_BENCHMARK_MAX_SIZE];
+#endif
+
+// A transfer error can happen only with the addresses DMA can't reach, it frees the engine as well
+static const USH_DMA_callbacksTypeDef memdmaCallbacks = {transferCompleteHandler, NULL, transferCompleteHandler, NULL, NULL};
+
+//---------------------------------------------------------------------------
+// Initialization functions
+//---------------------------------------------------------------------------
+
+/**
+  * @brief  FreeRTOS initialization for memdma module
+  * @note	If the stream is owned by another driver, the copies and fills are done by CPU.
+  * @param  None
+  * @retval None
+  */
+void MEMDMA_freeRtosInit(void)
+{
+	USH_DMA_initTypeDef initDmaStructure = {0,};
+
+	// Create the semaphore(s)
+	// definition and creation of the semaphore which is free while no transfer is running
+	osSemaphoreDef(engineFree);
+	engineFreeHandle = osSemaphoreCreate(osSemaphore(engineFree), 1);
+
+#ifdef DEBUG
+	vQueueAddToRegistry(engineFreeHandle, "memdma engine");
+#endif
+
+	if(DMA_claimStream(USED_STREAM, &memdmaCallbacks, NULL) != STATUS_OK)
+	{
+		assert_param(0);
+		return;
+	}
+
+	// Enable DMA clock
+	RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+
+	// The data sizes and bursts are chosen for every transfer. The FIFO can't be bypassed in this mode.
+	initDmaStructure.DMAy_Streamx			= USED_STREAM;
+	initDmaStructure.Channel				= DMA_CHANNEL_0;
+	initDmaStructure.Direction				= DMA_MEMORY_TO_MEMORY;
+	initDmaStructure.PeriphInc				= DMA_PINC_ENABLE;
+	initDmaStructure.MemInc					= DMA_MINC_ENABLE;
+	initDmaStructure.PeriphDataAlignment	= DMA_PERIPH_SIZE_BYTE;
+	initDmaStructure.MemDataAlignment		= DMA_MEMORY_SIZE_BYTE;
+	initDmaStructure.Mode					= DMA_NORMAL_MODE;
+	initDmaStructure.Priority				= DMA_PRIORITY_LOW;
+	initDmaStructure.MemBurst				= DMA_MBURST_SINGLE;
+	initDmaStructure.PeriphBurst			= DMA_PBURST_SINGLE;
+	initDmaStructure.FIFOMode				= DMA_FIFO_MODE_ENABLE;
+	initDmaStructure.FIFOThreshold			= DMA_FIFO_THRESHOLD_FULL;
+	DMA_init(&initDmaStructure);
+
+	// DMA interrupt init
+	MISC_NVIC_SetPriority(USED_STREAM_IRQ, PREEMPTION_PRIORITY, SUBPRIORITY);
+	MISC_NVIC_EnableIRQ(USED_STREAM_IRQ);
+
+	isReady = 1;
+}
+
+//---------------------------------------------------------------------------
+// Others functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function starts copying the block and returns without waiting for the end of the copy.
+ * @note	The previous transfer is waited for. The short blocks are copied by CPU before the function returns.
+ * 			Neither of the blocks can be touched until MEMDMA_wait returns.
+ * @param 	destination - A pointer to the destination block.
+ * @param 	source - A pointer to the source block.
+ * @param 	size - The size of the block in bytes.
+ * @retval	None.
+ */
+void MEMDMA_copy(void *destination, const void *source, uint16_t size)
+{
+	assert_param(IS_MEMDMA_ADDRESS(destination));
+	assert_param(IS_MEMDMA_ADDRESS(source));
+
+	osSemaphoreWait(engineFreeHandle, osWaitForever);
+
+	runTransfer(destination, source, size, DMA_PINC_ENABLE, !isReady || (size < MEMDMA_CPU_THRESHOLD));
+}
+
+/**
+ * @brief 	This function starts filling the block with the value and returns without waiting for the end of the fill.
+ * @note	The previous transfer is waited for. The short blocks are filled by CPU before the function returns.
+ * 			The block can't be touched until MEMDMA_wait returns.
+ * @param 	destination - A pointer to the block.
+ * @param 	value - The value of every byte of the block.
+ * @param 	size - The size of the block in bytes.
+ * @retval	None.
+ */
+void MEMDMA_fill(void *destination, uint8_t value, uint16_t size)
+{
+	assert_param(IS_MEMDMA_ADDRESS(destination));
+
+	osSemaphoreWait(engineFreeHandle, osWaitForever);
+
+	// The pattern is read only by the transfer which has just been allowed to start
+	fillPattern = value * 0x01010101U;
+
+	runTransfer(destination, &fillPattern, size, DMA_PINC_DISABLE, !isReady || (size < MEMDMA_CPU_THRESHOLD));
+}
+
+/**
+ * @brief 	This function blocks the calling thread until the running transfer is over.
+ * @retval	None.
+ */
+void MEMDMA_wait(void)
+{
+	if(!isReady) return;
+
+	osSemaphoreWait(engineFreeHandle, osWaitForever);
+	osSemaphoreRelease(engineFreeHandle);
+}
+
+#ifdef PROFILE
+/**
+ * @brief 	This function copies or fills the blocks of the benchmark by CPU and by the stream, whatever the size is.
+ * @note	Every run is recorded into PROFILE_REGION_MEMDMA_CPU, PROFILE_REGION_MEMDMA_START and
+ * 			PROFILE_REGION_MEMDMA_TRANSFER, the interrupt into PROFILE_REGION_ISR_MEMDMA. The function returns when
+ * 			the last transfer is over.
+ * @param 	isFill - 1 to fill, 0 to copy.
+ * @param 	size - The size of the block in bytes, up to MEMDMA_BENCHMARK_MAX_SIZE.
+ * @param 	runs - The number of runs of each path.
+ * @retval	1 if the runs are done, 0 if the size is out of range or the stream isn't claimed.
+ */
+uint8_t MEMDMA_benchmark(uint8_t isFill, uint16_t size, uint8_t runs)
+{
+	if(!isReady || (size == 0) || (size > MEMDMA_BENCHMARK_MAX_SIZE)) return 0;
+
+	for(uint8_t run = 0; run < runs; run++)
+	{
+		for(uint8_t isCpu = 0; isCpu < 2U; isCpu++)
+		{
+			osSemaphoreWait(engineFreeHandle, osWaitForever);
+
+			fillPattern = run * 0x01010101U;
+
+			runTransfer(benchmarkDestination, isFill ? (const void*)&fillPattern : benchmarkSource, size,
+						isFill ? DMA_PINC_DISABLE : DMA_PINC_ENABLE, isCpu);
+		}
+	}
+
+	MEMDMA_wait();
+
+	return 1;
+}
+#endif
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function copies or fills the block by CPU or starts the stream for it.
+ * @note	The engine is taken by the caller. The CPU path gives it back, the stream gives it back at its end,
+ * 			so no transfer writes into the block while CPU does.
+ * @param 	destination - A pointer to the destination block.
+ * @param 	source - A pointer to the source block or to the fill pattern.
+ * @param 	size - The size of the block in bytes.
+ * @param 	sourceInc - DMA_PINC_ENABLE to copy, DMA_PINC_DISABLE to fill.
+ * @param 	isCpu - 1 to do the block by CPU.
+ * @retval	None.
+ */
+static void runTransfer(void *destination, const void *source, uint16_t size, USH_DMA_periphIncrement sourceInc,
+						uint8_t isCpu)
+{
+	if(isCpu)
+	{
+		PROFILE_BEGIN(PROFILE_REGION_MEMDMA_CPU);
+
+		if(sourceInc == DMA_PINC_ENABLE)
+		{
+			memcpy(destination, source, size);
+		} else
+		{
+			memset(destination, *(const uint8_t*)source, size);
+		}
+
+		PROFILE_END(PROFILE_REGION_MEMDMA_CPU);
+
+		osSemaphoreRelease(engineFreeHandle);
+		return;
+	}
+
+	PROFILE_BEGIN(PROFILE_REGION_MEMDMA_START);
+	startTransfer(destination, source, size, sourceInc);
+	PROFILE_END(PROFILE_REGION_MEMDMA_START);
+}
+
+/**
+ * @brief 	This function programs the stream for the block and enables it.
+ * @note	In memory-to-memory mode the source is on the peripheral port of the stream.
+ * @param 	destination - A pointer to the destination block.
+ * @param 	source - A pointer to the source block or to the fill pattern.
+ * @param 	size - The size of the block in bytes.
+ * @param 	sourceInc - DMA_PINC_ENABLE to copy, DMA_PINC_DISABLE to fill.
+ * @retval	None.
+ */
+static void startTransfer(void *destination, const void *source, uint16_t size, USH_DMA_periphIncrement sourceInc)
+{
+	uint32_t alignment = (uint32_t)destination | (uint32_t)source | size;
+	uint32_t tmpReg = USED_STREAM->CR;
+
+	tmpReg &= ~(DMA_SxCR_PSIZE | DMA_SxCR_MSIZE | DMA_SxCR_PINC | DMA_SxCR_PBURST | DMA_SxCR_MBURST);
+	tmpReg |= sourceInc;
+
+	if((alignment & BURST_ALIGNMENT) == 0)
+	{
+		tmpReg |= DMA_PERIPH_SIZE_WORD | DMA_MEMORY_SIZE_WORD | DMA_PBURST_INCR4 | DMA_MBURST_INCR4;
+		USED_STREAM->NDTR = size / sizeof(uint32_t);
+
+	} else if((alignment & WORD_ALIGNMENT) == 0)
+	{
+		tmpReg |= DMA_PERIPH_SIZE_WORD | DMA_MEMORY_SIZE_WORD;
+		USED_STREAM->NDTR = size / sizeof(uint32_t);
+
+	} else
+	{
+		tmpReg |= DMA_PERIPH_SIZE_BYTE | DMA_MEMORY_SIZE_BYTE;
+		USED_STREAM->NDTR = size;
+	}
+
+	USED_STREAM->CR = tmpReg;
+	USED_STREAM->PAR = (uint32_t)source;
+	USED_STREAM->M0AR = (uint32_t)destination;
+
+	// Clear interrupt flags
+	DMA_clearFlags(USED_STREAM, DMA_FLAG_ALL);
+
+	// Enable interrupts
+	USED_STREAM->CR |= DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+
+#ifdef PROFILE
+	transferStart = DWT->CYCCNT;
+#endif
+
+	// Enable DMA stream
+	DMA_state(USED_STREAM, ENABLE);
+}
+
+//---------------------------------------------------------------------------
+// Callbacks
+//---------------------------------------------------------------------------
+
+/**
+ * @brief  Transfer complete and transfer error callback. The engine is free for the next transfer.
+ * @param  DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param  context - Not used.
+ * @retval None.
+ */
+static void transferCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	(void)DMAy_Streamx;
+	(void)context;
+
+#ifdef PROFILE
+	PROFILE_record(PROFILE_REGION_MEMDMA_TRANSFER, DWT->CYCCNT - transferStart);
+#endif
+
+	osSemaphoreRelease(engineFreeHandle);
+}
@@ -0,0 +1,248 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "monitor.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+
+// The threads which freeRtosInit creates, every module counts the osThreadDef of its own init
+#ifdef HEARTBEAT
+#define HEARTBEAT_THREADS		HEARTBEAT_THREAD_COUNT
+#else
+#define HEARTBEAT_THREADS		(0U)
+#endif
+
+#ifdef LEDMATRIX
+#define LEDMATRIX_THREADS		LEDMATRIX_THREAD_COUNT
+#else
+#define LEDMATRIX_THREADS		(0U)
+#endif
+
+#ifdef UART
+#define UART_THREADS			(UART_THREAD_COUNT + LOG_THREAD_COUNT)
+#else
+#define UART_THREADS			(0U)
+#endif
+
+#define THREAD_COUNT			(MONITOR_THREAD_COUNT + HEARTBEAT_THREADS + LEDMATRIX_THREADS + UART_THREADS + 1U)	// + IDLE
+
+#if THREAD_COUNT > MONITOR_MAX_TASKS
+#error "MONITOR_MAX_TASKS is less than the number of the threads, uxTaskGetSystemState would report none of them"
+#endif
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Run time of a thread at the previous query structure
+ */
+typedef struct
+{
+	UBaseType_t number;					/* The number of the thread */
+	uint32_t runTime;					/* The run time counter of the thread, us */
+} MONITOR_runTimeTypeDef;
+
+//---------------------------------------------------------------------------
+// Static function prototypes
+//---------------------------------------------------------------------------
+static uint32_t getLastRunTime(UBaseType_t number);
+static uint8_t isStackReported(UBaseType_t number);
+
+//---------------------------------------------------------------------------
+// Descriptions of FreeRTOS elements
+//---------------------------------------------------------------------------
+static osThreadId monitorHandle;
+static osMutexId taskStatusesMutexHandle;
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+
+// Too big for the stacks of the threads, shared by the monitor thread and the one which processes the requests
+static TaskStatus_t taskStatuses[MONITOR_MAX_TASKS];
+static MONITOR_runTimeTypeDef lastRunTimes[MONITOR_MAX_TASKS];
+static uint32_t lastTotalRunTime;
+static uint32_t reportedStacks;			// A bit for every thread number whose low stack has been logged
+
+//---------------------------------------------------------------------------
+// FreeRTOS's threads
+//---------------------------------------------------------------------------
+
+/**
+* @brief Function implementing the thread which samples the stacks of the threads.
+* @param argument: Not used
+* @retval None
+*/
+void monitorTask(void const * argument)
+{
+	uint8_t count = 0;
+
+	// All the threads are created before the scheduler starts, so a thread missed by THREAD_COUNT shows up here
+	if(uxTaskGetNumberOfTasks() > MONITOR_MAX_TASKS)
+	{
+		LOG_ERROR("%u threads, MONITOR_MAX_TASKS is %u", uxTaskGetNumberOfTasks(), MONITOR_MAX_TASKS);
+		assert_param(0);
+	}
+
+	/* Infinite loop */
+	for(;;)
+	{
+		osDelay(MONITOR_STACK_PERIOD);
+
+		osMutexWait(taskStatusesMutexHandle, osWaitForever);
+
+		count = (uint8_t)uxTaskGetSystemState(taskStatuses, MONITOR_MAX_TASKS, NULL);
+
+		for(uint8_t task = 0; task < count; task++)
+		{
+			if(taskStatuses[task].usStackHighWaterMark >= MONITOR_STACK_MARGIN) continue;
+			if(isStackReported(taskStatuses[task].xTaskNumber)) continue;
+
+			LOG_WARNING("Stack of %s: %u words left", taskStatuses[task].pcTaskName, taskStatuses[task].usStackHighWaterMark);
+		}
+
+		osMutexRelease(taskStatusesMutexHandle);
+	}
+}
+
+//---------------------------------------------------------------------------
+// Initialization functions
+//---------------------------------------------------------------------------
+
+/**
+  * @brief  FreeRTOS initialization for monitor module
+  * @param  None
+  * @retval None
+  */
+void MONITOR_freeRtosInit(void)
+{
+	// Create the thread(s)
+	// definition and creation of monitorTask
+	osThreadDef(monitor, monitorTask, osPriorityIdle, 0, 128);
+	monitorHandle = osThreadCreate(osThread(monitor), NULL);
+
+	// Create the mutex(s)
+	// definition and creation of mutex for the statuses of the threads
+	osMutexDef(taskStatusesMutex);
+	taskStatusesMutexHandle = osMutexCreate(osMutex(taskStatusesMutex));
+
+#ifdef DEBUG
+	vQueueAddToRegistry(taskStatusesMutexHandle, "statuses of threads");
+#endif
+}
+
+//---------------------------------------------------------------------------
+// Others functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function returns the CPU usage of every thread since the previous call.
+ * @note	The interval is shared, so it has to be called from one thread only, see protocol.c.
+ * @param 	usage - A pointer to the array of MONITOR_MAX_TASKS structures for the usage.
+ * @param 	interval - A pointer to the length of the interval in microseconds.
+ * @retval	The number of the threads in the array.
+ */
+uint8_t MONITOR_getTaskUsage(MONITOR_taskUsageTypeDef *usage, uint32_t *interval)
+{
+	uint32_t totalRunTime = 0;
+	uint8_t count = 0;
+
+	osMutexWait(taskStatusesMutexHandle, osWaitForever);
+
+	count = (uint8_t)uxTaskGetSystemState(taskStatuses, MONITOR_MAX_TASKS, &totalRunTime);
+
+	*interval = totalRunTime - lastTotalRunTime;
+
+	for(uint8_t task = 0; task < count; task++)
+	{
+		usage[task].name		= taskStatuses[task].pcTaskName;
+		usage[task].number		= (uint8_t)taskStatuses[task].xTaskNumber;
+		usage[task].runTime		= taskStatuses[task].ulRunTimeCounter - getLastRunTime(taskStatuses[task].xTaskNumber);
+		usage[task].permille	= (*interval != 0) ? (uint16_t)(((uint64_t)usage[task].runTime * 1000U) / *interval) : 0U;
+	}
+
+	// The counters of this query are the base of the next one
+	for(uint8_t task = 0; task < count; task++)
+	{
+		lastRunTimes[task].number	= taskStatuses[task].xTaskNumber;
+		lastRunTimes[task].runTime	= taskStatuses[task].ulRunTimeCounter;
+	}
+
+	for(uint8_t task = count; task < MONITOR_MAX_TASKS; task++)
+	{
+		lastRunTimes[task].number = 0;
+	}
+
+	lastTotalRunTime = totalRunTime;
+
+	osMutexRelease(taskStatusesMutexHandle);
+
+	return count;
+}
+
+/**
+ * @brief 	This function returns the smallest number of free words of the stack of every thread since the start.
+ * @param 	usage - A pointer to the array of MONITOR_MAX_TASKS structures for the usage.
+ * @retval	The number of the threads in the array.
+ */
+uint8_t MONITOR_getStackUsage(MONITOR_stackUsageTypeDef *usage)
+{
+	uint8_t count = 0;
+
+	osMutexWait(taskStatusesMutexHandle, osWaitForever);
+
+	count = (uint8_t)uxTaskGetSystemState(taskStatuses, MONITOR_MAX_TASKS, NULL);
+
+	for(uint8_t task = 0; task < count; task++)
+	{
+		usage[task].name	= taskStatuses[task].pcTaskName;
+		usage[task].number	= (uint8_t)taskStatuses[task].xTaskNumber;
+		usage[task].minFree	= taskStatuses[task].usStackHighWaterMark;
+	}
+
+	osMutexRelease(taskStatusesMutexHandle);
+
+	return count;
+}
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function looks for the run time counter of the thread at the previous query.
+ * @param 	number - The number of the thread.
+ * @retval	The run time counter, 0 if the thread has been created since the previous query.
+ */
+static uint32_t getLastRunTime(UBaseType_t number)
+{
+	for(uint8_t task = 0; task < MONITOR_MAX_TASKS; task++)
+	{
+		if((lastRunTimes[task].number == number) && (number != 0)) return lastRunTimes[task].runTime;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief 	This function marks the low stack of the thread as logged.
+ * @param 	number - The number of the thread.
+ * @retval	1 if it has been logged before, otherwise 0.
+ */
+static uint8_t isStackReported(UBaseType_t number)
+{
+	uint32_t mask = 0;
+
+	if(number >= 32U) return 1;		// The threads are never deleted, so their numbers don't grow that far
+
+	mask = 1UL << number;
+
+	if(reportedStacks & mask) return 1;
+
+	reportedStacks |= mask;
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "profile.h"
+#include "string.h"
+
+#ifdef PROFILE
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+static PROFILE_regionTypeDef regions[PROFILE_REGION_COUNT];
+
+//---------------------------------------------------------------------------
+// Others functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function adds the run of the region to its statistics.
+ * @note	Use the PROFILE_BEGIN and PROFILE_END macros instead of calling it directly.
+ * @param 	region - The region. This parameter can be a value of @ref PROFILE_region.
+ * @param 	cycles - The duration of the run in core cycles.
+ * @retval	None.
+ */
+void PROFILE_record(PROFILE_region region, uint32_t cycles)
+{
+	PROFILE_regionTypeDef *statistics = &regions[region];
+	uint32_t bucket = 32U - __CLZ(cycles);
+
+	if(bucket >= PROFILE_BUCKET_COUNT) bucket = PROFILE_BUCKET_COUNT - 1U;
+
+	if((statistics->count == 0) || (cycles < statistics->min)) statistics->min = cycles;
+	if(cycles > statistics->max) statistics->max = cycles;
+
+	statistics->count++;
+	statistics->sum += cycles;
+	statistics->buckets[bucket]++;
+}
+
+/**
+ * @brief 	This function stamps the first frame of the message and adds its latencies to the regions.
+ * @note	It's called from the thread which sends the frames to the matrix only.
+ * @param 	latency - A pointer to the stamps of the message.
+ * @retval	None.
+ */
+void PROFILE_recordLatency(const PROFILE_latencyTypeDef *latency)
+{
+	uint32_t displayed = MISC_timebaseNow();
+
+	PROFILE_record(PROFILE_REGION_LATENCY_PARSE, latency->parsed - latency->received);
+	PROFILE_record(PROFILE_REGION_LATENCY_DECODE, latency->decoded - latency->parsed);
+	PROFILE_record(PROFILE_REGION_LATENCY_DISPLAY, displayed - latency->decoded);
+	PROFILE_record(PROFILE_REGION_LATENCY_TOTAL, displayed - latency->received);
+}
+
+/**
+ * @brief 	This function copies the statistics of the region.
+ * @note	The copy is taken with the interrupts disabled, so it's consistent.
+ * @param 	region - The region. This parameter can be a value of @ref PROFILE_region.
+ * @param 	statistics - A pointer to the structure for the copy.
+ * @retval	1 if the region exists, otherwise 0.
+ */
+uint8_t PROFILE_read(PROFILE_region region, PROFILE_regionTypeDef *statistics)
+{
+	uint32_t primask = 0;
+
+	if(region >= PROFILE_REGION_COUNT) return 0;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	*statistics = regions[region];
+
+	__set_PRIMASK(primask);
+
+	return 1;
+}
+
+/**
+ * @brief 	This function clears the statistics of the region.
+ * @param 	region - The region. This parameter can be a value of @ref PROFILE_region.
+ * @retval	None.
+ */
+void PROFILE_reset(PROFILE_region region)
+{
+	uint32_t primask = 0;
+
+	if(region >= PROFILE_REGION_COUNT) return;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	memset(&regions[region], 0, sizeof(regions[region]));
+
+	__set_PRIMASK(primask);
+}
+
+#endif /* PROFILE */
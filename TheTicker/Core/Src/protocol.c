@@ -0,0 +1,791 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "protocol.h"
+#include "string.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define COMMAND_SIZE			(1U)
+#define REPLY_HEADER_SIZE		(2U)	// command + status
+
+#define COBS_MAX_BLOCK			((uint8_t)0xFF)
+
+#define FRAME_HEADER_SIZE		(2U)	// flags + the first module
+#define DELTA_RUN_HEADER_SIZE	(3U)	// offset + length
+#define RECT_HEADER_SIZE		(5U)	// flags + the rectangle
+#define TASK_NAME_SIZE			(8U)	// The names are cut, so MONITOR_MAX_TASKS records fit into the reply
+#define TASK_RECORD_SIZE		(7U + TASK_NAME_SIZE)	// The number, the run time and the share of the thread
+#define STACK_RECORD_SIZE		(3U + TASK_NAME_SIZE)	// The number and the free words of the thread
+
+#if (4U + MONITOR_MAX_TASKS * TASK_RECORD_SIZE) > PROTOCOL_PAYLOAD_MAX_SIZE
+#error "The usage of MONITOR_MAX_TASKS threads doesn't fit into the reply of PROTOCOL_CMD_QUERY_TASKS"
+#endif
+
+#if (2U + MONITOR_MAX_TASKS * STACK_RECORD_SIZE) > PROTOCOL_PAYLOAD_MAX_SIZE
+#error "The stacks of MONITOR_MAX_TASKS threads don't fit into the reply of PROTOCOL_CMD_QUERY_STACKS"
+#endif
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Command handler type
+ * @param payload - A pointer to the payload of the request.
+ * @param sizePayload - The size of the payload.
+ * @param reply - A pointer to the payload of the reply.
+ * @param sizeReply - A pointer to the size of the reply payload, it is 0 on entry.
+ * @retval The status of the command. This parameter can be a value of @ref PROTOCOL_status.
+ */
+typedef PROTOCOL_status (*PROTOCOL_handler)(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+
+/**
+ * @brief Command description structure
+ */
+typedef struct
+{
+	PROTOCOL_handler handler;		/* The function which executes the command */
+	uint16_t minSizePayload;		/* The minimum size of the request payload */
+	uint16_t maxSizePayload;		/* The maximum size of the request payload */
+} PROTOCOL_commandTypeDef;
+
+//---------------------------------------------------------------------------
+// Static function prototypes
+//---------------------------------------------------------------------------
+static uint16_t decodeCOBS(uint8_t *frame, uint16_t size);
+static uint16_t encodeCOBS(const uint8_t *source, uint16_t size, uint8_t *destination);
+static void putUint32(uint8_t *buffer, uint32_t value);
+static uint32_t getUint32(const uint8_t *buffer);
+static void sendReply(uint8_t command, PROTOCOL_status status, uint16_t sizePayload);
+
+static PROTOCOL_status putMessage(const uint8_t *text, uint16_t size, uint8_t flags, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status setMessage(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status setSpeed(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status setIntensity(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status queryStats(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status queryVersion(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status queryBoot(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status setBaudRate(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status queryCredits(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status queryErrors(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status setFrame(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status setFrameDelta(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status setMessagePacked(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status fillFrame(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status copyFrame(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status blendFrame(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status queryTasks(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status queryStacks(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status queryHeap(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status queryHeapTags(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static void getRect(const uint8_t *payload, COMPOSE_rectTypeDef *rect);
+
+#ifdef PROFILE
+static PROTOCOL_status queryProfile(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+static PROTOCOL_status benchMemdma(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply);
+#endif
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+
+// The command is the index of the table, so the dispatch doesn't depend on the number of commands
+static const PROTOCOL_commandTypeDef commandTable[PROTOCOL_CMD_COUNT] =
+{
+	[PROTOCOL_CMD_SET_MESSAGE]		= {setMessage,		1U,	PROTOCOL_PAYLOAD_MAX_SIZE},
+	[PROTOCOL_CMD_SET_SPEED]		= {setSpeed,		1U,	1U},
+	[PROTOCOL_CMD_SET_INTENSITY]	= {setIntensity,	1U,	1U},
+	[PROTOCOL_CMD_QUERY_STATS]		= {queryStats,		0U,	0U},
+	[PROTOCOL_CMD_QUERY_VERSION]	= {queryVersion,	0U,	0U},
+	[PROTOCOL_CMD_QUERY_BOOT]		= {queryBoot,		0U,	0U},
+	[PROTOCOL_CMD_SET_BAUDRATE]		= {setBaudRate,		4U,	4U},
+	[PROTOCOL_CMD_QUERY_CREDITS]	= {queryCredits,	0U,	0U},
+	[PROTOCOL_CMD_QUERY_ERRORS]		= {queryErrors,		0U,	0U},
+	[PROTOCOL_CMD_SET_FRAME]		= {setFrame,		FRAME_HEADER_SIZE,	PROTOCOL_PAYLOAD_MAX_SIZE},
+	[PROTOCOL_CMD_SET_FRAME_DELTA]	= {setFrameDelta,	1U,	PROTOCOL_PAYLOAD_MAX_SIZE},
+	[PROTOCOL_CMD_SET_MESSAGE_PACKED] = {setMessagePacked, 2U,	PROTOCOL_PAYLOAD_MAX_SIZE},
+	[PROTOCOL_CMD_FILL_FRAME]		= {fillFrame,		RECT_HEADER_SIZE + 1U,	RECT_HEADER_SIZE + 1U},
+	[PROTOCOL_CMD_COPY_FRAME]		= {copyFrame,		RECT_HEADER_SIZE + 2U,	RECT_HEADER_SIZE + 2U},
+	[PROTOCOL_CMD_BLEND_FRAME]		= {blendFrame,		RECT_HEADER_SIZE + 1U,	PROTOCOL_PAYLOAD_MAX_SIZE},
+#ifdef PROFILE
+	[PROTOCOL_CMD_QUERY_PROFILE]	= {queryProfile,	1U,	2U},
+#endif
+	[PROTOCOL_CMD_QUERY_TASKS]		= {queryTasks,		0U,	0U},
+	[PROTOCOL_CMD_QUERY_STACKS]		= {queryStacks,		0U,	0U},
+	[PROTOCOL_CMD_QUERY_HEAP]		= {queryHeap,		0U,	0U},
+	[PROTOCOL_CMD_QUERY_HEAP_TAGS]	= {queryHeapTags,	0U,	0U},
+#ifdef PROFILE
+	[PROTOCOL_CMD_BENCH_MEMDMA]		= {benchMemdma,		4U,	4U},
+#endif
+};
+
+static uint8_t replyBuffer[REPLY_HEADER_SIZE + PROTOCOL_PAYLOAD_MAX_SIZE + CRC_SIZE];
+static uint8_t txFrame[PROTOCOL_FRAME_MAX_SIZE + 2U];	// + the delimiters
+static uint8_t messageText[UART_MESSAGE_POOL_SIZE][PROTOCOL_PAYLOAD_MAX_SIZE];	// A slot for every message which can be alive
+static uint8_t messageSlot;
+static uint32_t rejectedMessages;
+static uint8_t isCrcReady;
+static uint8_t isReplyPending;
+static uint8_t isPackedTextOpen;		// The last packed text request had PROTOCOL_TEXT_MORE
+
+//---------------------------------------------------------------------------
+// Others functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function decodes the frame, checks it and executes the command.
+ * @note	The frame is decoded in place.
+ * @param 	frame - A pointer to the COBS encoded frame without the delimiters.
+ * @param 	size - The size of the encoded frame.
+ * @retval	1 if the frame is valid, otherwise 0.
+ */
+uint8_t PROTOCOL_processFrame(uint8_t *frame, uint16_t size)
+{
+	uint16_t sizePayload = 0;
+	uint16_t sizeReply = 0;
+	uint8_t command = 0;
+	uint32_t crc = 0;
+	PROTOCOL_status status = PROTOCOL_STATUS_OK;
+	const PROTOCOL_commandTypeDef *description = NULL;
+
+	if(!isCrcReady)
+	{
+		CRC_init();
+		isCrcReady = 1;
+	}
+
+	size = decodeCOBS(frame, size);
+	if(size < (COMMAND_SIZE + CRC_SIZE)) return 0;
+
+	size -= CRC_SIZE;
+	crc = getUint32(&frame[size]);
+
+	if(CRC_calculate(frame, size) != crc) return 0;
+
+	command = frame[0];
+	sizePayload = size - COMMAND_SIZE;
+
+	if((command >= PROTOCOL_CMD_COUNT) || (commandTable[command].handler == NULL))
+	{
+		status = PROTOCOL_STATUS_UNKNOWN_COMMAND;
+	} else
+	{
+		description = &commandTable[command];
+
+		if((sizePayload < description->minSizePayload) || (sizePayload > description->maxSizePayload))
+		{
+			status = PROTOCOL_STATUS_WRONG_SIZE;
+		} else
+		{
+			status = description->handler(&frame[COMMAND_SIZE], sizePayload, &replyBuffer[REPLY_HEADER_SIZE], &sizeReply);
+		}
+	}
+
+	sendReply(command, status, sizeReply);
+
+	return 1;
+}
+
+/**
+ * @brief 	This function blocks the calling thread till the last reply is transmitted.
+ * @note	It has to be called from the thread which processes the frames.
+ * @retval	None.
+ */
+void PROTOCOL_waitReply(void)
+{
+	if(!isReplyPending) return;
+
+	osSignalWait(PROTOCOL_SIGNAL_REPLY_SENT, osWaitForever);
+	isReplyPending = 0;
+}
+
+/**
+ * @brief 	This function confirms the baud rate switch which PROTOCOL_CMD_SET_BAUDRATE has requested.
+ * @note	The confirmation is a second reply to the request. It comes at the new baud rate, or at the old one with
+ * 			PROTOCOL_STATUS_FAILED if the transmit queue couldn't be drained. It has to be called from the thread
+ * 			which processes the frames.
+ * @param 	baudrate - The requested baud rate.
+ * @param 	isApplied - 1 if the baud rate is changed, otherwise 0.
+ * @retval	None.
+ */
+void PROTOCOL_confirmBaudRate(uint32_t baudrate, uint8_t isApplied)
+{
+	putUint32(&replyBuffer[REPLY_HEADER_SIZE], baudrate);
+	sendReply(PROTOCOL_CMD_SET_BAUDRATE, isApplied ? PROTOCOL_STATUS_OK : PROTOCOL_STATUS_FAILED, 4U);
+}
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function decodes the COBS frame in place.
+ * @note	The decoded data is never longer than the encoded one, so it can be written over it.
+ * @param 	frame - A pointer to the encoded frame without the delimiters.
+ * @param 	size - The size of the encoded frame.
+ * @retval	The size of the decoded data or 0 if the frame is broken.
+ */
+static uint16_t decodeCOBS(uint8_t *frame, uint16_t size)
+{
+	uint16_t readIndex = 0;
+	uint16_t writeIndex = 0;
+	uint8_t code = 0;
+
+	while(readIndex < size)
+	{
+		code = frame[readIndex++];
+
+		if((code == 0) || ((readIndex + code - 1U) > size)) return 0;
+
+		for(uint8_t counter = 1; counter < code; counter++)
+		{
+			frame[writeIndex++] = frame[readIndex++];
+		}
+
+		// The zero is implied after every block except the full one and the last one
+		if((code != COBS_MAX_BLOCK) && (readIndex < size)) frame[writeIndex++] = 0;
+	}
+
+	return writeIndex;
+}
+
+/**
+ * @brief 	This function encodes the data with COBS.
+ * @param 	source - A pointer to the data.
+ * @param 	size - The size of the data.
+ * @param 	destination - A pointer to the buffer for the encoded data. It has to be size + size / 254 + 1 bytes at least.
+ * @retval	The size of the encoded data.
+ */
+static uint16_t encodeCOBS(const uint8_t *source, uint16_t size, uint8_t *destination)
+{
+	uint16_t codeIndex = 0;
+	uint16_t writeIndex = 1;
+	uint8_t code = 1;
+
+	for(uint16_t readIndex = 0; readIndex < size; readIndex++)
+	{
+		if(source[readIndex] != 0)
+		{
+			destination[writeIndex++] = source[readIndex];
+			code++;
+		}
+
+		if((source[readIndex] == 0) || (code == COBS_MAX_BLOCK))
+		{
+			destination[codeIndex] = code;
+			codeIndex = writeIndex++;
+			code = 1;
+		}
+	}
+
+	destination[codeIndex] = code;
+
+	return writeIndex;
+}
+
+/**
+ * @brief 	This function writes the 32-bit number into the buffer, MSB first.
+ * @param 	buffer - A pointer to the buffer.
+ * @param 	value - The number.
+ * @retval	None.
+ */
+static void putUint32(uint8_t *buffer, uint32_t value)
+{
+	buffer[0] = (uint8_t)(value >> 24U);
+	buffer[1] = (uint8_t)(value >> 16U);
+	buffer[2] = (uint8_t)(value >> 8U);
+	buffer[3] = (uint8_t)value;
+}
+
+/**
+ * @brief 	This function reads the 32-bit number from the buffer, MSB first.
+ * @param 	buffer - A pointer to the buffer.
+ * @retval	The number.
+ */
+static uint32_t getUint32(const uint8_t *buffer)
+{
+	return ((uint32_t)buffer[0] << 24U) | ((uint32_t)buffer[1] << 16U) | ((uint32_t)buffer[2] << 8U) | (uint32_t)buffer[3];
+}
+
+/**
+ * @brief 	This function completes the reply in the reply buffer, frames it and transmits it.
+ * @note	The reply is queued and the function returns at once. The reply buffers are reused by the next
+ * 			reply only after this one is transmitted.
+ * @param 	command - The command of the request.
+ * @param 	status - The status of the command. This parameter can be a value of @ref PROTOCOL_status.
+ * @param 	sizePayload - The size of the reply payload which is already in the reply buffer.
+ * @retval	None.
+ */
+static void sendReply(uint8_t command, PROTOCOL_status status, uint16_t sizePayload)
+{
+	uint16_t size = REPLY_HEADER_SIZE + sizePayload;
+	uint16_t sizeFrame = 0;
+
+	PROTOCOL_waitReply();
+
+	replyBuffer[0] = command | PROTOCOL_REPLY_FLAG;
+	replyBuffer[1] = (uint8_t)status;
+
+	putUint32(&replyBuffer[size], CRC_calculate(replyBuffer, size));
+	size += CRC_SIZE;
+
+	txFrame[0] = PROTOCOL_FRAME_DELIMITER;
+	sizeFrame = encodeCOBS(replyBuffer, size, &txFrame[1]) + 1U;
+	txFrame[sizeFrame++] = PROTOCOL_FRAME_DELIMITER;
+
+	isReplyPending = 1;
+	UART_transmit(txFrame, sizeFrame, PROTOCOL_SIGNAL_REPLY_SENT);
+}
+
+//---------------------------------------------------------------------------
+// Command handlers
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function puts the message into the queue to the display and replies with the credits left.
+ * @note	The text is copied, because the frame buffer is reused by the next frame. The slots are taken in turn,
+ * 			there are as many of them as message structures, so a slot is free when its turn comes.
+ */
+static PROTOCOL_status putMessage(const uint8_t *text, uint16_t size, uint8_t flags, uint8_t *reply, uint16_t *sizeReply)
+{
+	PROTOCOL_status status = PROTOCOL_STATUS_OK;
+
+	if(UART_getCredits() == 0)
+	{
+		rejectedMessages++;
+		status = PROTOCOL_STATUS_NO_CREDITS;
+	} else
+	{
+		memcpy(messageText[messageSlot], text, size);
+
+		// The message structures are shared with the text lines, they can run out while the queue has room
+		if(UART_putMessage(messageText[messageSlot], size, flags))
+		{
+			messageSlot = (messageSlot + 1U) % UART_MESSAGE_POOL_SIZE;
+
+			// The plain message replaces the text, the next packed one can't continue the previous packed text
+			if(!(flags & UART_MESSAGE_PACKED)) isPackedTextOpen = 0;
+		} else
+		{
+			rejectedMessages++;
+			status = PROTOCOL_STATUS_NO_CREDITS;
+		}
+	}
+
+	reply[0] = UART_getCredits();
+	*sizeReply = 1U;
+
+	return status;
+}
+
+/**
+ * @brief 	This function shows the new message on the matrix and replies with the credits left.
+ */
+static PROTOCOL_status setMessage(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	return putMessage(payload, sizePayload, UART_MESSAGE_WHOLE, reply, sizeReply);
+}
+
+/**
+ * @brief 	This function sets the speed of the creeping line.
+ */
+static PROTOCOL_status setSpeed(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	if(payload[0] == 0) return PROTOCOL_STATUS_WRONG_VALUE;
+
+	LEDMATRIX_setSpeed(payload[0]);
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function sets the brightness of the matrix.
+ */
+static PROTOCOL_status setIntensity(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	if(payload[0] > INTENSITY_31_32) return PROTOCOL_STATUS_WRONG_VALUE;
+
+	LEDMATRIX_setIntensity((USH_MAX7219_REG_INTENSITY)payload[0]);
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function replies with the receive statistics: dropped lines, received frames, dropped frames.
+ */
+static PROTOCOL_status queryStats(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	const UART_rxStatisticsTypeDef *statistics = UART_getRxStatistics();
+
+	putUint32(&reply[0], statistics->droppedLines);
+	putUint32(&reply[4], statistics->receivedFrames);
+	putUint32(&reply[8], statistics->droppedFrames);
+	putUint32(&reply[12], statistics->droppedMessages);
+	putUint32(&reply[16], rejectedMessages);
+	putUint32(&reply[20], statistics->overwrittenMessages);
+	*sizeReply = 24U;
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function replies with the protocol version and the number of modules in the chain.
+ */
+static PROTOCOL_status queryVersion(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	reply[0] = PROTOCOL_VERSION_MAJOR;
+	reply[1] = PROTOCOL_VERSION_MINOR;
+	reply[2] = MAX7219_getDigits();
+	*sizeReply = 3U;
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function replies with the boot timeline.
+ */
+static PROTOCOL_status queryBoot(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	*sizeReply = BOOT_getReport(reply, PROTOCOL_PAYLOAD_MAX_SIZE);
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function requests the new baud rate. It is switched after the reply is sent.
+ */
+static PROTOCOL_status setBaudRate(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	return UART_requestBaudRate(getUint32(payload)) ? PROTOCOL_STATUS_OK : PROTOCOL_STATUS_WRONG_VALUE;
+}
+
+/**
+ * @brief 	This function replies with the number of messages which the display can take now.
+ */
+static PROTOCOL_status queryCredits(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	reply[0] = UART_getCredits();
+	*sizeReply = 1U;
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function replies with the error counters of the U(S)ART.
+ */
+static PROTOCOL_status queryErrors(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	const USH_USART_errorsTypeDef *errors = UART_getErrors();
+
+	putUint32(&reply[0], errors->parity);
+	putUint32(&reply[4], errors->framing);
+	putUint32(&reply[8], errors->noise);
+	putUint32(&reply[12], errors->overrun);
+	*sizeReply = 16U;
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function writes whole modules of the frame.
+ */
+static PROTOCOL_status setFrame(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	uint16_t sizeData = sizePayload - FRAME_HEADER_SIZE;
+
+	if((sizeData % MATRIX_HIGH) != 0) return PROTOCOL_STATUS_WRONG_SIZE;
+
+	if(!LEDMATRIX_writeFrame((uint16_t)payload[1] * MATRIX_HIGH, &payload[FRAME_HEADER_SIZE], sizeData))
+	{
+		return PROTOCOL_STATUS_WRONG_VALUE;
+	}
+
+	if(payload[0] & PROTOCOL_FRAME_PRESENT) LEDMATRIX_presentFrame();
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function writes the runs of changed bytes on top of the last frame.
+ * @note	All the runs are checked before the first one is written, so a broken request changes nothing.
+ */
+static PROTOCOL_status setFrameDelta(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	uint16_t index = 1U;
+	uint16_t offset = 0;
+	uint8_t length = 0;
+
+	for(uint8_t isWriting = 0; isWriting < 2U; isWriting++)
+	{
+		for(index = 1U; index < sizePayload; index += DELTA_RUN_HEADER_SIZE + length)
+		{
+			if((sizePayload - index) < DELTA_RUN_HEADER_SIZE) return PROTOCOL_STATUS_WRONG_SIZE;
+
+			offset = ((uint16_t)payload[index] << 8) | payload[index + 1U];
+			length = payload[index + 2U];
+
+			if((sizePayload - index - DELTA_RUN_HEADER_SIZE) < length) return PROTOCOL_STATUS_WRONG_SIZE;
+			if((offset + length) > LEDMATRIX_getFrameSize()) return PROTOCOL_STATUS_WRONG_VALUE;
+
+			if(isWriting) LEDMATRIX_writeFrame(offset, &payload[index + DELTA_RUN_HEADER_SIZE], length);
+		}
+	}
+
+	if(payload[0] & PROTOCOL_FRAME_PRESENT) LEDMATRIX_presentFrame();
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function shows the packed message on the matrix and replies with the credits left.
+ * @note	The request which follows the one with PROTOCOL_TEXT_MORE continues the same message, so the copies
+ * 			of the packed text reach into the previous requests.
+ */
+static PROTOCOL_status setMessagePacked(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	PROTOCOL_status status = PROTOCOL_STATUS_OK;
+	uint8_t flags = UART_MESSAGE_PACKED;
+
+	if(!isPackedTextOpen) flags |= UART_MESSAGE_FIRST_CHUNK;
+	if(!(payload[0] & PROTOCOL_TEXT_MORE)) flags |= UART_MESSAGE_LAST_CHUNK;
+
+	status = putMessage(&payload[1], sizePayload - 1U, flags, reply, sizeReply);
+
+	if(status == PROTOCOL_STATUS_OK) isPackedTextOpen = (payload[0] & PROTOCOL_TEXT_MORE) ? 1 : 0;
+
+	return status;
+}
+
+/**
+ * @brief 	This function fills the rectangle of the frame with the pattern.
+ */
+static PROTOCOL_status fillFrame(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	COMPOSE_rectTypeDef rect;
+
+	getRect(payload, &rect);
+
+	if(!LEDMATRIX_fillFrame(&rect, payload[RECT_HEADER_SIZE])) return PROTOCOL_STATUS_WRONG_VALUE;
+
+	if(payload[0] & PROTOCOL_FRAME_PRESENT) LEDMATRIX_presentFrame();
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function copies the rectangle of the last frame to another place of the frame.
+ */
+static PROTOCOL_status copyFrame(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	COMPOSE_rectTypeDef rect;
+
+	getRect(payload, &rect);
+
+	if(!LEDMATRIX_copyFrame(&rect, payload[RECT_HEADER_SIZE], payload[RECT_HEADER_SIZE + 1U])) return PROTOCOL_STATUS_WRONG_VALUE;
+
+	if(payload[0] & PROTOCOL_FRAME_PRESENT) LEDMATRIX_presentFrame();
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function blends the layer into the rectangle of the frame.
+ */
+static PROTOCOL_status blendFrame(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	COMPOSE_rectTypeDef rect;
+	uint16_t sizeLayer = 0;
+	const uint8_t *mask = NULL;
+
+	getRect(payload, &rect);
+	sizeLayer = (uint16_t)rect.modules * rect.lines;
+
+	if(payload[0] & PROTOCOL_FRAME_MASKED)
+	{
+		if((sizePayload - RECT_HEADER_SIZE) != (sizeLayer * 2U)) return PROTOCOL_STATUS_WRONG_SIZE;
+		mask = &payload[RECT_HEADER_SIZE + sizeLayer];
+	} else
+	{
+		if((sizePayload - RECT_HEADER_SIZE) != sizeLayer) return PROTOCOL_STATUS_WRONG_SIZE;
+	}
+
+	if(!LEDMATRIX_blendFrame(&rect, &payload[RECT_HEADER_SIZE], mask)) return PROTOCOL_STATUS_WRONG_VALUE;
+
+	if(payload[0] & PROTOCOL_FRAME_PRESENT) LEDMATRIX_presentFrame();
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function replies with the CPU usage of every thread since the previous query.
+ */
+static PROTOCOL_status queryTasks(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	MONITOR_taskUsageTypeDef usage[MONITOR_MAX_TASKS];
+	uint32_t interval = 0;
+	uint8_t count = MONITOR_getTaskUsage(usage, &interval);
+	uint16_t index = 4U;
+
+	putUint32(&reply[0], interval);
+
+	for(uint8_t task = 0; task < count; task++)
+	{
+		reply[index++] = usage[task].number;
+		putUint32(&reply[index], usage[task].runTime);
+		index += 4U;
+		reply[index++] = (uint8_t)(usage[task].permille >> 8);
+		reply[index++] = (uint8_t)usage[task].permille;
+
+		// The shorter name is padded with zeros
+		strncpy((char*)&reply[index], usage[task].name, TASK_NAME_SIZE);
+		index += TASK_NAME_SIZE;
+	}
+
+	*sizeReply = index;
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function replies with the high-water marks of the stacks of the threads.
+ */
+static PROTOCOL_status queryStacks(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	MONITOR_stackUsageTypeDef usage[MONITOR_MAX_TASKS];
+	uint8_t count = MONITOR_getStackUsage(usage);
+	uint16_t index = 0;
+
+	reply[index++] = (uint8_t)(MONITOR_STACK_MARGIN >> 8);
+	reply[index++] = (uint8_t)MONITOR_STACK_MARGIN;
+
+	for(uint8_t task = 0; task < count; task++)
+	{
+		reply[index++] = usage[task].number;
+		reply[index++] = (uint8_t)(usage[task].minFree >> 8);
+		reply[index++] = (uint8_t)usage[task].minFree;
+
+		// The shorter name is padded with zeros
+		strncpy((char*)&reply[index], usage[task].name, TASK_NAME_SIZE);
+		index += TASK_NAME_SIZE;
+	}
+
+	*sizeReply = index;
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function replies with the state of the heap and the histogram of the sizes of its blocks.
+ */
+static PROTOCOL_status queryHeap(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	HEAP_statsTypeDef stats;
+
+	HEAP_getStats(&stats);
+
+	putUint32(&reply[0], stats.freeBytes);
+	putUint32(&reply[4], stats.minFreeBytes);
+	putUint32(&reply[8], stats.largestFreeBlock);
+	putUint32(&reply[12], stats.freeBlocks);
+	reply[16] = (uint8_t)(stats.fragmentation >> 8);
+	reply[17] = (uint8_t)stats.fragmentation;
+	putUint32(&reply[18], stats.untracked);
+	*sizeReply = 22U;
+
+	for(uint8_t sizeClass = 0; sizeClass < HEAP_SIZE_CLASS_COUNT; sizeClass++)
+	{
+		putUint32(&reply[*sizeReply], stats.sizeClasses[sizeClass]);
+		*sizeReply += 4U;
+	}
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function replies with the leak report, the blocks of every tag.
+ */
+static PROTOCOL_status queryHeapTags(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	HEAP_tagTypeDef statistics;
+	uint16_t index = 0;
+
+	for(uint8_t tag = 0; tag < HEAP_TAG_COUNT; tag++)
+	{
+		HEAP_getTag((HEAP_tag)tag, &statistics);
+
+		putUint32(&reply[index], statistics.allocations);
+		putUint32(&reply[index + 4U], statistics.frees);
+		reply[index + 8U] = (uint8_t)(statistics.failures >> 8);
+		reply[index + 9U] = (uint8_t)statistics.failures;
+		putUint32(&reply[index + 10U], statistics.bytes);
+		index += 14U;
+	}
+
+	*sizeReply = index;
+
+	return PROTOCOL_STATUS_OK;
+}
+
+#ifdef PROFILE
+/**
+ * @brief 	This function replies with the statistics of the profiled region.
+ */
+static PROTOCOL_status queryProfile(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	PROFILE_regionTypeDef statistics;
+
+	if(!PROFILE_read((PROFILE_region)payload[0], &statistics)) return PROTOCOL_STATUS_WRONG_VALUE;
+
+	if((sizePayload > 1U) && (payload[1] & PROTOCOL_PROFILE_RESET)) PROFILE_reset((PROFILE_region)payload[0]);
+
+	putUint32(&reply[0], statistics.count);
+	putUint32(&reply[4], statistics.min);
+	putUint32(&reply[8], statistics.max);
+	putUint32(&reply[12], (statistics.count != 0) ? (uint32_t)(statistics.sum / statistics.count) : 0U);
+	*sizeReply = 16U;
+
+	for(uint8_t bucket = 0; bucket < PROFILE_BUCKET_COUNT; bucket++)
+	{
+		putUint32(&reply[*sizeReply], statistics.buckets[bucket]);
+		*sizeReply += 4U;
+	}
+
+	return PROTOCOL_STATUS_OK;
+}
+
+/**
+ * @brief 	This function runs the copy or fill of the size by CPU and by the stream of memdma.
+ * @note	The thread of the protocol waits for the runs, the frames of the display go on meanwhile.
+ */
+static PROTOCOL_status benchMemdma(const uint8_t *payload, uint16_t sizePayload, uint8_t *reply, uint16_t *sizeReply)
+{
+	uint16_t size = ((uint16_t)payload[1] << 8) | payload[2];
+
+	if((payload[0] > 1U) || (size == 0) || (size > MEMDMA_BENCHMARK_MAX_SIZE) || (payload[3] == 0))
+	{
+		return PROTOCOL_STATUS_WRONG_VALUE;
+	}
+
+	return MEMDMA_benchmark(payload[0], size, payload[3]) ? PROTOCOL_STATUS_OK : PROTOCOL_STATUS_FAILED;
+}
+#endif
+
+//---------------------------------------------------------------------------
+// Helpers of the command handlers
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function reads the rectangle which follows the flags of the request.
+ * @param 	payload - A pointer to the payload of the request.
+ * @param 	rect - A pointer to the rectangle.
+ * @retval	None.
+ */
+static void getRect(const uint8_t *payload, COMPOSE_rectTypeDef *rect)
+{
+	rect->module = payload[1];
+	rect->line = payload[2];
+	rect->modules = payload[3];
+	rect->lines = payload[4];
+}
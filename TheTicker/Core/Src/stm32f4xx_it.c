@@ -4,13 +4,6 @@
 #include "main.h"
 #include "stm32f4xx_it.h"
 
-//---------------------------------------------------------------------------
-// External variables
-//---------------------------------------------------------------------------
-extern USH_DMA_initTypeDef initDMA_txStructure;
-extern USH_DMA_initTypeDef initDMA_rxStructure;
-extern USH_USART_initTypeDef uart_structure;
-
 /******************************************************************************/
 /*           Cortex-M4 Processor Interruption and Exception Handlers          */
 /******************************************************************************/
@@ -88,17 +81,137 @@ void DebugMon_Handler(void)
 /**
   * @brief This function handles DMA1 stream0 global interrupt.
   */
-void DMA2_Stream7_IRQHandler(void)
+void DMA1_Stream0_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA1_Stream0);
+}
+
+/**
+  * @brief This function handles DMA1 stream1 global interrupt.
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA1_Stream1);
+}
+
+/**
+  * @brief This function handles DMA1 stream2 global interrupt.
+  */
+void DMA1_Stream2_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA1_Stream2);
+}
+
+/**
+  * @brief This function handles DMA1 stream3 global interrupt.
+  */
+void DMA1_Stream3_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA1_Stream3);
+}
+
+/**
+  * @brief This function handles DMA1 stream4 global interrupt.
+  */
+void DMA1_Stream4_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA1_Stream4);
+}
+
+/**
+  * @brief This function handles DMA1 stream5 global interrupt.
+  */
+void DMA1_Stream5_IRQHandler(void)
 {
-	DMA_IRQHandler(&initDMA_txStructure);
+	DMA_IRQHandler(DMA1_Stream5);
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt.
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA1_Stream6);
 }
 
 /**
   * @brief This function handles DMA1 stream7 global interrupt.
   */
+void DMA1_Stream7_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA1_Stream7);
+}
+
+/**
+  * @brief This function handles DMA2 stream0 global interrupt.
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+	PROFILE_BEGIN(PROFILE_REGION_ISR_MEMDMA);
+	DMA_IRQHandler(DMA2_Stream0);
+	PROFILE_END(PROFILE_REGION_ISR_MEMDMA);
+}
+
+/**
+  * @brief This function handles DMA2 stream1 global interrupt.
+  */
+void DMA2_Stream1_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA2_Stream1);
+}
+
+/**
+  * @brief This function handles DMA2 stream2 global interrupt.
+  */
 void DMA2_Stream2_IRQHandler(void)
 {
-	DMA_IRQHandler(&initDMA_rxStructure);
+	PROFILE_BEGIN(PROFILE_REGION_ISR_USART_DMA);
+	DMA_IRQHandler(DMA2_Stream2);
+	PROFILE_END(PROFILE_REGION_ISR_USART_DMA);
+}
+
+/**
+  * @brief This function handles DMA2 stream3 global interrupt.
+  */
+void DMA2_Stream3_IRQHandler(void)
+{
+	PROFILE_BEGIN(PROFILE_REGION_ISR_SPI_DMA);
+	DMA_IRQHandler(DMA2_Stream3);
+	PROFILE_END(PROFILE_REGION_ISR_SPI_DMA);
+}
+
+/**
+  * @brief This function handles DMA2 stream4 global interrupt.
+  */
+void DMA2_Stream4_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA2_Stream4);
+}
+
+/**
+  * @brief This function handles DMA2 stream5 global interrupt.
+  */
+void DMA2_Stream5_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA2_Stream5);
+}
+
+/**
+  * @brief This function handles DMA2 stream6 global interrupt.
+  */
+void DMA2_Stream6_IRQHandler(void)
+{
+	DMA_IRQHandler(DMA2_Stream6);
+}
+
+/**
+  * @brief This function handles DMA2 stream7 global interrupt.
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+	PROFILE_BEGIN(PROFILE_REGION_ISR_USART_DMA);
+	DMA_IRQHandler(DMA2_Stream7);
+	PROFILE_END(PROFILE_REGION_ISR_USART_DMA);
 }
 
 /**
@@ -106,21 +219,71 @@ void DMA2_Stream2_IRQHandler(void)
   */
 void USART1_IRQHandler(void)
 {
-	USART_IRQHandler(&uart_structure);
+	PROFILE_BEGIN(PROFILE_REGION_ISR_USART);
+	USART_instanceIRQHandler(USART1);
+	PROFILE_END(PROFILE_REGION_ISR_USART);
 }
 
 /**
-  * @brief This function handles TIM8 trigger and commutation interrupts and TIM14 global interrupt.
+  * @brief This function handles USART2 global interrupt.
   */
-void TIM8_TRG_COM_TIM14_IRQHandler(void)
+void USART2_IRQHandler(void)
 {
-	if((TIM14->SR & TIM_SR_UIF) == TIM_SR_UIF)
-	{
-		if((TIM14->DIER & TIM_DIER_UIE) == TIM_DIER_UIE)
-		{
-			TIM14->SR = ~TIM_DIER_UIE;
+	USART_instanceIRQHandler(USART2);
+}
 
-			MISC_timeoutTimerIncTick();
-		}
-	}
+/**
+  * @brief This function handles USART3 global interrupt.
+  */
+void USART3_IRQHandler(void)
+{
+	USART_instanceIRQHandler(USART3);
+}
+
+/**
+  * @brief This function handles UART4 global interrupt.
+  */
+void UART4_IRQHandler(void)
+{
+	USART_instanceIRQHandler(UART4);
+}
+
+/**
+  * @brief This function handles UART5 global interrupt.
+  */
+void UART5_IRQHandler(void)
+{
+	USART_instanceIRQHandler(UART5);
+}
+
+/**
+  * @brief This function handles USART6 global interrupt.
+  */
+void USART6_IRQHandler(void)
+{
+	USART_instanceIRQHandler(USART6);
+}
+
+/**
+  * @brief This function handles UART7 global interrupt.
+  */
+void UART7_IRQHandler(void)
+{
+	USART_instanceIRQHandler(UART7);
+}
+
+/**
+  * @brief This function handles UART8 global interrupt.
+  */
+void UART8_IRQHandler(void)
+{
+	USART_instanceIRQHandler(UART8);
+}
+
+/**
+  * @brief This function handles DMA2D global interrupt.
+  */
+void DMA2D_IRQHandler(void)
+{
+	COMPOSE_IRQHandler();
 }
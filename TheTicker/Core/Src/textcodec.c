@@ -0,0 +1,85 @@
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "textcodec.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define DICTIONARY_SIZE			(sizeof(dictionary) / sizeof(dictionary[0]))
+
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+
+// The host has to use the same table, see DICTIONARY of Tools/textcodec.py. New entries are added only at the end,
+// up to 64 of them.
+static const char* const dictionary[] =
+{
+	" USD", " EUR", " GBP", " JPY", " CHF", " CNY", " BTC", " ETH",		// 0x80
+	"USD/", "EUR/", "GBP/", "BTC/", " +", " -", "% ", ".00",				// 0x88
+	"0.", ".5", ", ", " | ", " >> ", " << ", " ^ ", " v ",					// 0x90
+	"NASDAQ ", "DOW ", "S&P 500 ", "FTSE ", "DAX ", "NIKKEI ", "Oil ", "Gold ",	// 0x98
+	"Bid ", "Ask ", "Open ", "Close ", "High ", "Low ", "Vol ", "Change ",	// 0xA0
+	"News: ", "Weather: ", " the ", " and ", " up ", " down ", "    ", "000",	// 0xA8
+};
+
+//---------------------------------------------------------------------------
+// Others functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function decodes the packed message and appends it to the text.
+ * @note	The message is read straight from the buffer which contains it, no decoded copy is made apart from
+ * 			the text itself. The text which doesn't fit into sizeMax is cut off, the broken codes are skipped.
+ * @param 	message - A pointer to the message structure.
+ * @param 	text - A pointer to the text.
+ * @param 	sizeText - The size of the text decoded before, the copies can reach into it.
+ * @param 	sizeMax - The size of the text buffer.
+ * @retval	The size of the text after the message is appended.
+ */
+uint16_t TEXTCODEC_decode(const UART_messageTypeDef *message, uint8_t *text, uint16_t sizeText, uint16_t sizeMax)
+{
+	uint16_t index = 0;
+	uint16_t distance = 0;
+	uint8_t length = 0;
+	uint8_t code = 0;
+	const char *entry = NULL;
+
+	while((index < message->sizeMessage) && (sizeText < sizeMax))
+	{
+		code = UART_getSymbol(message, index++);
+
+		if(code < TEXTCODEC_DICTIONARY_BASE)
+		{
+			text[sizeText++] = code;
+
+		} else if(code < TEXTCODEC_COPY_BASE)
+		{
+			if((uint8_t)(code - TEXTCODEC_DICTIONARY_BASE) >= DICTIONARY_SIZE) continue;
+
+			for(entry = dictionary[code - TEXTCODEC_DICTIONARY_BASE]; (*entry != '\0') && (sizeText < sizeMax); entry++)
+			{
+				text[sizeText++] = (uint8_t)*entry;
+			}
+
+		} else
+		{
+			if(index == message->sizeMessage) break;
+
+			length = (uint8_t)(code - TEXTCODEC_COPY_BASE + TEXTCODEC_COPY_MIN_SIZE);
+			distance = (uint16_t)UART_getSymbol(message, index++) + 1U;
+
+			if(distance > sizeText) continue;
+
+			// Symbol by symbol, because the copy can overlap the symbols it produces
+			for(; (length > 0) && (sizeText < sizeMax); length--)
+			{
+				text[sizeText] = text[sizeText - distance];
+				sizeText++;
+			}
+		}
+	}
+
+	return sizeText;
+}
@@ -9,11 +9,78 @@
 //---------------------------------------------------------------------------
 
 // Configuration UART
-#define USED_UART		(USART1)
-#define USED_PINSPACK	(USART_PINSPACK_1)
-#define USED_BAUDRATE	((uint32_t)115200)
+#define USED_UART			(USART1)
+#define USED_PINSPACK		(USART_PINSPACK_1)
+#define USED_BAUDRATE		((uint32_t)115200)		// The baud rate after reset, it can be changed by the protocol
+#define USED_FLOW_CONTROL	(USART_HW_FLOW_CONTROL_RTS)	// Use USART_HW_FLOW_CONTROL_RTS_CTS when the host's RTS is wired to PA11
+#define MIN_BAUDRATE		((uint32_t)2400)		// BRR mantissa has 12 bits
 
-#define RX_BUFFER_SIZE	(256U)
+#define RX_BUFFER_SIZE	(1024U)		// 2.5 ms at 4 Mbaud between the half and complete transfer events
+
+// The counter of the written symbols wraps, the position in the buffer has to stay the same
+#if (RX_BUFFER_SIZE & (RX_BUFFER_SIZE - 1U)) != 0
+#error "RX_BUFFER_SIZE has to be a power of two"
+#endif
+
+// Autobaud. When it is enabled, the host has to send AUTOBAUD_SYNC_BYTE repeatedly after reset until the welcome
+// string comes back. '\r' is chosen because the line parser skips it. Comment out UART_AUTOBAUD to start at USED_BAUDRATE.
+//#define UART_AUTOBAUD
+#define AUTOBAUD_SYNC_BYTE		((uint8_t)'\r')
+#define AUTOBAUD_WINDOW			((uint32_t)50)		// ms spent listening at every baud rate
+
+
+#define TX_QUEUE_SIZE			(8U)
+
+#define SIGNAL_BOOT_COMPLETE	((int32_t)0x01)
+#define BOOT_REPORT_TIMEOUT		((uint32_t)5000)	// ms
+
+// A longer line is sent to the display in chunks. All the chunks which can be alive in the message pool take
+// three quarters of the RX buffer at most. The other traffic (frames, skipped lines) moves the DMA on as well,
+// so a chunk can still be overwritten before the display copies it, UART_checkMessage catches it.
+#define MESSAGE_CHUNK_SIZE		(RX_BUFFER_SIZE / 8U)
+
+#define IS_LINE_DELIMITER(SYMBOL)	(((SYMBOL) == '\n') || ((SYMBOL) == '\r'))
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Line parser states enumeration
+ */
+typedef enum
+{
+	PARSER_STATE_IDLE = 0,		/* Between lines, delimiters are skipped */
+	PARSER_STATE_LINE,			/* A line is being received */
+	PARSER_STATE_OVERFLOW,		/* The line is broken, it is skipped till the delimiter */
+	PARSER_STATE_FRAME,			/* A binary frame is being received */
+	PARSER_STATE_FRAME_OVERFLOW	/* The frame is too long, it is skipped till the delimiter */
+} UART_parserState;
+
+/**
+ * @brief Line parser structure
+ */
+typedef struct
+{
+	UART_parserState state;		/* The current state of the parser */
+	uint16_t position;			/* The index up to which the RX buffer is parsed */
+	uint16_t lineStart;			/* The index of the first symbol of the current line */
+	uint16_t sizeLine;			/* The number of received symbols of the current chunk of the line */
+	uint8_t isContinued;		/* A chunk of the current line has already been sent */
+	uint8_t isTerminatorPending;	/* The last chunk of the broken line couldn't be queued yet */
+	uint16_t sizeFrame;			/* The number of received bytes of the current frame */
+} UART_parserTypeDef;
+
+/**
+ * @brief Transmit request structure
+ */
+typedef struct
+{
+	const uint8_t *data;		/* A pointer to the data, it has to stay unchanged till the transmission is over */
+	uint16_t size;				/* The size of the data */
+	osThreadId thread;			/* The thread to be notified when the data is transmitted */
+	int32_t signal;				/* The signal to be set, 0 - no notification */
+} UART_txRequestTypeDef;
 
 //---------------------------------------------------------------------------
 // Descriptions of FreeRTOS elements
@@ -22,12 +89,24 @@ static osThreadId idleIRQTaskHandle;
 static osPoolId	messageStructHandle;
 osMessageQId fromUartToMatrixHandle;
 static osSemaphoreId idleIRQHandle;
+static osSemaphoreId txSlotsHandle;
 
 //---------------------------------------------------------------------------
 // Static function prototypes
 //---------------------------------------------------------------------------
 static void UART_init(void);
-static uint8_t* messageCapture(USART_TypeDef* usart, uint8_t* sourceBuffer, uint16_t sizeSourceBuffer);
+static void messageCapture(USART_TypeDef* usart, const uint8_t* sourceBuffer, uint16_t sizeSourceBuffer);
+static void resynchronize(void);
+static void terminateLine(void);
+static uint8_t sendMessage(const uint8_t* sourceBuffer, uint16_t sizeSourceBuffer, uint16_t offset, uint16_t size, uint8_t flags);
+static void setDefaultMessage(UART_messageTypeDef *message);
+static uint16_t getRxPosition(void);
+static void startTransmit(void);
+static void completeTransmit(void);
+static uint8_t switchBaudRate(uint32_t baudrate);
+#ifdef UART_AUTOBAUD
+static void detectBaudRate(void);
+#endif
 
 //---------------------------------------------------------------------------
 // Description of peripheral structures
@@ -38,9 +117,31 @@ USH_USART_initTypeDef uart_structure = {0};
 // Variables
 //---------------------------------------------------------------------------
 static uint8_t rxBuffer[RX_BUFFER_SIZE];
+static uint8_t bootReport[BOOT_REPORT_SIZE];
+static UART_rxStatisticsTypeDef rxStatistics;
+static UART_parserTypeDef parser;
+static uint8_t frameBuffer[PROTOCOL_FRAME_MAX_SIZE];
+static volatile uint32_t requestedBaudRate;
+static volatile uint32_t rxWritten;			// The symbols written by the RX DMA till the last capture, it wraps
+static volatile uint16_t resyncPosition;	// The DMA write position at the moment of the last overrun
+static volatile uint8_t isResyncPending;
+#ifdef PROFILE
+static volatile uint32_t rxEventStamp;		// The time of the last event which woke the parser up
+#endif
+static UART_txRequestTypeDef txQueue[TX_QUEUE_SIZE];
+static volatile uint8_t txHead;		// The request being transmitted
+static volatile uint8_t txCount;	// The number of requests in the queue including the one being transmitted
+static volatile uint8_t isTxReady;	// The U(S)ART is initialized, the requests queued before wait for it
+static volatile uint8_t isTxActive;	// A request is being transmitted
+static volatile uint8_t isTxPaused;	// The queue isn't chained after txBeforePause requests, see switchBaudRate
+static volatile uint8_t txBeforePause;
+#ifdef UART_AUTOBAUD
+static const uint32_t autobaudRates[] = {115200, 230400, 460800, 921600, 1000000, 2000000, 3000000, 4000000, 9600, 57600};
+#endif
 static const uint8_t defaultString[] = "Hi, please enter your message. ";
 static const uint8_t welcomeString[] = "Hi, please enter your message.\r\n";
-static const uint8_t noteMessage[] = "NOTE: Every message has to have only one system symbol (\\n).\r\n";
+static const uint8_t noteMessage[] = "NOTE: Every message has to end with \\n or \\r\\n. Several messages can be sent at once. "
+									 "Binary frames (COBS + CRC) start and end with 0x00.\r\n";
 
 //---------------------------------------------------------------------------
 // FreeRTOS's threads
@@ -53,33 +154,69 @@ static const uint8_t noteMessage[] = "NOTE: Every message has to have only one s
  */
 void idleIRQTask(void const *argument)
 {
-	UART_messageTypeDef *message = (UART_messageTypeDef*)osPoolCAlloc(messageStructHandle);
-	uint8_t flagFirstStart = 1;
+	UART_messageTypeDef *message = (UART_messageTypeDef*)osPoolAlloc(messageStructHandle);
+	uint32_t baudrate = 0;
+	uint8_t isIdle = 0;
+
+	// Hand the default string over to the display before the U(S)ART bring-up,
+	// so the first frame doesn't wait for it.
+	setDefaultMessage(message);
+	osMessagePut(fromUartToMatrixHandle, (uint32_t)message, osWaitForever);
+
+	// The semaphore is created with a token, take it in order not to parse an empty RX buffer
+	osSemaphoreWait(idleIRQHandle, osWaitForever);
 
 	UART_init();
 
+#ifdef UART_AUTOBAUD
+	detectBaudRate();
+#endif
+
 	USART_receiveToIdleDMA(USED_UART, rxBuffer, sizeof(rxBuffer));
-	USART_transmitDMA(USED_UART, (uint8_t*)welcomeString, strlen((char*)welcomeString));
-	USART_transmitDMA(USED_UART, (uint8_t*)noteMessage, strlen((char*)noteMessage));
+
+	// Start the requests which have been queued before the initialization
+	taskENTER_CRITICAL();
+	isTxReady = 1;
+	isIdle = (txCount != 0);
+	if(isIdle) isTxActive = 1;
+	taskEXIT_CRITICAL();
+
+	if(isIdle) startTransmit();
+
+	UART_transmit(welcomeString, strlen((char*)welcomeString), 0);
+	UART_transmit(noteMessage, strlen((char*)noteMessage), 0);
+
+	// Report the boot timeline as soon as the first frame is shown
+	osSignalWait(SIGNAL_BOOT_COMPLETE, BOOT_REPORT_TIMEOUT);
+	UART_transmit(bootReport, BOOT_getReport(bootReport, sizeof(bootReport)), 0);
 
 	/* Infinite loop */
 	for(;;)
 	{
 		osSemaphoreWait(idleIRQHandle, osWaitForever);
 
-		if(flagFirstStart)
-		{
-			message->message = (uint8_t*)defaultString;
-			message->sizeMessage = strlen((char*)defaultString);
+		PROFILE_BEGIN(PROFILE_REGION_CAPTURE);
+		messageCapture(USED_UART, rxBuffer, sizeof(rxBuffer));
+		PROFILE_END(PROFILE_REGION_CAPTURE);
 
-			flagFirstStart = 0;
-		} else
+		// The baud rate is changed after the reply to the request is sent at the old one
+		if(requestedBaudRate != 0)
 		{
-			message->message = messageCapture(USED_UART, rxBuffer, sizeof(rxBuffer));
-			message->sizeMessage = strlen((char*)message->message);
+			baudrate = requestedBaudRate;
+			requestedBaudRate = 0;
+
+			PROTOCOL_waitReply();
+
+			if(switchBaudRate(baudrate))
+			{
+				PROTOCOL_confirmBaudRate(baudrate, 1);
+				LOG_INFO("UART baud rate %u", baudrate);
+			} else
+			{
+				PROTOCOL_confirmBaudRate(baudrate, 0);
+				LOG_ERROR("UART baud rate %u failed", baudrate);
+			}
 		}
-
-		osMessagePut(fromUartToMatrixHandle, (uint32_t)message, osWaitForever);
 	}
 }
 
@@ -88,81 +225,386 @@ void idleIRQTask(void const *argument)
 //---------------------------------------------------------------------------
 
 /**
- * @brief 	This function parses the RX buffer and grabs messages from it.
- * @note	Each message has system characters at the end \r and \n. They are not needed for output to the matrix.
- * 			In the code, these two characters are replaced by one space (' ') character.
+ * @brief 	This function parses the new data in the RX buffer and sends every complete line to the display.
+ * @note	It is called on the IDLE event and on the half and complete transfer events of the RX DMA stream.
+ * 			The parser works symbol by symbol, so any number of lines can be received between two events and
+ * 			the unfinished line is carried over to the next call. A line which is longer than MESSAGE_CHUNK_SIZE
+ * 			is sent in chunks as it comes, so its length isn't limited by the RX buffer.
+ * @note	Each line ends with \n or \r\n. The first delimiter is left at the end of the message and the LedMatrix
+ * 			module outputs it as a space. Empty lines are skipped.
+ * @note	A binary frame starts and ends with 0x00, see protocol.h. The frame is copied out of the RX buffer,
+ * 			because the protocol module decodes it in place.
  * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
  * @param 	sourceBuffer - A pointer to RX buffer.
  * @param 	sizeSourceBuffer - Size of RX buffer.
- * @retval	A pointer to the created string.
+ * @retval	None.
  */
-static uint8_t* messageCapture(USART_TypeDef* usart, uint8_t* sourceBuffer, uint16_t sizeSourceBuffer)
+static void messageCapture(USART_TypeDef* usart, const uint8_t* sourceBuffer, uint16_t sizeSourceBuffer)
 {
-	static uint16_t oldPosition	= 0;	// necessary variables to calculate the length of the received message
-	uint16_t position = 0;				// and the index in the RX buffer
-	uint8_t sizeString = 0;
-	uint8_t* string;
+	uint16_t position = 0;
+	uint8_t symbol = 0;
 
 	// Get DMA stream
 	DMA_Stream_TypeDef* DMA_Stream = USART_getDmaStream(usart, USART_MODE_RX);
 
 	position = sizeSourceBuffer - DMA_getNumberOfData(DMA_Stream);
+	if(position == sizeSourceBuffer) position = 0;
+
+	// The capture runs at least every half of the buffer, so the DMA is never a lap ahead
+	rxWritten += ((uint32_t)position - rxWritten) % sizeSourceBuffer;
 
-	if(position > oldPosition)
+	if(parser.isTerminatorPending) terminateLine();
+
+	while(parser.position != position)
 	{
-		sizeString = position - oldPosition;
+		if(isResyncPending && (parser.position == resyncPosition)) resynchronize();
+
+		symbol = sourceBuffer[parser.position];
 
-		/* There are cases when only a service character can be received. And if it is processed as a normal message,
-		   then the program does not work correctly. Therefore, this code is designed to handle such a situation.
-		   When we receive a 1-byte message, we simply return a pointer to a default string. */
-		if(sizeString <= 1)
+		switch(parser.state)
 		{
-			string = (uint8_t*)defaultString;
+			case PARSER_STATE_IDLE:
+				if(symbol == PROTOCOL_FRAME_DELIMITER)
+				{
+					parser.sizeFrame = 0;
+					parser.state = PARSER_STATE_FRAME;
+
+				} else if(!IS_LINE_DELIMITER(symbol))
+				{
+					parser.lineStart = parser.position;
+					parser.sizeLine = 1;
+					parser.isContinued = 0;
+					parser.state = PARSER_STATE_LINE;
+				}
+				break;
+
+			case PARSER_STATE_LINE:
+				parser.sizeLine++;
+
+				if(IS_LINE_DELIMITER(symbol))
+				{
+					sendMessage(sourceBuffer, sizeSourceBuffer, parser.lineStart, parser.sizeLine,
+								parser.isContinued ? UART_MESSAGE_LAST_CHUNK : UART_MESSAGE_WHOLE);
+					parser.state = PARSER_STATE_IDLE;
+
+				} else if(parser.sizeLine >= MESSAGE_CHUNK_SIZE)	// The line goes on in the next chunk
+				{
+					if(sendMessage(sourceBuffer, sizeSourceBuffer, parser.lineStart, parser.sizeLine,
+								   parser.isContinued ? 0 : UART_MESSAGE_FIRST_CHUNK))
+					{
+						parser.lineStart = (parser.position + 1U) % sizeSourceBuffer;
+						parser.sizeLine = 0;
+						parser.isContinued = 1;
+					} else
+					{
+						rxStatistics.droppedLines++;
+						parser.state = PARSER_STATE_OVERFLOW;
+
+						// The display shows the chunks which have already been sent
+						if(parser.isContinued) terminateLine();
+					}
+				}
+				break;
+
+			case PARSER_STATE_OVERFLOW:
+				if(IS_LINE_DELIMITER(symbol)) parser.state = PARSER_STATE_IDLE;
+				break;
+
+			case PARSER_STATE_FRAME:
+				if(symbol != PROTOCOL_FRAME_DELIMITER)
+				{
+					if(parser.sizeFrame < sizeof(frameBuffer))
+					{
+						frameBuffer[parser.sizeFrame++] = symbol;
+					} else
+					{
+						rxStatistics.droppedFrames++;
+						parser.state = PARSER_STATE_FRAME_OVERFLOW;
+					}
+
+				} else if(parser.sizeFrame != 0)	// Repeated delimiters are skipped
+				{
+					if(PROTOCOL_processFrame(frameBuffer, parser.sizeFrame))
+					{
+						rxStatistics.receivedFrames++;
+					} else
+					{
+						rxStatistics.droppedFrames++;
+					}
+
+					parser.state = PARSER_STATE_IDLE;
+				}
+				break;
+
+			case PARSER_STATE_FRAME_OVERFLOW:
+				if(symbol == PROTOCOL_FRAME_DELIMITER) parser.state = PARSER_STATE_IDLE;
+				break;
+
+			default:
+				parser.state = PARSER_STATE_IDLE;
+				break;
+		}
+
+		if(++parser.position == sizeSourceBuffer) parser.position = 0;
+	}
+
+	if(isResyncPending && (parser.position == resyncPosition)) resynchronize();
+}
+
+/**
+ * @brief 	This function drops the line or the frame which lost symbols in the overrun.
+ * @note	It is called when the parser reaches the position where DMA was writing at the moment of the overrun.
+ * 			The symbols before it are intact. The symbols after it are skipped till the next delimiter, because
+ * 			the lost ones could have been a delimiter or the beginning of the line.
+ * @retval	None.
+ */
+static void resynchronize(void)
+{
+	isResyncPending = 0;
+
+	switch(parser.state)
+	{
+		case PARSER_STATE_LINE:
+			rxStatistics.droppedLines++;
+			parser.state = PARSER_STATE_OVERFLOW;
 
-		} else if((sizeString > 1) && (sizeString <= OUTPUT_BUFFER_MIN_ROW)) // When only 3 characters need to be transmitted, 4 (3 + '\n') are actually transmitted.
-			   {
-					// Allocate memory for line 4 + 1. 1 for '\0' symbol
-					string = (uint8_t*)pvPortMalloc(((OUTPUT_BUFFER_MIN_ROW + 1) * (sizeof(uint8_t))));
+			// The display shows the chunks which have already been sent
+			if(parser.isContinued) terminateLine();
+			break;
 
-					// Fill the entire string with character ' ' and explicitly specify character '\0' at the last index of the string.
-					memset(string, ' ', OUTPUT_BUFFER_MIN_ROW);
-					string[OUTPUT_BUFFER_MIN_ROW] = '\0';
+		case PARSER_STATE_FRAME:
+			rxStatistics.droppedFrames++;
+			parser.state = PARSER_STATE_FRAME_OVERFLOW;
+			break;
 
-					// Сopy payload from rx buffer to the string.
-					memcpy(string, &rxBuffer[oldPosition], sizeString - 1); // - '\n'
+		case PARSER_STATE_IDLE:
+			parser.state = PARSER_STATE_OVERFLOW;
+			break;
 
-			    } else
-			    {
-			    	// Allocate memory for line sizeString + 1. 1 for '\0' symbol
-			    	string = (uint8_t*)pvPortMalloc(((sizeString + 1) * sizeof(uint8_t)));
+		default:
+			break;
+	}
+}
 
-			    	// Fill the entire string with character ' ' and explicitly specify character '\0' at the last index of the string.
-			    	memset(string, ' ', sizeString);
-			    	string[sizeString] = '\0';
+/**
+ * @brief 	This function ends the broken line whose chunks have already been sent to the display.
+ * @note	The display loops the text only after its last chunk. When the pool is empty, the terminator is
+ * 			sent on the next call of messageCapture, unless a new line replaces the broken one before.
+ * @retval	None.
+ */
+static void terminateLine(void)
+{
+	parser.isTerminatorPending = !sendMessage(NULL, 0, 0, 0, UART_MESSAGE_LAST_CHUNK);
+}
 
-			    	// Сopy payload from rx buffer to the string.
-			    	memcpy(string, &sourceBuffer[oldPosition], sizeString - 1); // - '\n'
-			    }
+/**
+ * @brief 	This function describes the line in the RX buffer and puts it into the queue to the display.
+ * @note	The function doesn't wait for the display. When the queue is full, the message is dropped and counted,
+ * 			so the RX buffer keeps being read out. The host should follow the credits, see UART_getCredits.
+ * @param 	sourceBuffer - A pointer to RX buffer.
+ * @param 	sizeSourceBuffer - Size of RX buffer.
+ * @param 	offset - The index of the first symbol of the line.
+ * @param 	size - The size of the line including the delimiter.
+ * @param 	flags - The part of the line. This parameter can be a combination of @ref UART_messageFlags.
+ * @retval	1 if the message is queued, 0 if it is dropped.
+ */
+static uint8_t sendMessage(const uint8_t* sourceBuffer, uint16_t sizeSourceBuffer, uint16_t offset, uint16_t size, uint8_t flags)
+{
+	// The pool has a spare structure for every message in the queue and for the one being rendered
+	UART_messageTypeDef *message = (UART_messageTypeDef*)osPoolAlloc(messageStructHandle);
+
+	if(message == NULL)
+	{
+		rxStatistics.droppedMessages++;
+		return 0;
+	}
+
+	message->buffer			= sourceBuffer;
+	message->sizeBuffer		= sizeSourceBuffer;
+	message->offset			= offset;
+	message->sizeMessage	= size;
+	message->sizeWrap		= ((offset + size) > sizeSourceBuffer) ? ((offset + size) - sizeSourceBuffer) : 0;
+	message->flags			= flags;
+
+	// The first symbol is already written, so it's at most a lap behind the DMA
+	message->mark			= rxWritten - 1U - ((rxWritten - 1U - offset) % RX_BUFFER_SIZE);
+
+#ifdef PROFILE
+	message->latency.received = rxEventStamp;
+	PROFILE_STAMP(message->latency.parsed);
+#endif
+
+	if(osMessagePut(fromUartToMatrixHandle, (uint32_t)message, 0) != osOK)
+	{
+		osPoolFree(messageStructHandle, message);
+		rxStatistics.droppedMessages++;
+		return 0;
+	}
+
+	// The new line replaces the broken one, the terminator would end the new line
+	if(flags & UART_MESSAGE_FIRST_CHUNK) parser.isTerminatorPending = 0;
+
+	return 1;
+}
+
+/**
+ * @brief 	This function starts DMA transmission of the request at the head of the queue.
+ * @note	It is called from a thread when the queue was empty and from the DMA transfer complete interrupt.
+ * @retval	None.
+ */
+static void startTransmit(void)
+{
+	UART_txRequestTypeDef *request = &txQueue[txHead];
+
+	USART_transmitDMA(USED_UART, (uint8_t*)request->data, request->size);
+}
+
+/**
+ * @brief 	This function notifies the owner of the transmitted request and starts the next one.
+ * @note	It is called from the DMA interrupts of the TX stream.
+ * @retval	None.
+ */
+static void completeTransmit(void)
+{
+	UART_txRequestTypeDef *request = &txQueue[txHead];
+
+	if(request->signal != 0) osSignalSet(request->thread, request->signal);
+
+	// Chain the next request, unless the queue is paused after this one
+	txHead = (txHead + 1U) % TX_QUEUE_SIZE;
+	txCount--;
+	if(isTxPaused && (txBeforePause != 0)) txBeforePause--;
+
+	if((txCount != 0) && (!isTxPaused || (txBeforePause != 0)))
+	{
+		startTransmit();
 	} else
 	{
-		if(position > 2)
-		{
-			sizeString = (sizeSourceBuffer - oldPosition) + (position);
-		} else
-		{
-			sizeString = (sizeSourceBuffer - oldPosition);
-		}
-		string = (uint8_t*)pvPortMalloc(((sizeString + 1) * sizeof(uint8_t)));
-		memcpy(string, &sourceBuffer[oldPosition], sizeSourceBuffer - oldPosition);
-		memcpy(&string[sizeSourceBuffer - oldPosition], sourceBuffer, sizeString - (sizeSourceBuffer - oldPosition) - 1);
+		isTxActive = 0;
 	}
 
-	oldPosition = position;
+	osSemaphoreRelease(txSlotsHandle);
+}
+
+/**
+ * @brief 	This function sends the requests which are in the transmit queue and changes the baud rate.
+ * @note	The requests which come meanwhile wait in the queue and are sent at the new baud rate. The queue is
+ * 			drained in the time its bytes take at the old baud rate, it takes longer only if the host holds CTS.
+ * @param 	baudrate - The new baud rate.
+ * @retval	1 if the baud rate is changed, 0 if the old one is kept.
+ */
+static uint8_t switchBaudRate(uint32_t baudrate)
+{
+	USH_peripheryStatus status = STATUS_TIMEOUT;
+	uint32_t sizeQueue = 0;
+	uint32_t timeout = 0;
+	uint32_t startTicks = 0;
+	uint8_t isIdle = 0;
+
+	taskENTER_CRITICAL();
+
+	isTxPaused = 1;
+	txBeforePause = txCount;
+
+	for(uint8_t request = 0; request < txCount; request++)
+	{
+		sizeQueue += txQueue[(txHead + request) % TX_QUEUE_SIZE].size;
+	}
+
+	taskEXIT_CRITICAL();
+
+	// 10 bits per symbol, the last two symbols are still in the data and shift registers after the DMA is done
+	timeout = ((sizeQueue + 2U) * 10000U) / uart_structure.BaudRate + 2U;
+	startTicks = osKernelSysTick();
+
+	while(isTxActive && ((osKernelSysTick() - startTicks) < timeout))
+	{
+		osDelay(1);
+	}
+
+	if(!isTxActive)
+	{
+		osDelay((20000U / uart_structure.BaudRate) + 1U);
+
+		status = USART_setBaudRate(USED_UART, baudrate);
+		if(status == STATUS_OK) uart_structure.BaudRate = baudrate;
+	}
+
+	// Start the requests which have been waiting
+	taskENTER_CRITICAL();
+	isTxPaused = 0;
+	isIdle = !isTxActive && (txCount != 0);
+	if(isIdle) isTxActive = 1;
+	taskEXIT_CRITICAL();
+
+	if(isIdle) startTransmit();
+
+	return (status == STATUS_OK) ? 1U : 0U;
+}
+
+/**
+ * @brief 	This function fills the message structure with the default string.
+ * @param 	message - A pointer to the message structure to be filled.
+ * @retval	None.
+ */
+static void setDefaultMessage(UART_messageTypeDef *message)
+{
+	message->buffer			= defaultString;
+	message->sizeBuffer		= sizeof(defaultString) - 1;	// - '\0'
+	message->offset			= 0;
+	message->sizeMessage	= sizeof(defaultString) - 1;
+	message->sizeWrap		= 0;
+	message->flags			= UART_MESSAGE_WHOLE;
+	message->mark			= 0;
+
+#ifdef PROFILE
+	PROFILE_STAMP(message->latency.received);
+	message->latency.parsed = message->latency.received;
+#endif
+}
+
+/**
+ * @brief 	This function returns the index of the RX buffer which the DMA writes next.
+ * @retval	The index.
+ */
+static uint16_t getRxPosition(void)
+{
+	uint16_t position = RX_BUFFER_SIZE - DMA_getNumberOfData(USART_getDmaStream(USED_UART, USART_MODE_RX));
+
+	return (position == RX_BUFFER_SIZE) ? 0U : position;
+}
+
+#ifdef UART_AUTOBAUD
+/**
+ * @brief 	This function looks for the baud rate at which the sync byte is received without errors.
+ * @note	The candidates are tried in turn till the host is heard.
+ * @retval	None.
+ */
+static void detectBaudRate(void)
+{
+	uint8_t symbol = 0;
+	uint32_t startTicks = 0;
+
+	for(uint8_t index = 0; ; index = (index + 1U) % (sizeof(autobaudRates) / sizeof(autobaudRates[0])))
+	{
+		if(autobaudRates[index] > USART_getMaxBaudRate(USED_UART)) continue;
 
-	if(oldPosition == (RX_BUFFER_SIZE - 1)) oldPosition = 0;
+		USART_setBaudRate(USED_UART, autobaudRates[index]);
+		startTicks = osKernelSysTick();
 
-	return string;
+		while((osKernelSysTick() - startTicks) < AUTOBAUD_WINDOW)
+		{
+			if(USART_readByte(USED_UART, &symbol) && (symbol == AUTOBAUD_SYNC_BYTE))
+			{
+				uart_structure.BaudRate = autobaudRates[index];
+				return;
+			}
+
+			osDelay(1);
+		}
+	}
 }
+#endif
 
 /**
  * @brief 	This function initializes U(S)ART module.
@@ -174,6 +616,9 @@ static void UART_init(void)
 	uart_structure.PinsPack 	= USED_PINSPACK;
 	uart_structure.BaudRate 	= USED_BAUDRATE;
 	uart_structure.Mode 		= USART_MODE_RX_TX;
+	uart_structure.OverSampling	= USART_OVERSAMPLING_16;
+	uart_structure.HardwareFlowControl = USED_FLOW_CONTROL;
+	uart_structure.ErrorInterrupt	= USART_ERROR_INTERRUPT_ENABLE;
 	USART_init(&uart_structure);
 }
 
@@ -195,12 +640,12 @@ void UART_freeRtosInit(void)
 
 	// Create the queue(s)
 	// definition and creating of fromUartToMatrixHandle
-	osMessageQDef(fromUartToMatrix, 1, UART_messageTypeDef);
+	osMessageQDef(fromUartToMatrix, UART_MESSAGE_QUEUE_SIZE, UART_messageTypeDef);
 	fromUartToMatrixHandle = osMessageCreate(osMessageQ(fromUartToMatrix), NULL);
 
 	// Create the memory pool(s)
 	// definition and creating of messageStructHandle
-	osPoolDef(messagePool, 1, UART_messageTypeDef);
+	osPoolDef(messagePool, UART_MESSAGE_POOL_SIZE, UART_messageTypeDef);
 	messageStructHandle = osPoolCreate(osPool(messagePool));
 
 	// Create the semaphore(s)
@@ -208,6 +653,10 @@ void UART_freeRtosInit(void)
 	osSemaphoreDef(idleIRQ);
 	idleIRQHandle = osSemaphoreCreate(osSemaphore(idleIRQ), 1);
 
+	// definition and creating of txSlotsHandle
+	osSemaphoreDef(txSlots);
+	txSlotsHandle = osSemaphoreCreate(osSemaphore(txSlots), TX_QUEUE_SIZE);
+
 #ifdef DEBUG
 	vQueueAddToRegistry(fromUartToMatrixHandle, "from uart");
 	vQueueAddToRegistry(idleIRQHandle, "IDLE IRQ");
@@ -219,12 +668,152 @@ void UART_freeRtosInit(void)
 //---------------------------------------------------------------------------
 
 /**
- * @brief 	This function returns a pointer to the default string.
- * @retval	A pointer to the default string.
+ * @brief 	This function puts the message into the queue to the display.
+ * @note	The text has to stay unchanged till the message is rendered.
+ * @param 	text - A pointer to the text of the message.
+ * @param 	size - The size of the text.
+ * @param 	flags - The part of the line and its encoding. This parameter can be a combination of @ref UART_messageFlags.
+ * @retval	1 if the message is queued, 0 if the queue is full and the message is dropped.
+ */
+uint8_t UART_putMessage(const uint8_t *text, uint16_t size, uint8_t flags)
+{
+	return sendMessage(text, size, 0, size, flags);
+}
+
+/**
+ * @brief 	This function returns the number of messages which the display can take without dropping.
+ * @note	The credits are advertised to the host through the protocol. A host which sends no more messages
+ * 			than it has credits never loses one.
+ * @retval	The number of free slots in the queue to the display.
+ */
+uint8_t UART_getCredits(void)
+{
+	return (uint8_t)osMessageAvailableSpace(fromUartToMatrixHandle);
+}
+
+/**
+ * @brief 	This function puts the data into the transmit queue and returns at once.
+ * @note	The next request is started from the DMA transfer complete interrupt. The caller is blocked only
+ * 			when TX_QUEUE_SIZE requests are already waiting. The requests made before the U(S)ART is initialized
+ * 			are started after the initialization.
+ * @param 	data - A pointer to the data. It has to stay unchanged till the transmission is over.
+ * @param 	size - The size of the data.
+ * @param 	signal - The signal which is set to the calling thread when the data is transmitted, 0 - no notification.
+ * 					 The thread can wait for it with osSignalWait.
+ * @retval	None.
+ */
+void UART_transmit(const uint8_t *data, uint16_t size, int32_t signal)
+{
+	UART_txRequestTypeDef *request;
+	uint8_t isIdle = 0;
+
+	if(size == 0) return;
+
+	osSemaphoreWait(txSlotsHandle, osWaitForever);
+
+	taskENTER_CRITICAL();
+
+	request = &txQueue[(txHead + txCount) % TX_QUEUE_SIZE];
+	request->data	= data;
+	request->size	= size;
+	request->thread	= osThreadGetId();
+	request->signal	= signal;
+
+	txCount++;
+	isIdle = !isTxActive && isTxReady && !isTxPaused;
+	if(isIdle) isTxActive = 1;
+
+	taskEXIT_CRITICAL();
+
+	if(isIdle) startTransmit();
+}
+
+/**
+ * @brief 	This function requests the new baud rate. It is set as soon as the received data is processed.
+ * @param 	baudrate - The new baud rate.
+ * @retval	1 if the baud rate can be reached, otherwise 0.
+ */
+uint8_t UART_requestBaudRate(uint32_t baudrate)
+{
+	if((baudrate < MIN_BAUDRATE) || (baudrate > USART_getMaxBaudRate(USED_UART))) return 0;
+
+	requestedBaudRate = baudrate;
+
+	return 1;
+}
+
+/**
+ * @brief 	This function returns the statistics of the receive path.
+ * @retval	A pointer to the statistics structure.
  */
-uint8_t* getPointerDefaultString(void)
+const UART_rxStatisticsTypeDef* UART_getRxStatistics(void)
 {
-	return (uint8_t*)defaultString;
+	return &rxStatistics;
+}
+
+/**
+ * @brief 	This function returns the error counters of the U(S)ART line.
+ * @note	Framing and noise errors point to the line (wiring, baud rate), overruns to the throughput.
+ * @retval	A pointer to the error counters.
+ */
+const USH_USART_errorsTypeDef* UART_getErrors(void)
+{
+	return USART_getErrors(USED_UART);
+}
+
+/**
+ * @brief 	This function returns a symbol of the message straight from the buffer which contains it.
+ * @param 	message - A pointer to the message structure.
+ * @param 	index - The index of the symbol in the message.
+ * @retval	The symbol.
+ */
+uint8_t UART_getSymbol(const UART_messageTypeDef *message, uint16_t index)
+{
+	uint16_t sizeFirstPart = message->sizeMessage - message->sizeWrap;
+
+	if(index < sizeFirstPart)
+	{
+		return message->buffer[message->offset + index];
+	}
+
+	return message->buffer[index - sizeFirstPart];
+}
+
+/**
+ * @brief 	This function checks that the new data hasn't overwritten the message in the RX buffer.
+ * @note	It's called after the message is copied, so the copy is valid if the message is still intact.
+ * 			The overwritten message is counted, its copy has to be dropped. The messages which don't lie in
+ * 			the RX buffer (see UART_putMessage) are always intact.
+ * @param 	message - A pointer to the message structure.
+ * @retval	1 if the message is intact, 0 if it's overwritten.
+ */
+uint8_t UART_checkMessage(const UART_messageTypeDef *message)
+{
+	uint32_t written = rxWritten;
+
+	if(message->buffer != rxBuffer) return 1;
+
+	// The symbols which have come since the last capture
+	written += ((uint32_t)getRxPosition() - written) % RX_BUFFER_SIZE;
+
+	// The first symbol is overwritten when the DMA is a lap ahead of it
+	if((written - message->mark) <= RX_BUFFER_SIZE) return 1;
+
+	rxStatistics.overwrittenMessages++;
+
+	return 0;
+}
+
+/**
+ * @brief 	This function releases the message when it's rendered.
+ * @note	The message has to be rendered right after it is received from the queue, because the region
+ * 			of the circular RX buffer is written again as the new data comes.
+ * @param 	message - A pointer to the message structure.
+ * @retval	None.
+ */
+void UART_releaseMessage(UART_messageTypeDef *message)
+{
+	osPoolFree(messageStructHandle, message);
 }
 
 //---------------------------------------------------------------------------
@@ -238,5 +827,85 @@ uint8_t* getPointerDefaultString(void)
  */
 void USART_idleCallback(USART_TypeDef* usart)
 {
-	if(usart == USED_UART) osSemaphoreRelease(idleIRQHandle);
+	if(usart != USED_UART) return;
+
+	PROFILE_STAMP(rxEventStamp);
+	osSemaphoreRelease(idleIRQHandle);
+}
+
+/**
+ * @brief  Error callbacks. After the overrun the parser is resynchronized at the current DMA position.
+ * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @param  errors - The error flags of SR register.
+ * @retval None.
+ */
+void USART_errorCallback(USART_TypeDef* usart, uint32_t errors)
+{
+	uint16_t position = 0;
+
+	if((usart != USED_UART) || !(errors & USART_SR_ORE)) return;
+
+	position = getRxPosition();
+
+	resyncPosition = position;
+	isResyncPending = 1;
+
+	LOG_WARNING("UART overrun at %u", position);
+
+	osSemaphoreRelease(idleIRQHandle);
+}
+
+/**
+ * @brief  RX half transfer complete callback. The RX buffer is scanned every time half of it is filled.
+ * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval None.
+ */
+void USART_rxHalfCompleteCallback(USART_TypeDef* usart)
+{
+	if(usart != USED_UART) return;
+
+	PROFILE_STAMP(rxEventStamp);
+	osSemaphoreRelease(idleIRQHandle);
+}
+
+/**
+ * @brief  RX transfer complete callback. The RX buffer is scanned every time the DMA wraps around.
+ * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval None.
+ */
+void USART_rxCompleteCallback(USART_TypeDef* usart)
+{
+	if(usart != USED_UART) return;
+
+	PROFILE_STAMP(rxEventStamp);
+	osSemaphoreRelease(idleIRQHandle);
+}
+
+/**
+ * @brief  TX transfer complete callback. The owner of the request is notified and the next request is started.
+ * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval None.
+ */
+void USART_txCompleteCallback(USART_TypeDef* usart)
+{
+	if(usart == USED_UART) completeTransmit();
+}
+
+/**
+ * @brief  TX transfer error callback. The failed TX request is completed as well, so the queue doesn't stall.
+ * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval None.
+ */
+void USART_txErrorCallback(USART_TypeDef* usart)
+{
+	if(usart == USED_UART) completeTransmit();
+}
+
+/**
+ * @brief  Boot complete callback.
+ * @retval None.
+ */
+void BOOT_completeCallback(void)
+{
+	osSignalSet(idleIRQTaskHandle, SIGNAL_BOOT_COMPLETE);
 }
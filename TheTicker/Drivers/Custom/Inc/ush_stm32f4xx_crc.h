@@ -0,0 +1,59 @@
+/**
+  ******************************************************************************
+  * @file    ush_stm32f4xx_crc.h
+  * @author  Ulad Shumeika
+  * @version v1.0
+  * @date    18-October-2026
+  * @brief   Header file of CRC module.
+  *
+  * NOTE: This file is not a full-fledged CRC driver, but contains only some of
+  * 	  the functions that are needed for the current project.
+  ******************************************************************************
+  */
+
+/* The CRC unit calculates CRC-32/MPEG-2 (polynomial 0x04C11DB7, initial value 0xFFFFFFFF,
+ * no reflection, no final XOR). The unit only takes 32-bit words, so a byte buffer is fed
+ * in big-endian words and the tail bytes are calculated by software from the unit's result.
+ */
+
+//---------------------------------------------------------------------------
+// Define to prevent recursive inclusion
+//---------------------------------------------------------------------------
+#ifndef __USH_STM32F4XX_CRC_H
+#define __USH_STM32F4XX_CRC_H
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "stm32f4xx.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define CRC_POLYNOMIAL		((uint32_t)0x04C11DB7)
+#define CRC_SIZE			(4U)		// bytes
+
+//---------------------------------------------------------------------------
+// Test macros
+//---------------------------------------------------------------------------
+#define IS_CRC_DATA_SIZE(SIZE)			(((SIZE) != 0x00U))
+
+//---------------------------------------------------------------------------
+// External function prototypes
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function enables the clock of the CRC unit and resets it.
+ * @retval	None.
+ */
+void CRC_init(void);
+
+/**
+ * @brief 	This function calculates CRC-32/MPEG-2 of the byte buffer.
+ * @param 	data - A pointer to the data.
+ * @param 	size - The data size in bytes.
+ * @retval	The CRC value.
+ */
+uint32_t CRC_calculate(const uint8_t *data, uint32_t size);
+
+#endif /* __USH_STM32F4XX_CRC_H */
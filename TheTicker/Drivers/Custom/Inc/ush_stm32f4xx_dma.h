@@ -104,9 +104,9 @@ typedef enum
 typedef enum
 {
 	DMA_PRIORITY_LOW		= 0x0000UL,		/* Priority level: Low */
-	DMA_PRIORITY_MEDIUM		= 0x4000UL,		/* Priority level: Medium */
-	DMA_PRIORITY_HIGH		= 0x8000UL,		/* Priority level: High */
-	DMA_PRIORITY_VERY_HIGH	= 0x30000UL		/* Priority level: Low */
+	DMA_PRIORITY_MEDIUM		= 0x10000UL,	/* Priority level: Medium */
+	DMA_PRIORITY_HIGH		= 0x20000UL,	/* Priority level: High */
+	DMA_PRIORITY_VERY_HIGH	= 0x30000UL		/* Priority level: Very high */
 } USH_DMA_priority;
 
 /**
@@ -213,6 +213,23 @@ typedef enum
 	DMA_FLAG_ALL		= 0x3DU		/* All flags */
 } USH_DMA_flags;
 
+/**
+ * @brief DMA stream callback. The context is the pointer which was given when the stream was claimed.
+ */
+typedef void (*USH_DMA_callback)(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+
+/**
+ * @brief DMA stream callbacks structure definition. The callbacks which aren't needed are NULL.
+ */
+typedef struct
+{
+	USH_DMA_callback transferComplete;		/* Transfer complete callback */
+	USH_DMA_callback halfTransferComplete;	/* Half transfer complete callback */
+	USH_DMA_callback transferError;			/* Transfer error callback */
+	USH_DMA_callback directModeError;		/* Direct mode error callback */
+	USH_DMA_callback fifoError;				/* FIFO error callback */
+} USH_DMA_callbacksTypeDef;
+
 //---------------------------------------------------------------------------
 // Macros
 //---------------------------------------------------------------------------
@@ -338,12 +355,69 @@ uint32_t DMA_getFlags(USH_DMA_initTypeDef *initStructure);
  */
 uint16_t DMA_getNumberOfData(DMA_Stream_TypeDef *DMAy_Streamx);
 
+/**
+ * @brief 	This function starts the stream which is configured in double buffer mode.
+ * @note	The stream fills (or drains) memory 0 first, then switches to memory 1 and back. Both buffers have
+ * 			the same number of data items. The transfer complete interrupt comes at every switch.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	periphAddress - The address of the peripheral data register.
+ * @param 	memory0 - The address of the first buffer.
+ * @param 	memory1 - The address of the second buffer.
+ * @param 	items - The number of data items in every buffer.
+ * @retval	None.
+ */
+void DMA_startDoubleBuffer(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t periphAddress, uint32_t memory0, uint32_t memory1, uint16_t items);
+
+/**
+ * @brief 	This function returns the buffer which the stream in double buffer mode is working with.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @retval	0 - memory 0, 1 - memory 1.
+ */
+uint8_t DMA_getCurrentTarget(DMA_Stream_TypeDef *DMAy_Streamx);
+
+/**
+ * @brief 	This function replaces the buffer which the stream in double buffer mode isn't working with.
+ * @note	The address of the current target can't be written while the stream is enabled, the hardware disables
+ * 			the stream with the transfer error. The switch can't be undone, so it's prevented: the buffer isn't
+ * 			replaced if fewer than guard items are left in the current one, and the interrupts are disabled from
+ * 			the check till the write, so only a few bus cycles pass in between. The guard has to cover them,
+ * 			2 items are enough for any peripheral. Call it from the transfer complete callback, then the whole
+ * 			buffer time is left for the replacement.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	memory - The address of the new buffer.
+ * @param 	guard - The number of data items which have to be left in the current buffer, at least 1.
+ * @retval	STATUS_OK - the buffer is replaced, STATUS_BUSY - try again after the next switch.
+ */
+USH_peripheryStatus DMA_setIdleBuffer(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t memory, uint16_t guard);
+
+/**
+ * @brief 	This function claims the DMA stream and registers its callbacks.
+ * @note	The stream belongs to the driver which claimed it first, until the driver releases it. The same driver
+ * 			can claim its stream again (the same callbacks and context), another driver gets STATUS_BUSY.
+ * 			The callbacks structure has to exist while the stream is claimed.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	callbacks - A pointer to the callbacks of the stream.
+ * @param 	context - The pointer which is passed to the callbacks, usually the state of the driver instance.
+ * @retval	The periphery status.
+ */
+USH_peripheryStatus DMA_claimStream(DMA_Stream_TypeDef *DMAy_Streamx, const USH_DMA_callbacksTypeDef *callbacks, void *context);
+
+/**
+ * @brief 	This function disables the DMA stream and releases it, so another driver can claim it.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	context - The context which the stream was claimed with. The streams of other drivers aren't released.
+ * @retval	None.
+ */
+void DMA_releaseStream(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+
 /**
  * @brief 	This function handles DMA interrupt request.
+ * @note	The callbacks are taken from the registry by the stream index, so the dispatch doesn't depend on the number
+ * 			of the streams in use. The interrupts of the streams which aren't claimed go to the weak callbacks below.
  * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
  * @retval	None.
  */
-void DMA_IRQHandler(USH_DMA_initTypeDef *initStructure);
+void DMA_IRQHandler(DMA_Stream_TypeDef *DMAy_Streamx);
 
 //---------------------------------------------------------------------------
 // DMA interrupt user callbacks
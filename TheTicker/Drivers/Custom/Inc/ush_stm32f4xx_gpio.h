@@ -99,11 +99,11 @@ typedef enum
 	GPIO_AF7_USART2		= 0x07UL,		/* USART2 alternative function mapping */
 	GPIO_AF7_USART3		= 0x07UL,		/* USART3 alternative function mapping */
 
-	GPIO_AF8_UART4		= 0x07UL,		/* UART4 alternative function mapping */
-	GPIO_AF8_UART5		= 0x07UL,		/* UART5 alternative function mapping */
-	GPIO_AF8_USART6		= 0x07UL,		/* USART6 alternative function mapping */
-	GPIO_AF8_UART7		= 0x07UL,		/* UART7 alternative function mapping */
-	GPIO_AF8_UART8		= 0x07UL		/* UART8 alternative function mapping */
+	GPIO_AF8_UART4		= 0x08UL,		/* UART4 alternative function mapping */
+	GPIO_AF8_UART5		= 0x08UL,		/* UART5 alternative function mapping */
+	GPIO_AF8_USART6		= 0x08UL,		/* USART6 alternative function mapping */
+	GPIO_AF8_UART7		= 0x08UL,		/* UART7 alternative function mapping */
+	GPIO_AF8_UART8		= 0x08UL		/* UART8 alternative function mapping */
 } USH_GPIO_alternate;
 
 /**
@@ -25,6 +25,12 @@
 //---------------------------------------------------------------------------
 #define MIN_PRIORITY	(15U)
 
+/* NOTE: The timebase is TIM5 counting microseconds. It runs free through the whole 32-bit range without any interrupt,
+ * 		 so the times are compared by their difference and wrap every 71 minutes. The timeouts up to 35 minutes
+ * 		 are handled by the deadline functions. The counter stops while the core is halted by the debugger. */
+#define MISC_TIMEBASE_TIMER			(TIM5)
+#define MISC_TIMEBASE_PRESCALER		(90U)		// The timer clock of APB1 is 90 MHz
+
 //---------------------------------------------------------------------------
 // Structures and enumerations
 //---------------------------------------------------------------------------
@@ -110,22 +116,45 @@ typedef enum
 //---------------------------------------------------------------------------
 
 /**
- * @brief 	This function sets up TIM14 timer to check for timeout.
+ * @brief 	This function starts the free-running microsecond timebase.
+ * @note	It has to be called after the system clock is configured.
  * @retval	None.
  */
-void MISC_timeoutTimer(void);
+void MISC_timebaseInit(void);
 
 /**
- * @brief 	This function increments a variable "timeoutTicks".
- * @retval	None.
+ * @brief 	This function returns the current time of the timebase.
+ * @retval	The time in microseconds.
+ */
+uint32_t MISC_timebaseNow(void);
+
+/**
+ * @brief 	This function returns the time which has passed since the moment.
+ * @param 	start - The moment returned by MISC_timebaseNow.
+ * @retval	The time in microseconds.
+ */
+uint32_t MISC_timebaseElapsed(uint32_t start);
+
+/**
+ * @brief 	This function returns the deadline which comes after the timeout from now.
+ * @param 	timeout - The timeout in microseconds, up to 0x7FFFFFFF.
+ * @retval	The deadline for MISC_timebaseIsExpired.
+ */
+uint32_t MISC_timebaseDeadline(uint32_t timeout);
+
+/**
+ * @brief 	This function checks whether the deadline has come.
+ * @param 	deadline - The deadline returned by MISC_timebaseDeadline.
+ * @retval	1 if the deadline has come, otherwise 0.
  */
-void MISC_timeoutTimerIncTick(void);
+uint8_t MISC_timebaseIsExpired(uint32_t deadline);
 
 /**
- * @brief 	This function returns "timeoutTicks" variable value.
+ * @brief 	This function waits for the time without the scheduler.
+ * @param 	delay - The time in microseconds, up to 0x7FFFFFFF.
  * @retval	None.
  */
-uint32_t MISC_timeoutGetTick(void);
+void MISC_timebaseDelay(uint32_t delay);
 
 /**
   * @brief  This function sets the priority grouping field (preemption priority and subpriority)
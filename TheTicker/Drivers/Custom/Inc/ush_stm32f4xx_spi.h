@@ -9,7 +9,7 @@
   ******************************************************************************
   */
   
-/* NOTE: The work with DMA is not implemented */
+/* NOTE: Only TX DMA of dmaPack_1 is implemented */
 
 /* The SPI setting is based on the choice of a set of pins and a set of DMA.
  *
@@ -215,6 +215,26 @@ void SPI_init(USH_SPI_initDefaultTypeDef *initStructure);
  */
 void SPI_writeData(SPI_TypeDef *SPIx, uint8_t reg, uint8_t data);
 
+/**
+ * @brief 	This function transmits a 16-bit word and returns the word received at the same time.
+ * @param 	SPIx - A pointer to SPIx peripheral to be used where x is between 1 to 6.
+ * @param 	data - Data to be transmitted.
+ * @retval	Received data.
+ */
+uint16_t SPI_transmitReceiveData(SPI_TypeDef *SPIx, uint16_t data);
+
+/**
+ * @brief 	This function starts transmitting the 16-bit words through DMA.
+ * @note	The received words are dropped. SPI_txCompleteCallback is called when the last word has left the shift
+ * 			register, so the CS pin can be raised from it. Memory is read by words through the FIFO when the data
+ * 			is aligned, by bursts of 4 words when it is aligned to 16 bytes.
+ * @param 	SPIx - A pointer to SPIx peripheral to be used where x is between 1 to 6.
+ * @param 	data - A pointer to the words. They mustn't be changed until the transfer is over.
+ * @param 	size - The number of words.
+ * @retval	The periphery status. STATUS_BUSY if the TX stream isn't claimed by this SPI.
+ */
+USH_peripheryStatus SPI_transmitDMA(SPI_TypeDef *SPIx, const uint16_t *data, uint16_t size);
+
 /**
   * @brief  Chip select (CS) pin switching.
   * @param	GPIOx - A pointer to GPIOx peripheral to be used where x is between A to F.
@@ -226,4 +246,9 @@ void SPI_writeData(SPI_TypeDef *SPIx, uint8_t reg, uint8_t data);
   */
 void SPI_csPin(GPIO_TypeDef *GPIOx, uint16_t csPin, USH_SPI_csState state);
 
+//---------------------------------------------------------------------------
+// DMA interrupt user callbacks
+//---------------------------------------------------------------------------
+__WEAK void SPI_txCompleteCallback(SPI_TypeDef *SPIx);
+
 #endif /* __USH_STM32F4XX_SPI_H */
@@ -27,6 +27,14 @@
  * UART7	  |	 PE8   |  PE7   |  PF7	 |  PF6   |
  * UART8	  |  PE1   |  PE0   |  ---   |  ---   |
  *
+ * The hardware flow control pins (the same for both pinsPacks, UART4/5/7/8 have no flow control).
+ * U(S)ARTx___|___CTS__|___RTS__|
+ * 		      |		   |		|
+ * USART1	  |  PA11  |  PA12  |
+ * USART2	  |	 PA0   |  PA1	|
+ * USART3	  |	 PB13  |  PB14	|
+ * USART6	  |	 PG15  |  PG8	|
+ *
  * DMA streams and channels.
  *     	      |		            	    |
  * U(S)ARTx___|_DMAx Stream x Channel x_|
@@ -55,6 +63,9 @@
  * UART8_TX   | 	 DMA1 St.0 Ch.5     |
  * UART8_RX   | 	 DMA1 St.6 Ch.5     |
  *
+ * Some DMA1 streams are shared (USART3 and UART7, USART2/UART5 and UART8),
+ * so the U(S)ARTs which share a stream can't be used at the same time. USART_init claims the streams
+ * in the DMA registry, the init of the second U(S)ART fails on the assert.
  */
 
 //---------------------------------------------------------------------------
@@ -91,6 +102,35 @@ typedef enum
 	USART_MODE_RX_TX 	= 0x0CU		/* RX and TX selected */
 } USH_USART_mode;
 
+/**
+ * @brief USART oversampling enumeration
+ */
+typedef enum
+{
+	USART_OVERSAMPLING_16	= 0x00U,			/* Oversampling by 16, better noise tolerance */
+	USART_OVERSAMPLING_8	= USART_CR1_OVER8	/* Oversampling by 8, twice the maximum baud rate */
+} USH_USART_overSampling;
+
+/**
+ * @brief USART hardware flow control enumeration
+ */
+typedef enum
+{
+	USART_HW_FLOW_CONTROL_NONE		= 0x00U,							/* Hardware flow control disabled */
+	USART_HW_FLOW_CONTROL_RTS		= USART_CR3_RTSE,					/* RTS is deasserted when the receiver can't take more data */
+	USART_HW_FLOW_CONTROL_CTS		= USART_CR3_CTSE,					/* The transmitter waits for CTS */
+	USART_HW_FLOW_CONTROL_RTS_CTS	= (USART_CR3_RTSE | USART_CR3_CTSE)	/* RTS and CTS are enabled */
+} USH_USART_hardwareFlowControl;
+
+/**
+ * @brief USART error interrupt enumeration
+ */
+typedef enum
+{
+	USART_ERROR_INTERRUPT_DISABLE	= 0x00U,			/* The errors are counted only when another U(S)ART interrupt comes */
+	USART_ERROR_INTERRUPT_ENABLE	= USART_CR3_EIE		/* Framing, noise and overrun errors raise the interrupt in DMA RX mode */
+} USH_USART_errorInterrupt;
+
 /**
   * @brief UART initialization structure definition
   */
@@ -109,8 +149,30 @@ typedef struct
 
 	USH_USART_mode Mode;			/* U(S)ART modes selection. This parameter can be a value of @ref USH_USART_mode */
 
+	USH_USART_overSampling OverSampling;	/* U(S)ART oversampling selection. The baud rate can't be higher than PCLKx / 16
+											   for USART_OVERSAMPLING_16 and PCLKx / 8 for USART_OVERSAMPLING_8.
+											   This parameter can be a value of @ref USH_USART_overSampling */
+
+	USH_USART_hardwareFlowControl HardwareFlowControl;	/* U(S)ART hardware flow control selection. Only USART1/2/3/6 have
+														   CTS and RTS pins, see the table above. This parameter can be
+														   a value of @ref USH_USART_hardwareFlowControl */
+
+	USH_USART_errorInterrupt ErrorInterrupt;	/* U(S)ART error interrupt selection.
+												   This parameter can be a value of @ref USH_USART_errorInterrupt */
+
 } USH_USART_initTypeDef;
 
+/**
+  * @brief U(S)ART error counters structure definition
+  */
+typedef struct
+{
+	uint32_t parity;				/* The number of parity errors */
+	uint32_t framing;				/* The number of framing errors, usually a wrong baud rate or a break on the line */
+	uint32_t noise;					/* The number of symbols received with noise */
+	uint32_t overrun;				/* The number of overruns, the symbols weren't read out in time and some were lost */
+} USH_USART_errorsTypeDef;
+
 /**
  * @brief U(S)ART flags enumeration
  */
@@ -154,7 +216,19 @@ typedef enum
 #define IS_USART_PINSPACK(PINSPACK)			(((PINSPACK) == USART_PINSPACK_1) || \
 											 ((PINSPACK) == USART_PINSPACK_2))
 
-#define IS_USART_BAUDRATE(BAUDRATE)			(((BAUDRATE) <= 10500000U))
+#define IS_USART_OVERSAMPLING(SAMPLING)		(((SAMPLING) == USART_OVERSAMPLING_16) || \
+											 ((SAMPLING) == USART_OVERSAMPLING_8))
+
+#define IS_USART_HW_FLOW_CONTROL(CONTROL)	(((CONTROL) == USART_HW_FLOW_CONTROL_NONE) || \
+											 ((CONTROL) == USART_HW_FLOW_CONTROL_RTS)  || \
+											 ((CONTROL) == USART_HW_FLOW_CONTROL_CTS)  || \
+											 ((CONTROL) == USART_HW_FLOW_CONTROL_RTS_CTS))
+
+#define IS_USART_ERROR_INTERRUPT(STATE)		(((STATE) == USART_ERROR_INTERRUPT_DISABLE) || \
+											 ((STATE) == USART_ERROR_INTERRUPT_ENABLE))
+
+#define IS_USART_BAUDRATE_FOR_CLOCK(PCLK, SAMPLING, BAUDRATE)	(((BAUDRATE) != 0U) && \
+																 ((BAUDRATE) <= ((PCLK) / (((SAMPLING) == USART_OVERSAMPLING_8) ? 8U : 16U))))
 
 #define IS_USART_MODE(MODE)					(((MODE) == USART_MODE_RX) || \
 											 ((MODE) == USART_MODE_TX) || \
@@ -184,15 +258,39 @@ typedef enum
  *			- Asynchronous mode;
  *			- Word Length - 8 bits;
  *			- Parity - None;
- *			- Stop bits - 1;
- *			- Hardware flow control - None;
- *			- Over sampling - 16 samples.
+ *			- Stop bits - 1.
  * @param 	initStructure - A pointer to a USH_USART_initTypeDef structure that contains the configuration information
  * 							for the specified U(S)ART peripheral.
  * @retval	None.
  */
 void USART_init(USH_USART_initTypeDef *initStructure);
 
+/**
+ * @brief 	This function changes the baud rate of the working U(S)ART. The transmission in progress is completed first.
+ * @note	Oversampling by 16 is used when it can reach the baud rate, otherwise oversampling by 8 is used.
+ * 			The DMA streams stay configured, so the reception continues at the new baud rate.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @param 	baudrate - The new baud rate. It can't be higher than PCLKx / 8.
+ * @retval	The periphery status.
+ */
+USH_peripheryStatus USART_setBaudRate(USART_TypeDef* usart, uint32_t baudrate);
+
+/**
+ * @brief 	This function returns the highest baud rate which the U(S)ART can reach with oversampling by 8.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval	The baud rate.
+ */
+uint32_t USART_getMaxBaudRate(USART_TypeDef* usart);
+
+/**
+ * @brief 	This function reads the received byte without DMA.
+ * @note	A byte with a framing, noise or parity error is read out and discarded.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @param 	data - A pointer to the variable for the byte.
+ * @retval	1 if a valid byte is read, otherwise 0.
+ */
+uint8_t USART_readByte(USART_TypeDef* usart, uint8_t *data);
+
 /**
  * @brief	This function receives an amount of data in DMA mode till either the expected number of data is received or an IDLE event occurs.
  * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
@@ -204,6 +302,8 @@ USH_peripheryStatus USART_receiveToIdleDMA(USART_TypeDef* usart, uint8_t* data,
 
 /**
  * @brief	This function transmits data using DMA.
+ * @note	The function doesn't wait for the previous data to leave the shift register, only for the DMA stream
+ * 			to be free. So it can be called from the DMA transfer complete interrupt to chain the next transfer.
  * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
  * @param 	data - The data to be transmitted.
  * @param 	size - The data transfer size.
@@ -228,6 +328,13 @@ void USART_clearFlags(USART_TypeDef* usart, USH_USART_flags flags);
  */
 DMA_Stream_TypeDef* USART_getDmaStream(USART_TypeDef* usart, USH_USART_mode mode);
 
+/**
+ * @brief 	This function returns the error counters of the U(S)ART.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval	A pointer to the error counters, NULL if the U(S)ART isn't supported.
+ */
+const USH_USART_errorsTypeDef* USART_getErrors(USART_TypeDef* usart);
+
 /**
  * @brief 	This function handles U(S)ART interrupt request.
  * @param 	initStructure - A pointer to a USH_USART_initTypeDef structure that contains the configuration information
@@ -236,9 +343,22 @@ DMA_Stream_TypeDef* USART_getDmaStream(USART_TypeDef* usart, USH_USART_mode mode
  */
 void USART_IRQHandler(USH_USART_initTypeDef *initStructure);
 
+/**
+ * @brief 	This function routes the U(S)ART global interrupt to the init structure of the instance.
+ * @note	It is called from the U(S)ART interrupt handlers in stm32f4xx_it.c.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval	None.
+ */
+void USART_instanceIRQHandler(USART_TypeDef* usart);
+
 //---------------------------------------------------------------------------
 // DMA interrupt user callbacks
 //---------------------------------------------------------------------------
 __WEAK void USART_idleCallback(USART_TypeDef* usart);
+__WEAK void USART_errorCallback(USART_TypeDef* usart, uint32_t errors);
+__WEAK void USART_txCompleteCallback(USART_TypeDef* usart);
+__WEAK void USART_txErrorCallback(USART_TypeDef* usart);
+__WEAK void USART_rxHalfCompleteCallback(USART_TypeDef* usart);
+__WEAK void USART_rxCompleteCallback(USART_TypeDef* usart);
 
 #endif /* __USH_STM32F4XX_USART_H */
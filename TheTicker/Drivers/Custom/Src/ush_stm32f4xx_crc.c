@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * @file    ush_stm32f4xx_crc.c
+  * @author  Ulad Shumeika
+  * @version v1.0
+  * @date    18-October-2026
+  * @brief	 This file contains the implementation of functions for working with CRC unit.
+  *
+  * NOTE: This file is not a full-fledged CRC driver, but contains only some of
+  * 	  the functions that are needed for the current project.
+  ******************************************************************************
+  */
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "ush_stm32f4xx_crc.h"
+
+//---------------------------------------------------------------------------
+// Initialization functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function enables the clock of the CRC unit and resets it.
+ * @retval	None.
+ */
+void CRC_init(void)
+{
+	// Enable CRC clock
+	RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+
+	// Reset the data register to 0xFFFFFFFF
+	CRC->CR = CRC_CR_RESET;
+}
+
+//---------------------------------------------------------------------------
+// Library Functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function calculates CRC-32/MPEG-2 of the byte buffer.
+ * @note	The full words are calculated by the CRC unit, the rest 1-3 bytes are calculated by software.
+ * @param 	data - A pointer to the data.
+ * @param 	size - The data size in bytes.
+ * @retval	The CRC value.
+ */
+uint32_t CRC_calculate(const uint8_t *data, uint32_t size)
+{
+	uint32_t crc = 0;
+	uint32_t index = 0;
+
+	// Check parameters
+	assert_param(IS_CRC_DATA_SIZE(size));
+
+	CRC->CR = CRC_CR_RESET;
+
+	for(; (index + CRC_SIZE) <= size; index += CRC_SIZE)
+	{
+		CRC->DR = ((uint32_t)data[index] << 24U) | ((uint32_t)data[index + 1] << 16U) |
+				  ((uint32_t)data[index + 2] << 8U) | (uint32_t)data[index + 3];
+	}
+
+	crc = CRC->DR;
+
+	for(; index < size; index++)
+	{
+		crc ^= (uint32_t)data[index] << 24U;
+
+		for(uint8_t bit = 0; bit < 8U; bit++)
+		{
+			crc = (crc & 0x80000000U) ? ((crc << 1U) ^ CRC_POLYNOMIAL) : (crc << 1U);
+		}
+	}
+
+	return crc;
+}
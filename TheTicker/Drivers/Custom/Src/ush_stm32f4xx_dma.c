@@ -15,12 +15,51 @@
 // Includes
 //---------------------------------------------------------------------------
 #include "ush_stm32f4xx_dma.h"
+#include <stddef.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define DMA_STREAM_COUNT		(16U)		// 8 streams of DMA1 and 8 streams of DMA2
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief DMA stream registry entry structure
+ */
+typedef struct
+{
+	const USH_DMA_callbacksTypeDef *callbacks;	/* The callbacks of the owner, NULL - the stream isn't claimed */
+	void *context;								/* The context of the owner */
+} DMA_streamEntryTypeDef;
+
+//---------------------------------------------------------------------------
+// Static function prototypes
+//---------------------------------------------------------------------------
+static uint8_t DMA_getIndex(DMA_Stream_TypeDef *DMAy_Streamx);
+static uint32_t DMA_getStreamFlags(DMA_Stream_TypeDef *DMAy_Streamx);
+static void DMA_defaultTransferComplete(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+static void DMA_defaultHalfTransferComplete(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+static void DMA_defaultTransferError(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+static void DMA_defaultDirectModeError(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+static void DMA_defaultFifoError(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
 
 //---------------------------------------------------------------------------
 // Private variables
 //---------------------------------------------------------------------------
 static const uint8_t flagBitshiftOffset[8U] = {0U, 6U, 16U, 22U, 0U, 6U, 16U, 22U};
 
+static DMA_streamEntryTypeDef streamEntries[DMA_STREAM_COUNT];
+
+// The streams which aren't claimed are routed to the weak callbacks
+static const USH_DMA_callbacksTypeDef defaultCallbacks =
+{
+	DMA_defaultTransferComplete, DMA_defaultHalfTransferComplete, DMA_defaultTransferError,
+	DMA_defaultDirectModeError, DMA_defaultFifoError
+};
+
 //---------------------------------------------------------------------------
 // Initialization functions
 //---------------------------------------------------------------------------
@@ -50,6 +89,9 @@ void DMA_init(USH_DMA_initTypeDef *initStructure)
 	assert_param(IS_DMA_FIFO_MODE(initStructure->FIFOMode));
 	assert_param(IS_DMA_FIFO_THRESHOLD(initStructure->FIFOThreshold));
 
+	// Double buffer mode can't be used for memory-to-memory transfers
+	assert_param((initStructure->Mode != DMA_DOUBLE_BUFFERING) || (initStructure->Direction != DMA_MEMORY_TO_MEMORY));
+
 	DMA_state(initStructure->DMAy_Streamx, DISABLE);
 
 	// Get the CR register value
@@ -63,6 +105,12 @@ void DMA_init(USH_DMA_initTypeDef *initStructure)
 			  initStructure->Direction | initStructure->PeriphDataAlignment	| initStructure->PeriphInc |
 			  initStructure->Mode 	   | initStructure->Priority;
 
+	// The stream switches the buffers in circular mode only
+	if(initStructure->Mode == DMA_DOUBLE_BUFFERING)
+	{
+		tmpReg |= DMA_SxCR_CIRC;
+	}
+
 	// The memory burst and peripheral burst are not used when the FIFO is disabled
 	if(initStructure->FIFOMode == DMA_FIFO_MODE_ENABLE)
 	{
@@ -155,77 +203,289 @@ uint32_t DMA_getFlags(USH_DMA_initTypeDef *initStructure)
 	// Check parameters
 	assert_param(IS_DMA_STREAM_ALL_INSTANCE(initStructure->DMAy_Streamx));
 
-	uint32_t flags = 0;
+	return DMA_getStreamFlags(initStructure->DMAy_Streamx);
+}
 
-	DMA_TypeDef* DMAy;
+/**
+ * @brief 	This function returns number of data items to transfer.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @retval	Number of data items to transfer.
+ */
+uint16_t DMA_getNumberOfData(DMA_Stream_TypeDef *DMAy_Streamx)
+{
+	return (DMAy_Streamx->NDTR);
+}
+
+/**
+ * @brief 	This function starts the stream which is configured in double buffer mode.
+ * @note	The stream fills (or drains) memory 0 first, then switches to memory 1 and back. Both buffers have
+ * 			the same number of data items. The transfer complete interrupt comes at every switch.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	periphAddress - The address of the peripheral data register.
+ * @param 	memory0 - The address of the first buffer.
+ * @param 	memory1 - The address of the second buffer.
+ * @param 	items - The number of data items in every buffer.
+ * @retval	None.
+ */
+void DMA_startDoubleBuffer(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t periphAddress, uint32_t memory0, uint32_t memory1, uint16_t items)
+{
+	// Check parameters
+	assert_param(IS_DMA_STREAM_ALL_INSTANCE(DMAy_Streamx));
+	assert_param(DMAy_Streamx->CR & DMA_SxCR_DBM);
 
-	uint32_t streamNumber = ((uint32_t)initStructure->DMAy_Streamx & 0xFFU) / 0x18U;	// 0xFF is a mask. 0x18 is a step between stream registers.
-																						// For a better understanding of magic numbers. See the reference manual.
-	DMAy = (initStructure->DMAy_Streamx < DMA2_Stream0) ? DMA1 : DMA2;
+	DMA_state(DMAy_Streamx, DISABLE);
+	while(DMAy_Streamx->CR & DMA_SxCR_EN);
 
-	if(streamNumber < 4U)	// Stream 0-3 is LIFCR and stream 4-6 is HIFCR
+	DMAy_Streamx->PAR = periphAddress;
+	DMAy_Streamx->M0AR = memory0;
+	DMAy_Streamx->M1AR = memory1;
+	DMAy_Streamx->NDTR = items;
+
+	// Memory 0 is the first target
+	DMAy_Streamx->CR &= ~DMA_SxCR_CT;
+
+	DMA_clearFlags(DMAy_Streamx, DMA_FLAG_ALL);
+	DMA_state(DMAy_Streamx, ENABLE);
+}
+
+/**
+ * @brief 	This function returns the buffer which the stream in double buffer mode is working with.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @retval	0 - memory 0, 1 - memory 1.
+ */
+uint8_t DMA_getCurrentTarget(DMA_Stream_TypeDef *DMAy_Streamx)
+{
+	return (DMAy_Streamx->CR & DMA_SxCR_CT) ? 1U : 0U;
+}
+
+/**
+ * @brief 	This function replaces the buffer which the stream in double buffer mode isn't working with.
+ * @note	The check of the items left and the write can't be split by an interrupt, so the stream can't reach
+ * 			the switch in between. See the description in the header.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	memory - The address of the new buffer.
+ * @param 	guard - The number of data items which have to be left in the current buffer, at least 1.
+ * @retval	STATUS_OK - the buffer is replaced, STATUS_BUSY - try again after the next switch.
+ */
+USH_peripheryStatus DMA_setIdleBuffer(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t memory, uint16_t guard)
+{
+	// Check parameters
+	assert_param(IS_DMA_STREAM_ALL_INSTANCE(DMAy_Streamx));
+	assert_param(DMAy_Streamx->CR & DMA_SxCR_DBM);
+	assert_param(guard != 0);
+
+	USH_peripheryStatus status = STATUS_OK;
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	if(DMAy_Streamx->NDTR <= guard)
 	{
-		flags = DMAy->LISR >> flagBitshiftOffset[streamNumber];
+		status = STATUS_BUSY;
+	} else if(DMA_getCurrentTarget(DMAy_Streamx) == 0U)
+	{
+		DMAy_Streamx->M1AR = memory;
 	} else
 	{
-		flags = DMAy->HISR >> flagBitshiftOffset[streamNumber];
+		DMAy_Streamx->M0AR = memory;
 	}
 
-	return flags;
+	__set_PRIMASK(primask);
+
+	return status;
 }
 
 /**
- * @brief 	This function returns number of data items to transfer.
+ * @brief 	This function claims the DMA stream and registers its callbacks.
+ * @note	The stream belongs to the driver which claimed it first, until the driver releases it. The same driver
+ * 			can claim its stream again (the same callbacks and context), another driver gets STATUS_BUSY.
+ * 			The callbacks structure has to exist while the stream is claimed.
  * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
- * @retval	Number of data items to transfer.
+ * @param 	callbacks - A pointer to the callbacks of the stream.
+ * @param 	context - The pointer which is passed to the callbacks, usually the state of the driver instance.
+ * @retval	The periphery status.
  */
-uint16_t DMA_getNumberOfData(DMA_Stream_TypeDef *DMAy_Streamx)
+USH_peripheryStatus DMA_claimStream(DMA_Stream_TypeDef *DMAy_Streamx, const USH_DMA_callbacksTypeDef *callbacks, void *context)
 {
-	return (DMAy_Streamx->NDTR);
+	// Check parameters
+	assert_param(IS_DMA_STREAM_ALL_INSTANCE(DMAy_Streamx));
+	assert_param(callbacks != NULL);
+
+	USH_peripheryStatus status = STATUS_OK;
+	DMA_streamEntryTypeDef *entry = &streamEntries[DMA_getIndex(DMAy_Streamx)];
+	uint32_t primask = __get_PRIMASK();
+
+	// The drivers can be initialized from different threads
+	__disable_irq();
+
+	if((entry->callbacks != NULL) && ((entry->callbacks != callbacks) || (entry->context != context)))
+	{
+		status = STATUS_BUSY;
+	} else
+	{
+		entry->callbacks = callbacks;
+		entry->context = context;
+	}
+
+	__set_PRIMASK(primask);
+
+	return status;
+}
+
+/**
+ * @brief 	This function disables the DMA stream and releases it, so another driver can claim it.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	context - The context which the stream was claimed with. The streams of other drivers aren't released.
+ * @retval	None.
+ */
+void DMA_releaseStream(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	// Check parameters
+	assert_param(IS_DMA_STREAM_ALL_INSTANCE(DMAy_Streamx));
+
+	DMA_streamEntryTypeDef *entry = &streamEntries[DMA_getIndex(DMAy_Streamx)];
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	if((entry->callbacks != NULL) && (entry->context == context))
+	{
+		DMA_state(DMAy_Streamx, DISABLE);
+		DMAy_Streamx->CR &= ~(DMA_SxCR_TCIE | DMA_SxCR_HTIE | DMA_SxCR_TEIE | DMA_SxCR_DMEIE);
+		DMA_clearFlags(DMAy_Streamx, DMA_FLAG_ALL);
+
+		entry->callbacks = NULL;
+		entry->context = NULL;
+	}
+
+	__set_PRIMASK(primask);
 }
 
 /**
  * @brief 	This function handles DMA interrupt request.
+ * @note	The callbacks are taken from the registry by the stream index, so the dispatch doesn't depend on the number
+ * 			of the streams in use. The interrupts of the streams which aren't claimed go to the weak callbacks.
  * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
  * @retval	None.
  */
-void DMA_IRQHandler(USH_DMA_initTypeDef *initStructure)
+void DMA_IRQHandler(DMA_Stream_TypeDef *DMAy_Streamx)
 {
+	const DMA_streamEntryTypeDef *entry = &streamEntries[DMA_getIndex(DMAy_Streamx)];
+	const USH_DMA_callbacksTypeDef *callbacks = (entry->callbacks != NULL) ? entry->callbacks : &defaultCallbacks;
+
 	// Get interrupt flags
-	uint32_t flags = DMA_getFlags(initStructure);
+	uint32_t flags = DMA_getStreamFlags(DMAy_Streamx);
 
 	// Clear interrupt flags
-	DMA_clearFlags(initStructure->DMAy_Streamx, DMA_FLAG_ALL);
+	DMA_clearFlags(DMAy_Streamx, DMA_FLAG_ALL);
 
 	// Check transfer complete flag
-	if((flags & DMA_FLAG_TCIF) && (initStructure->DMAy_Streamx->CR & DMA_SxCR_TCIE))
+	if((flags & DMA_FLAG_TCIF) && (DMAy_Streamx->CR & DMA_SxCR_TCIE) && (callbacks->transferComplete != NULL))
 	{
-		DMA_transferCompleteCallback(initStructure->DMAy_Streamx);
+		callbacks->transferComplete(DMAy_Streamx, entry->context);
 	}
 
 	// Check half transfer complete flag
-	if((flags & DMA_FLAG_HTIF) && (initStructure->DMAy_Streamx->CR & DMA_SxCR_HTIE))
+	if((flags & DMA_FLAG_HTIF) && (DMAy_Streamx->CR & DMA_SxCR_HTIE) && (callbacks->halfTransferComplete != NULL))
 	{
-		DMA_halfTransferCompleteCallback(initStructure->DMAy_Streamx);
+		callbacks->halfTransferComplete(DMAy_Streamx, entry->context);
 	}
 
 	// Check transfer error flag
-	if((flags & DMA_FLAG_TEIF) && (initStructure->DMAy_Streamx->CR & DMA_SxCR_TEIE))
+	if((flags & DMA_FLAG_TEIF) && (DMAy_Streamx->CR & DMA_SxCR_TEIE) && (callbacks->transferError != NULL))
 	{
-		DMA_transferErrorCallback(initStructure->DMAy_Streamx);
+		callbacks->transferError(DMAy_Streamx, entry->context);
 	}
 
 	// Check direct mode error flag
-	if((flags & DMA_FLAG_DMEIF) && (initStructure->DMAy_Streamx->CR & DMA_SxCR_DMEIE))
+	if((flags & DMA_FLAG_DMEIF) && (DMAy_Streamx->CR & DMA_SxCR_DMEIE) && (callbacks->directModeError != NULL))
 	{
-		DMA_directModeErrorCallback(initStructure->DMAy_Streamx);
+		callbacks->directModeError(DMAy_Streamx, entry->context);
 	}
 
 	// Check FIFO error flag
-	if((flags & DMA_FLAG_FEIF) && (initStructure->DMAy_Streamx->FCR & DMA_SxFCR_FEIE))
+	if((flags & DMA_FLAG_FEIF) && (DMAy_Streamx->FCR & DMA_SxFCR_FEIE) && (callbacks->fifoError != NULL))
+	{
+		callbacks->fifoError(DMAy_Streamx, entry->context);
+	}
+}
+
+//---------------------------------------------------------------------------
+// Static functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function returns the index of the stream in the registry.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @retval	The index, 0-7 for DMA1 streams and 8-15 for DMA2 streams.
+ */
+static uint8_t DMA_getIndex(DMA_Stream_TypeDef *DMAy_Streamx)
+{
+	uint32_t streamNumber = ((uint32_t)DMAy_Streamx & 0xFFU) / 0x18U;	// 0xFF is a mask. 0x18 is a step between stream registers.
+
+	return (uint8_t)((DMAy_Streamx < DMA2_Stream0) ? streamNumber : (streamNumber + 8U));
+}
+
+/**
+ * @brief 	This function gets DMA flags of the stream.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @retval	DMA flags.
+ */
+static uint32_t DMA_getStreamFlags(DMA_Stream_TypeDef *DMAy_Streamx)
+{
+	uint32_t flags = 0;
+
+	DMA_TypeDef* DMAy;
+
+	uint32_t streamNumber = ((uint32_t)DMAy_Streamx & 0xFFU) / 0x18U;	// 0xFF is a mask. 0x18 is a step between stream registers.
+																		// For a better understanding of magic numbers. See the reference manual.
+	DMAy = (DMAy_Streamx < DMA2_Stream0) ? DMA1 : DMA2;
+
+	if(streamNumber < 4U)	// Stream 0-3 is LIFCR and stream 4-6 is HIFCR
 	{
-		DMA_fifoErrorCallback(initStructure->DMAy_Streamx);
+		flags = DMAy->LISR >> flagBitshiftOffset[streamNumber];
+	} else
+	{
+		flags = DMAy->HISR >> flagBitshiftOffset[streamNumber];
 	}
+
+	return flags;
+}
+
+/**
+ * @brief 	These functions route the interrupts of the streams which aren't claimed to the weak callbacks.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	context - Not used.
+ * @retval	None.
+ */
+static void DMA_defaultTransferComplete(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	(void)context;
+	DMA_transferCompleteCallback(DMAy_Streamx);
+}
+
+static void DMA_defaultHalfTransferComplete(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	(void)context;
+	DMA_halfTransferCompleteCallback(DMAy_Streamx);
+}
+
+static void DMA_defaultTransferError(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	(void)context;
+	DMA_transferErrorCallback(DMAy_Streamx);
+}
+
+static void DMA_defaultDirectModeError(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	(void)context;
+	DMA_directModeErrorCallback(DMAy_Streamx);
+}
+
+static void DMA_defaultFifoError(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	(void)context;
+	DMA_fifoErrorCallback(DMAy_Streamx);
 }
 
 //---------------------------------------------------------------------------
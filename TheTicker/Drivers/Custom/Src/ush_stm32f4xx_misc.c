@@ -17,77 +17,89 @@
 #include <stdio.h>
 
 //---------------------------------------------------------------------------
-// Variables
-//---------------------------------------------------------------------------
-static volatile uint32_t timeoutTicks = 0;
-
-//---------------------------------------------------------------------------
-// Redefine printf function
-//---------------------------------------------------------------------------
-int _write(int file, char *ptr, int len)
-{
-	for(int i=0 ; i < len ; i++)
-	{
-		ITM_SendChar((*ptr++));
-	}
-
-  return len;
-}
-
-//---------------------------------------------------------------------------
-// The section of timeout timer
+// The section of timebase
 //---------------------------------------------------------------------------
 
 /**
- * @brief 	This function sets up TIM14 timer to check for timeout.
+ * @brief 	This function starts the free-running microsecond timebase.
+ * @note	It has to be called after the system clock is configured.
  * @retval	None.
  */
-void MISC_timeoutTimer(void)
+void MISC_timebaseInit(void)
 {
-	// Enable TIM14 clock
-	RCC->APB1ENR |= RCC_APB1ENR_TIM14EN;
+	// Enable TIM5 clock
+	RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
 
-	// Set the clock division
-	TIM14->CR1 &= ~TIM_CR1_CKD;
+	// Stop the counter while the core is halted, so the timeouts don't expire at a breakpoint
+	DBGMCU->APB1FZ |= DBGMCU_APB1_FZ_DBG_TIM5_STOP;
 
-	// Set the auto-reload preload
-	TIM14->CR1 &= ~TIM_CR1_ARPE;
+	// Upcounting without the clock division and the auto-reload preload
+	MISC_TIMEBASE_TIMER->CR1 = 0U;
 
-	// Set the Autoreload value
-	TIM14->ARR = (uint32_t)((500U) - 1U);
+	// The whole 32-bit range, the counter wraps by itself
+	MISC_TIMEBASE_TIMER->ARR = 0xFFFFFFFFU;
 
-	// Set the Prescaler value
-	TIM14->PSC = 180 - 1;
+	// Set the Prescaler value, 1 MHz
+	MISC_TIMEBASE_TIMER->PSC = MISC_TIMEBASE_PRESCALER - 1U;
 
-	TIM14->EGR = TIM_EGR_UG;
+	// Load the prescaler, no interrupt is enabled
+	MISC_TIMEBASE_TIMER->EGR = TIM_EGR_UG;
+	MISC_TIMEBASE_TIMER->CNT = 0U;
 
-	// Enable the TIM update interrupt
-	TIM14->DIER |= TIM_DIER_UIE;
+	// Enable TIM5
+	MISC_TIMEBASE_TIMER->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * @brief 	This function returns the current time of the timebase.
+ * @retval	The time in microseconds.
+ */
+uint32_t MISC_timebaseNow(void)
+{
+	return MISC_TIMEBASE_TIMER->CNT;
+}
 
-	// Enable TIM14
-	TIM14->CR1 |= TIM_CR1_CEN;
+/**
+ * @brief 	This function returns the time which has passed since the moment.
+ * @param 	start - The moment returned by MISC_timebaseNow.
+ * @retval	The time in microseconds.
+ */
+uint32_t MISC_timebaseElapsed(uint32_t start)
+{
+	return MISC_TIMEBASE_TIMER->CNT - start;
+}
 
-	// Enable the TIM14 global interrupt
-	MISC_NVIC_EnableIRQ(TIM8_TRG_COM_TIM14_IRQn);
-	MISC_NVIC_SetPriority(TIM8_TRG_COM_TIM14_IRQn, MIN_PRIORITY, 0U);
+/**
+ * @brief 	This function returns the deadline which comes after the timeout from now.
+ * @param 	timeout - The timeout in microseconds, up to 0x7FFFFFFF.
+ * @retval	The deadline for MISC_timebaseIsExpired.
+ */
+uint32_t MISC_timebaseDeadline(uint32_t timeout)
+{
+	return MISC_TIMEBASE_TIMER->CNT + timeout;
 }
 
 /**
- * @brief 	This function increments a variable "timeoutTicks".
- * @retval	None.
+ * @brief 	This function checks whether the deadline has come.
+ * @note	The difference is signed, so the check stays right when the counter wraps.
+ * @param 	deadline - The deadline returned by MISC_timebaseDeadline.
+ * @retval	1 if the deadline has come, otherwise 0.
  */
-void MISC_timeoutTimerIncTick(void)
+uint8_t MISC_timebaseIsExpired(uint32_t deadline)
 {
-	timeoutTicks++;
+	return ((int32_t)(MISC_TIMEBASE_TIMER->CNT - deadline) >= 0) ? 1U : 0U;
 }
 
 /**
- * @brief 	This function returns "timeoutTicks" variable value.
+ * @brief 	This function waits for the time without the scheduler.
+ * @param 	delay - The time in microseconds, up to 0x7FFFFFFF.
  * @retval	None.
  */
-uint32_t MISC_timeoutGetTick(void)
+void MISC_timebaseDelay(uint32_t delay)
 {
-	return timeoutTicks;
+	uint32_t deadline = MISC_timebaseDeadline(delay);
+
+	while(!MISC_timebaseIsExpired(deadline));
 }
 
 //---------------------------------------------------------------------------
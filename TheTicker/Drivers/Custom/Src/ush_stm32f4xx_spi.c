@@ -15,6 +15,63 @@
 // Includes
 //---------------------------------------------------------------------------
 #include "ush_stm32f4xx_spi.h"
+#include <stddef.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+
+// TX DMA interrupt priority
+#define PREEMPTION_PRIORITY_TX		(5U)
+#define SUBPRIORITY_TX				(0U)
+
+#define TIMEOUT						(5000U) // us
+#define SPI_COUNT					(6U)
+
+#define BURST_ALIGNMENT				((uint32_t)0x0F)	// 4 beats of words, the burst never crosses a 1 KB boundary
+#define WORD_ALIGNMENT				((uint32_t)0x03)
+
+//---------------------------------------------------------------------------
+// Typedefs and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief SPI TX DMA description structure (dmaPack_1)
+ */
+typedef struct
+{
+	SPI_TypeDef *SPIx;					/* SPI instance */
+	uint32_t dmaClockBit;				/* The bit of the DMA clock in RCC AHB1ENR register */
+	USH_DMA_channels channel;			/* DMA channel of the stream */
+	DMA_Stream_TypeDef *txStream;		/* TX DMA stream */
+	IRQn_Type txStreamIrq;				/* TX DMA stream interrupt */
+} SPI_dmaHardwareTypeDef;
+
+//---------------------------------------------------------------------------
+// Static function prototypes
+//---------------------------------------------------------------------------
+static int8_t SPI_getIndex(SPI_TypeDef *SPIx);
+static void SPI_txCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+
+//---------------------------------------------------------------------------
+// Private variables
+//---------------------------------------------------------------------------
+
+// See the table of DMA streams in ush_stm32f4xx_spi.h
+static const SPI_dmaHardwareTypeDef spiDmaHardware[SPI_COUNT] =
+{
+	{SPI1, RCC_AHB1ENR_DMA2EN, DMA_CHANNEL_3, DMA2_Stream3, DMA2_Stream3_IRQn},
+	{SPI2, RCC_AHB1ENR_DMA1EN, DMA_CHANNEL_0, DMA1_Stream4, DMA1_Stream4_IRQn},
+	{SPI3, RCC_AHB1ENR_DMA1EN, DMA_CHANNEL_0, DMA1_Stream5, DMA1_Stream5_IRQn},
+	{SPI4, RCC_AHB1ENR_DMA2EN, DMA_CHANNEL_4, DMA2_Stream1, DMA2_Stream1_IRQn},
+	{SPI5, RCC_AHB1ENR_DMA2EN, DMA_CHANNEL_2, DMA2_Stream4, DMA2_Stream4_IRQn},
+	{SPI6, RCC_AHB1ENR_DMA2EN, DMA_CHANNEL_1, DMA2_Stream5, DMA2_Stream5_IRQn},
+};
+
+static USH_DMA_initTypeDef spiDmaTx[SPI_COUNT];
+
+// A transfer error finishes the transfer as well, so the owner of the data doesn't wait forever
+static const USH_DMA_callbacksTypeDef spiTxCallbacks = {SPI_txCompleteHandler, NULL, SPI_txCompleteHandler, NULL, NULL};
 
 //---------------------------------------------------------------------------
 // Initialization functions
@@ -39,6 +96,7 @@ void SPI_init(USH_SPI_initDefaultTypeDef *initStructure)
 	USH_GPIO_initTypeDef initGpioStructure = {0,};
 
 	uint16_t temp;
+	int8_t index = 0;
 
 	// Check parameters
 	assert_param(IS_SPI_ALL_INSTANCE(initStructure->SPIx));
@@ -114,6 +172,34 @@ void SPI_init(USH_SPI_initDefaultTypeDef *initStructure)
 	}
 	/* ----------------------- DMA configuration --------------------------- */
 
+	index = SPI_getIndex(initStructure->SPIx);
+
+	// The TX stream is optional, the polling functions work without it
+	if((index >= 0) && (DMA_claimStream(spiDmaHardware[index].txStream, &spiTxCallbacks, (void*)&spiDmaHardware[index]) == STATUS_OK))
+	{
+		// Enable DMA clock
+		RCC->AHB1ENR |= spiDmaHardware[index].dmaClockBit;
+
+		// DMA interrupt init
+		MISC_NVIC_SetPriority(spiDmaHardware[index].txStreamIrq, PREEMPTION_PRIORITY_TX, SUBPRIORITY_TX);
+		MISC_NVIC_EnableIRQ(spiDmaHardware[index].txStreamIrq);
+
+		// The memory data size and burst are chosen for every transfer (see SPI_transmitDMA)
+		spiDmaTx[index].DMAy_Streamx			= spiDmaHardware[index].txStream;
+		spiDmaTx[index].Channel					= spiDmaHardware[index].channel;
+		spiDmaTx[index].Direction				= DMA_MEMORY_TO_PERIPH;
+		spiDmaTx[index].PeriphInc				= DMA_PINC_DISABLE;
+		spiDmaTx[index].MemInc					= DMA_MINC_ENABLE;
+		spiDmaTx[index].PeriphDataAlignment		= DMA_PERIPH_SIZE_HALFWORD;
+		spiDmaTx[index].MemDataAlignment		= DMA_MEMORY_SIZE_HALFWORD;
+		spiDmaTx[index].Mode					= DMA_NORMAL_MODE;
+		spiDmaTx[index].Priority				= DMA_PRIORITY_MEDIUM;
+		spiDmaTx[index].MemBurst				= DMA_MBURST_SINGLE;
+		spiDmaTx[index].PeriphBurst				= DMA_PBURST_SINGLE;
+		spiDmaTx[index].FIFOMode				= DMA_FIFO_MODE_ENABLE;
+		spiDmaTx[index].FIFOThreshold			= DMA_FIFO_THRESHOLD_FULL;
+		DMA_init(&spiDmaTx[index]);
+	}
 
 	/* ----------------------- SPI configuration --------------------------- */
 
@@ -165,7 +251,108 @@ void SPI_writeData(SPI_TypeDef *SPIx, uint8_t reg, uint8_t data)
 	SPIx->DR = temp;
 
 	while(!(SPIx->SR & SPI_SR_RXNE));
-	(void) SPI1->DR;
+	(void) SPIx->DR;
+}
+
+/**
+ * @brief 	This function transmits a 16-bit word and returns the word received at the same time.
+ * @param 	SPIx - A pointer to SPIx peripheral to be used where x is between 1 to 6.
+ * @param 	data - Data to be transmitted.
+ * @retval	Received data.
+ */
+uint16_t SPI_transmitReceiveData(SPI_TypeDef *SPIx, uint16_t data)
+{
+	// Check parameters
+	assert_param(IS_SPI_ALL_INSTANCE(SPIx));
+
+	// Check if the SPI is already enabled
+	if((SPIx->CR1 & SPI_CR1_SPE) != SPI_CR1_SPE)
+	{
+		// Enable SPI peripheral
+		SPIx->CR1 |= SPI_CR1_SPE;
+	}
+
+	while(!(SPIx->SR & SPI_SR_TXE));
+
+	SPIx->DR = data;
+
+	while(!(SPIx->SR & SPI_SR_RXNE));
+
+	return (uint16_t)SPIx->DR;
+}
+
+/**
+ * @brief 	This function starts transmitting the 16-bit words through DMA.
+ * @note	The received words are dropped. SPI_txCompleteCallback is called when the last word has left the shift
+ * 			register, so the CS pin can be raised from it. Memory is read by words through the FIFO when the data
+ * 			is aligned, by bursts of 4 words when it is aligned to 16 bytes.
+ * @param 	SPIx - A pointer to SPIx peripheral to be used where x is between 1 to 6.
+ * @param 	data - A pointer to the words. They mustn't be changed until the transfer is over.
+ * @param 	size - The number of words.
+ * @retval	The periphery status. STATUS_BUSY if the TX stream isn't claimed by this SPI.
+ */
+USH_peripheryStatus SPI_transmitDMA(SPI_TypeDef *SPIx, const uint16_t *data, uint16_t size)
+{
+	// Check parameters
+	assert_param(IS_SPI_ALL_INSTANCE(SPIx));
+
+	uint32_t deadline = MISC_timebaseDeadline(TIMEOUT);
+	uint32_t alignment = (uint32_t)data | ((uint32_t)size * sizeof(uint16_t));
+	int8_t index = SPI_getIndex(SPIx);
+	DMA_Stream_TypeDef *DMA_Stream;
+
+	if((index < 0) || (spiDmaTx[index].DMAy_Streamx == NULL)) return STATUS_BUSY;
+
+	DMA_Stream = spiDmaTx[index].DMAy_Streamx;
+
+	while(DMA_Stream->CR & DMA_SxCR_EN)
+	{
+		// Check timeout
+		if(MISC_timebaseIsExpired(deadline))
+		{
+			return STATUS_TIMEOUT;
+		}
+	}
+
+	// Fill DMA registers
+	DMA_Stream->NDTR = size;					// Set the number of words
+	DMA_Stream->PAR = (uint32_t)&SPIx->DR;		// Set peripheral address
+	DMA_Stream->M0AR = (uint32_t)data;			// Set memory address
+
+	// The FIFO unpacks a memory word into two SPI words
+	DMA_Stream->CR &= ~(DMA_SxCR_MSIZE | DMA_SxCR_MBURST);
+
+	if((alignment & BURST_ALIGNMENT) == 0U)
+	{
+		DMA_Stream->CR |= DMA_MEMORY_SIZE_WORD | DMA_MBURST_INCR4;
+	} else if((alignment & WORD_ALIGNMENT) == 0U)
+	{
+		DMA_Stream->CR |= DMA_MEMORY_SIZE_WORD;
+	} else
+	{
+		DMA_Stream->CR |= DMA_MEMORY_SIZE_HALFWORD;
+	}
+
+	// Clear interrupt flags
+	DMA_clearFlags(DMA_Stream, DMA_FLAG_ALL);
+
+	// Enable interrupts
+	DMA_Stream->CR |= DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+
+	// Enable DMA stream
+	DMA_state(DMA_Stream, ENABLE);
+
+	// Check if the SPI is already enabled
+	if((SPIx->CR1 & SPI_CR1_SPE) != SPI_CR1_SPE)
+	{
+		// Enable SPI peripheral
+		SPIx->CR1 |= SPI_CR1_SPE;
+	}
+
+	// Enable SPI TX DMA
+	SPIx->CR2 |= SPI_CR2_TXDMAEN;
+
+	return STATUS_OK;
 }
 
 /**
@@ -191,3 +378,63 @@ void SPI_csPin(GPIO_TypeDef *GPIOx, uint16_t csPin, USH_SPI_csState state)
 		GPIO_writeBits(GPIOx, csPin, GPIO_PIN_RESET);
 	}
 }
+
+//---------------------------------------------------------------------------
+// Static Functions
+//---------------------------------------------------------------------------
+
+/**
+ * @brief 	This function returns the index of the SPI in the DMA table.
+ * @param 	SPIx - A pointer to SPIx peripheral to be used where x is between 1 to 6.
+ * @retval	The index or -1 if the SPI isn't found.
+ */
+static int8_t SPI_getIndex(SPI_TypeDef *SPIx)
+{
+	for(uint8_t index = 0; index < SPI_COUNT; index++)
+	{
+		if(spiDmaHardware[index].SPIx == SPIx) return (int8_t)index;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief 	This function finishes the TX DMA transfer.
+ * @note	The stream is done when the last word is written to DR, so the last two words are still being
+ * 			shifted out. The wait is a few microseconds at the prescalers used for the displays.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	context - A pointer to the description of the SPI.
+ * @retval	None.
+ */
+static void SPI_txCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	SPI_TypeDef *SPIx = ((const SPI_dmaHardwareTypeDef*)context)->SPIx;
+
+	(void)DMAy_Streamx;
+
+	while(!(SPIx->SR & SPI_SR_TXE) || (SPIx->SR & SPI_SR_BSY));
+
+	SPIx->CR2 &= ~SPI_CR2_TXDMAEN;
+
+	// The received words weren't read, the overrun is cleared by reading DR and then SR
+	(void)SPIx->DR;
+	(void)SPIx->SR;
+
+	SPI_txCompleteCallback(SPIx);
+}
+
+//---------------------------------------------------------------------------
+// DMA interrupt user callbacks
+//---------------------------------------------------------------------------
+
+/**
+  * @brief  TX transfer complete callbacks. It is called when the last word has left the shift register.
+  * 		NOTE: This function should not be modified, when the callback is needed,
+           	   	  the SPI_txCompleteCallback could be implemented in the user file.
+  * @param  SPIx - A pointer to SPIx peripheral to be used where x is between 1 to 6.
+  * @retval None.
+  */
+__WEAK void SPI_txCompleteCallback(SPI_TypeDef *SPIx)
+{
+	(void)SPIx;
+}
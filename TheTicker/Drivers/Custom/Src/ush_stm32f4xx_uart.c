@@ -14,6 +14,7 @@
 //---------------------------------------------------------------------------
 // Includes
 //---------------------------------------------------------------------------
+#include <stddef.h>
 #include "ush_stm32f4xx_gpio.h"
 #include "ush_stm32f4xx_dma.h"
 #include "ush_stm32f4xx_uart.h"
@@ -30,20 +31,126 @@
 #define PREEMPTION_PRIORITY_UART	(5U)
 #define SUBPRIORITY_UART			(0)
 
-#define TIMEOUT						(5U) // ms
+#define TIMEOUT						(5000U) // us
+
+#define USART_COUNT					(8U)
+
+//---------------------------------------------------------------------------
+// Structures and enumerations
+//---------------------------------------------------------------------------
+
+/**
+ * @brief U(S)ART pin description structure
+ */
+typedef struct
+{
+	GPIO_TypeDef *port;					/* A pointer to GPIO port, NULL - the pin isn't available */
+	USH_GPIO_pins pin;					/* The GPIO pin */
+} USART_pinTypeDef;
+
+/**
+ * @brief U(S)ART hardware description structure
+ */
+typedef struct
+{
+	USART_TypeDef *USARTx;				/* A pointer to U(S)ART peripheral */
+	__IO uint32_t *clockRegister;		/* The RCC register which enables the U(S)ART clock */
+	uint32_t clockBit;					/* The bit of the U(S)ART clock in clockRegister */
+	IRQn_Type irq;						/* The U(S)ART global interrupt */
+	USH_GPIO_alternate alternate;		/* The alternate function of all U(S)ART pins */
+	USART_pinTypeDef tx[2];				/* TX pin for pinsPack_1 and pinsPack_2 */
+	USART_pinTypeDef rx[2];				/* RX pin for pinsPack_1 and pinsPack_2 */
+	USART_pinTypeDef cts;				/* CTS pin */
+	USART_pinTypeDef rts;				/* RTS pin */
+	uint32_t dmaClockBit;				/* The bit of the DMA clock in RCC AHB1ENR register */
+	USH_DMA_channels channel;			/* DMA channel of both streams */
+	DMA_Stream_TypeDef *txStream;		/* TX DMA stream */
+	IRQn_Type txStreamIrq;				/* TX DMA stream interrupt */
+	DMA_Stream_TypeDef *rxStream;		/* RX DMA stream */
+	IRQn_Type rxStreamIrq;				/* RX DMA stream interrupt */
+} USART_hardwareTypeDef;
+
+/**
+ * @brief U(S)ART state structure
+ */
+typedef struct
+{
+	USH_USART_initTypeDef *init;		/* A pointer to the init structure, NULL - the U(S)ART isn't initialized */
+	USH_DMA_initTypeDef dmaTx;			/* TX DMA stream configuration */
+	USH_DMA_initTypeDef dmaRx;			/* RX DMA stream configuration */
+	USH_USART_errorsTypeDef errors;		/* Error counters */
+} USART_stateTypeDef;
 
 //---------------------------------------------------------------------------
 // Private variables
 //---------------------------------------------------------------------------
-USH_DMA_initTypeDef initDMA_txStructure = {0};
-USH_DMA_initTypeDef initDMA_rxStructure = {0};
+
+// See the tables of pins and DMA streams in ush_stm32f4xx_uart.h
+static const USART_hardwareTypeDef usartHardware[USART_COUNT] =
+{
+	{USART1, &RCC->APB2ENR, RCC_APB2ENR_USART1EN, USART1_IRQn, GPIO_AF7_USART1,
+	 {{GPIOA, GPIO_PIN_9},  {GPIOB, GPIO_PIN_6}},  {{GPIOA, GPIO_PIN_10}, {GPIOB, GPIO_PIN_7}},
+	 {GPIOA, GPIO_PIN_11}, {GPIOA, GPIO_PIN_12},
+	 RCC_AHB1ENR_DMA2EN, DMA_CHANNEL_4, DMA2_Stream7, DMA2_Stream7_IRQn, DMA2_Stream2, DMA2_Stream2_IRQn},
+
+	{USART2, &RCC->APB1ENR, RCC_APB1ENR_USART2EN, USART2_IRQn, GPIO_AF7_USART2,
+	 {{GPIOA, GPIO_PIN_2},  {GPIOD, GPIO_PIN_5}},  {{GPIOA, GPIO_PIN_3},  {GPIOD, GPIO_PIN_6}},
+	 {GPIOA, GPIO_PIN_0}, {GPIOA, GPIO_PIN_1},
+	 RCC_AHB1ENR_DMA1EN, DMA_CHANNEL_4, DMA1_Stream6, DMA1_Stream6_IRQn, DMA1_Stream5, DMA1_Stream5_IRQn},
+
+	{USART3, &RCC->APB1ENR, RCC_APB1ENR_USART3EN, USART3_IRQn, GPIO_AF7_USART3,
+	 {{GPIOB, GPIO_PIN_10}, {GPIOC, GPIO_PIN_10}}, {{GPIOB, GPIO_PIN_11}, {GPIOC, GPIO_PIN_11}},
+	 {GPIOB, GPIO_PIN_13}, {GPIOB, GPIO_PIN_14},
+	 RCC_AHB1ENR_DMA1EN, DMA_CHANNEL_4, DMA1_Stream3, DMA1_Stream3_IRQn, DMA1_Stream1, DMA1_Stream1_IRQn},
+
+	{UART4, &RCC->APB1ENR, RCC_APB1ENR_UART4EN, UART4_IRQn, GPIO_AF8_UART4,
+	 {{GPIOA, GPIO_PIN_0},  {GPIOC, GPIO_PIN_10}}, {{GPIOA, GPIO_PIN_1},  {GPIOC, GPIO_PIN_11}},
+	 {NULL, 0}, {NULL, 0},
+	 RCC_AHB1ENR_DMA1EN, DMA_CHANNEL_4, DMA1_Stream4, DMA1_Stream4_IRQn, DMA1_Stream2, DMA1_Stream2_IRQn},
+
+	{UART5, &RCC->APB1ENR, RCC_APB1ENR_UART5EN, UART5_IRQn, GPIO_AF8_UART5,
+	 {{GPIOC, GPIO_PIN_12}, {NULL, 0}},            {{GPIOD, GPIO_PIN_2},  {NULL, 0}},
+	 {NULL, 0}, {NULL, 0},
+	 RCC_AHB1ENR_DMA1EN, DMA_CHANNEL_4, DMA1_Stream7, DMA1_Stream7_IRQn, DMA1_Stream0, DMA1_Stream0_IRQn},
+
+	{USART6, &RCC->APB2ENR, RCC_APB2ENR_USART6EN, USART6_IRQn, GPIO_AF8_USART6,
+	 {{GPIOC, GPIO_PIN_6},  {GPIOG, GPIO_PIN_14}}, {{GPIOC, GPIO_PIN_7},  {GPIOG, GPIO_PIN_9}},
+	 {GPIOG, GPIO_PIN_15}, {GPIOG, GPIO_PIN_8},
+	 RCC_AHB1ENR_DMA2EN, DMA_CHANNEL_5, DMA2_Stream6, DMA2_Stream6_IRQn, DMA2_Stream1, DMA2_Stream1_IRQn},
+
+	{UART7, &RCC->APB1ENR, RCC_APB1ENR_UART7EN, UART7_IRQn, GPIO_AF8_UART7,
+	 {{GPIOE, GPIO_PIN_8},  {GPIOF, GPIO_PIN_7}},  {{GPIOE, GPIO_PIN_7},  {GPIOF, GPIO_PIN_6}},
+	 {NULL, 0}, {NULL, 0},
+	 RCC_AHB1ENR_DMA1EN, DMA_CHANNEL_5, DMA1_Stream1, DMA1_Stream1_IRQn, DMA1_Stream3, DMA1_Stream3_IRQn},
+
+	{UART8, &RCC->APB1ENR, RCC_APB1ENR_UART8EN, UART8_IRQn, GPIO_AF8_UART8,
+	 {{GPIOE, GPIO_PIN_1},  {NULL, 0}},            {{GPIOE, GPIO_PIN_0},  {NULL, 0}},
+	 {NULL, 0}, {NULL, 0},
+	 RCC_AHB1ENR_DMA1EN, DMA_CHANNEL_5, DMA1_Stream0, DMA1_Stream0_IRQn, DMA1_Stream6, DMA1_Stream6_IRQn},
+};
+
+static USART_stateTypeDef usartStates[USART_COUNT];
 
 //---------------------------------------------------------------------------
 // Static function prototypes
 //---------------------------------------------------------------------------
 static uint16_t USART_BRRSampling16(uint32_t pclk, uint32_t bautrate);
+static uint16_t USART_BRRSampling8(uint32_t pclk, uint32_t baudrate);
+static uint32_t USART_getPCLKFreq(USART_TypeDef* usart);
 static uint32_t USART_getPCLK1Freq(void);
 static uint32_t USART_getPCLK2Freq(void);
+static int8_t USART_getIndex(USART_TypeDef* usart);
+static void USART_initPin(const USART_pinTypeDef *pin, USH_GPIO_alternate alternate);
+static void USART_initDmaStream(USH_DMA_initTypeDef *dmaStructure, const USART_hardwareTypeDef *hardware, USH_USART_mode mode);
+static USH_peripheryStatus USART_claimDmaStreams(const USART_hardwareTypeDef *hardware, USART_stateTypeDef *state, USH_USART_mode mode);
+static void USART_txCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+static void USART_txErrorHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+static void USART_rxHalfCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+static void USART_rxCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context);
+
+// The context of the stream callbacks is the state of the U(S)ART
+static const USH_DMA_callbacksTypeDef usartTxCallbacks = {USART_txCompleteHandler, NULL, USART_txErrorHandler, NULL, NULL};
+static const USH_DMA_callbacksTypeDef usartRxCallbacks = {USART_rxCompleteHandler, USART_rxHalfCompleteHandler, NULL, NULL, NULL};
 
 //---------------------------------------------------------------------------
 // Initialization functions
@@ -55,149 +162,90 @@ static uint32_t USART_getPCLK2Freq(void);
  *			- Asynchronous mode;
  *			- Word Length - 8 bits;
  *			- Parity - None;
- *			- Stop bits - 1;
- *			- Hardware flow control - None;
- *			- Over sampling - 16 samples.
+ *			- Stop bits - 1.
+ * @note	The pins, DMA streams and interrupts are taken from the hardware table, so every U(S)ART is supported.
+ * 			The init structure has to exist while the U(S)ART is used, its interrupts are routed through it.
  * @param 	initStructure - A pointer to a USH_USART_initTypeDef structure that contains the configuration information
  * 							for the specified U(S)ART peripheral.
  * @retval	None.
  */
 void USART_init(USH_USART_initTypeDef *initStructure)
 {
-	USH_GPIO_initTypeDef initGpioStructure = {0,};
-
 	uint16_t tmpReg = 0;
 	uint32_t pclk = 0;
+	int8_t index = USART_getIndex(initStructure->USARTx);
+	const USART_hardwareTypeDef *hardware;
+	USART_stateTypeDef *state;
 
 	// Check parameters
 	assert_param(IS_USART_ALL_INSTANCE(initStructure->USARTx));
 	assert_param(IS_USART_PINSPACK(initStructure->PinsPack));
-	assert_param(IS_USART_BAUDRATE(initStructure->BaudRate));
 	assert_param(IS_USART_MODE(initStructure->Mode));
+	assert_param(IS_USART_OVERSAMPLING(initStructure->OverSampling));
+	assert_param(IS_USART_HW_FLOW_CONTROL(initStructure->HardwareFlowControl));
+	assert_param(IS_USART_ERROR_INTERRUPT(initStructure->ErrorInterrupt));
 
-	USH_USART_DISABLE(initStructure->USARTx);
+	if(index < 0) return;
 
-	/* ----------------------- GPIO configuration -------------------------- */
+	hardware = &usartHardware[index];
+	state = &usartStates[index];
 
-	// Fill in the initGpioStructure to initialize the GPIO pins, these parameters are used for all pinsPacks
-	initGpioStructure.Mode			= GPIO_MODE_ALTERNATE_PP;
-	initGpioStructure.Pull			= GPIO_PULLUP;
-	initGpioStructure.Speed			= GPIO_SPEED_VERY_HIGH;
+	// Check that the pinsPack and the flow control pins exist for the U(S)ART
+	assert_param(hardware->tx[initStructure->PinsPack].port != NULL);
+	assert_param(!(initStructure->HardwareFlowControl & USART_HW_FLOW_CONTROL_CTS) || (hardware->cts.port != NULL));
+	assert_param(!(initStructure->HardwareFlowControl & USART_HW_FLOW_CONTROL_RTS) || (hardware->rts.port != NULL));
 
-	if(initStructure->USARTx == USART1)
+	// The streams which are shared with another U(S)ART or driver mustn't be in use
+	if(USART_claimDmaStreams(hardware, state, initStructure->Mode) != STATUS_OK)
 	{
-		// USART1 clock enable
-		RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+		assert_param(0);
+		return;
+	}
 
-		if(initStructure->PinsPack == USART_PINSPACK_1) 	// Pins configuration according to pinsPack_1
-		{
-			// GPIOA clock enable
-			RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;
+	USH_USART_DISABLE(initStructure->USARTx);
 
-			// USART1 GPIO pins pack 1 configuration
-			// PA9 	   ------> USART1_TX
-			// PA10    ------> USART1_RX
-			initGpioStructure.GPIOx 		= GPIOA;
-			initGpioStructure.Alternate		= GPIO_AF7_USART1;
+	// U(S)ART clock enable
+	*hardware->clockRegister |= hardware->clockBit;
 
-			if(initStructure->Mode == USART_MODE_RX_TX)
-			{
-				initGpioStructure.Pin		= (GPIO_PIN_9 | GPIO_PIN_10);
+	/* ----------------------- GPIO configuration -------------------------- */
 
-			} else if(initStructure->Mode == USART_MODE_RX)
-			{
-				initGpioStructure.Pin		= GPIO_PIN_10;
+	if(initStructure->Mode & USART_MODE_TX) USART_initPin(&hardware->tx[initStructure->PinsPack], hardware->alternate);
+	if(initStructure->Mode & USART_MODE_RX) USART_initPin(&hardware->rx[initStructure->PinsPack], hardware->alternate);
 
-			} else					// TX mode selected
-			{
-				initGpioStructure.Pin		= GPIO_PIN_9;
-			}
+	// The hardware flow control pins are the same for both pinsPacks
+	if(initStructure->HardwareFlowControl & USART_HW_FLOW_CONTROL_CTS) USART_initPin(&hardware->cts, hardware->alternate);
+	if(initStructure->HardwareFlowControl & USART_HW_FLOW_CONTROL_RTS) USART_initPin(&hardware->rts, hardware->alternate);
 
-		} else												// Pins configuration according to pinsPack_2
-		{
-			// GPIOB clock enable
-			RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN;
-
-			// USART1 GPIO pins pack 1 configuration
-			// PB6 	   ------> USART1_TX
-			// PB7     ------> USART1_RX
-			initGpioStructure.GPIOx 		= GPIOB;
-			initGpioStructure.Alternate		= GPIO_AF7_USART1;
-
-			if(initStructure->Mode == USART_MODE_RX_TX)
-			{
-				initGpioStructure.Pin		= (GPIO_PIN_6 | GPIO_PIN_7);
-
-			} else if(initStructure->Mode == USART_MODE_RX)
-			{
-				initGpioStructure.Pin		= GPIO_PIN_7;
-
-			} else					// TX mode selected
-			{
-				initGpioStructure.Pin		= GPIO_PIN_6;
-			}
-		}
+	/* ----------------------- DMA configuration --------------------------- */
 
-		GPIO_init(&initGpioStructure);
-	}
+	// Enable DMA clock
+	RCC->AHB1ENR |= hardware->dmaClockBit;
 
-	//TODO "There are only GPIO settings for USART1 pinsPack1 and pinsPack2"
+	// Check TX or TX/RX mode
+	if(initStructure->Mode & USART_MODE_TX)
+	{
+		// DMA interrupt init
+		MISC_NVIC_SetPriority(hardware->txStreamIrq, PREEMPTION_PRIORITY_TX, SUBPRIORITY_TX);
+		MISC_NVIC_EnableIRQ(hardware->txStreamIrq);
 
-	/* ----------------------- DMA configuration --------------------------- */
+		USART_initDmaStream(&state->dmaTx, hardware, USART_MODE_TX);
+	}
 
-	if(initStructure->USARTx == USART1)
+	// Check RX or TX/RX mode
+	if(initStructure->Mode & USART_MODE_RX)
 	{
-		// Enable DMA2 clock
-		RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
-
-		// Check TX or TX/RX mode
-		if(initStructure->Mode == USART_MODE_TX || initStructure->Mode == USART_MODE_RX_TX)
-		{
-			// DMA interrupt init
-			MISC_NVIC_SetPriority(DMA2_Stream7_IRQn, PREEMPTION_PRIORITY_TX, SUBPRIORITY_TX);
-			MISC_NVIC_EnableIRQ(DMA2_Stream7_IRQn);
-
-			initDMA_txStructure.DMAy_Streamx  			= DMA2_Stream7;
-			initDMA_txStructure.Channel 				= DMA_CHANNEL_4;
-			initDMA_txStructure.Direction 				= DMA_MEMORY_TO_PERIPH;
-			initDMA_txStructure.PeriphInc 				= DMA_PINC_DISABLE;
-			initDMA_txStructure.MemInc 			  		= DMA_MINC_ENABLE;
-			initDMA_txStructure.PeriphDataAlignment 	= DMA_PERIPH_SIZE_BYTE;
-			initDMA_txStructure.MemDataAlignment    	= DMA_MEMORY_SIZE_BYTE;
-			initDMA_txStructure.Mode 				 	= DMA_NORMAL_MODE;
-			initDMA_txStructure.Priority 			 	= DMA_PRIORITY_LOW;
-			initDMA_txStructure.FIFOMode 			 	= DMA_FIFO_MODE_DISABLE;
-			DMA_init(&initDMA_txStructure);
-		}
+		// DMA interrupt init
+		MISC_NVIC_SetPriority(hardware->rxStreamIrq, PREEMPTION_PRIORITY_RX, SUBPRIORITY_RX);
+		MISC_NVIC_EnableIRQ(hardware->rxStreamIrq);
 
-		// Check RX or TX/RX mode
-		if(initStructure->Mode == USART_MODE_RX || initStructure->Mode == USART_MODE_RX_TX)
-		{
-			// DMA interrupt init
-			MISC_NVIC_SetPriority(DMA2_Stream2_IRQn, PREEMPTION_PRIORITY_TX, SUBPRIORITY_TX);
-			MISC_NVIC_EnableIRQ(DMA2_Stream2_IRQn);
-
-			initDMA_rxStructure.DMAy_Streamx			= DMA2_Stream2;
-			initDMA_rxStructure.Channel 				= DMA_CHANNEL_4;
-			initDMA_rxStructure.Direction 				= DMA_PERIPH_TO_MEMORY;
-			initDMA_rxStructure.PeriphInc 				= DMA_PINC_DISABLE;
-			initDMA_rxStructure.MemInc 			  		= DMA_MINC_ENABLE;
-			initDMA_rxStructure.PeriphDataAlignment 	= DMA_PERIPH_SIZE_BYTE;
-			initDMA_rxStructure.MemDataAlignment    	= DMA_MEMORY_SIZE_BYTE;
-			initDMA_rxStructure.Mode 				 	= DMA_CIRCULAR_MODE;
-			initDMA_rxStructure.Priority 			 	= DMA_PRIORITY_LOW;
-			initDMA_rxStructure.FIFOMode 			 	= DMA_FIFO_MODE_DISABLE;
-			DMA_init(&initDMA_rxStructure);
-		}
+		USART_initDmaStream(&state->dmaRx, hardware, USART_MODE_RX);
 	}
-		//TODO "There are only DMA settings for USART1"
 
 	/* ----------------------- USART configuration ------------------------- */
 
-	// Check parameters
-	assert_param(IS_USART_BAUDRATE(initStructure->BaudRate));
+	// 8 data bits, parity control disabled, multiprocessor communication disabled
+	tmpReg = initStructure->OverSampling;
 
-	// Oversampling by 16, 8 data bits, parity control disabled, multiprocessor communication disabled
 	if(initStructure->Mode == USART_MODE_RX_TX)
 	{
 		tmpReg |= USART_MODE_RX_TX;
@@ -215,33 +263,118 @@ void USART_init(USH_USART_initTypeDef *initStructure)
 	tmpReg = 0;
 	initStructure->USARTx->CR2 = tmpReg;
 
-	// IrDA disable, half duplex mode is not selected, flow control disabled.
+	// IrDA disable, half duplex mode is not selected, flow control and error interrupt are set according to the init structure.
 	tmpReg = initStructure->USARTx->CR3;
 	tmpReg &= 0xC0; // clear all bits except DMAT, DMAR
+	tmpReg |= initStructure->HardwareFlowControl | initStructure->ErrorInterrupt;
 	initStructure->USARTx->CR3 = tmpReg;
 
 	// Get PCLK frequency
-	if(initStructure->USARTx == USART1 || initStructure->USARTx == USART6)
+	pclk = USART_getPCLKFreq(initStructure->USARTx);
+
+	assert_param(IS_USART_BAUDRATE_FOR_CLOCK(pclk, initStructure->OverSampling, initStructure->BaudRate));
+
+	// USART BRR configuration
+	if(initStructure->OverSampling == USART_OVERSAMPLING_8)
 	{
-		pclk = USART_getPCLK2Freq();
+		initStructure->USARTx->BRR = USART_BRRSampling8(pclk, initStructure->BaudRate);
 	} else
 	{
-		pclk = USART_getPCLK1Freq();
+		initStructure->USARTx->BRR = USART_BRRSampling16(pclk, initStructure->BaudRate);
 	}
 
-	// USART BRR configuration
-	initStructure->USARTx->BRR = USART_BRRSampling16(pclk, initStructure->BaudRate);
+	// The interrupts of the U(S)ART are routed through its state from now on
+	state->init = initStructure;
 
 	USH_USART_ENABLE(initStructure->USARTx);
 
-	MISC_NVIC_SetPriority(USART1_IRQn, PREEMPTION_PRIORITY_UART, SUBPRIORITY_UART);
-	MISC_NVIC_EnableIRQ(USART1_IRQn);
+	MISC_NVIC_SetPriority(hardware->irq, PREEMPTION_PRIORITY_UART, SUBPRIORITY_UART);
+	MISC_NVIC_EnableIRQ(hardware->irq);
 }
 
 //---------------------------------------------------------------------------
 // Library Functions
 //---------------------------------------------------------------------------
 
+/**
+ * @brief 	This function changes the baud rate of the working U(S)ART. The transmission in progress is completed first.
+ * @note	Oversampling by 16 is used when it can reach the baud rate, otherwise oversampling by 8 is used.
+ * 			The DMA streams stay configured, so the reception continues at the new baud rate.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @param 	baudrate - The new baud rate. It can't be higher than PCLKx / 8.
+ * @retval	The periphery status.
+ */
+USH_peripheryStatus USART_setBaudRate(USART_TypeDef* usart, uint32_t baudrate)
+{
+	uint32_t deadline = MISC_timebaseDeadline(TIMEOUT);
+	uint32_t pclk = USART_getPCLKFreq(usart);
+
+	// Check parameters
+	assert_param(IS_USART_ALL_INSTANCE(usart));
+	assert_param(IS_USART_BAUDRATE_FOR_CLOCK(pclk, USART_OVERSAMPLING_8, baudrate));
+
+	while(!(usart->SR & USART_SR_TC))
+	{
+		// Check timeout
+		if(MISC_timebaseIsExpired(deadline))
+		{
+			return STATUS_TIMEOUT;
+		}
+	}
+
+	// OVER8 and BRR can be written only when the U(S)ART is disabled
+	USH_USART_DISABLE(usart);
+
+	if(IS_USART_BAUDRATE_FOR_CLOCK(pclk, USART_OVERSAMPLING_16, baudrate))
+	{
+		usart->CR1 &= ~USART_CR1_OVER8;
+		usart->BRR = USART_BRRSampling16(pclk, baudrate);
+	} else
+	{
+		usart->CR1 |= USART_CR1_OVER8;
+		usart->BRR = USART_BRRSampling8(pclk, baudrate);
+	}
+
+	USH_USART_ENABLE(usart);
+
+	return STATUS_OK;
+}
+
+/**
+ * @brief 	This function returns the highest baud rate which the U(S)ART can reach with oversampling by 8.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval	The baud rate.
+ */
+uint32_t USART_getMaxBaudRate(USART_TypeDef* usart)
+{
+	// Check parameters
+	assert_param(IS_USART_ALL_INSTANCE(usart));
+
+	return USART_getPCLKFreq(usart) / 8U;
+}
+
+/**
+ * @brief 	This function reads the received byte without DMA.
+ * @note	A byte with a framing, noise or parity error is read out and discarded.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @param 	data - A pointer to the variable for the byte.
+ * @retval	1 if a valid byte is read, otherwise 0.
+ */
+uint8_t USART_readByte(USART_TypeDef* usart, uint8_t *data)
+{
+	// Check parameters
+	assert_param(IS_USART_ALL_INSTANCE(usart));
+
+	// Reading SR and then DR clears the error flags
+	uint32_t status = usart->SR;
+
+	if(!(status & (USART_SR_RXNE | USART_SR_ORE))) return 0;
+
+	*data = (uint8_t)usart->DR;
+
+	return (status & (USART_SR_PE | USART_SR_FE | USART_SR_NE | USART_SR_ORE)) ? 0 : 1;
+}
+
 /**
  * @brief	This function receives an amount of data in DMA mode till either the expected number of data is received or an IDLE event occurs.
  * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
@@ -251,7 +384,7 @@ void USART_init(USH_USART_initTypeDef *initStructure)
  */
 USH_peripheryStatus USART_receiveToIdleDMA(USART_TypeDef* usart, uint8_t* data, uint16_t size)
 {
-	uint32_t startTicks = MISC_timeoutGetTick();
+	uint32_t deadline = MISC_timebaseDeadline(TIMEOUT);
 
 	// Check parameters
 	assert_param(IS_USART_ALL_INSTANCE(usart));
@@ -260,7 +393,7 @@ USH_peripheryStatus USART_receiveToIdleDMA(USART_TypeDef* usart, uint8_t* data,
 	while(!(usart->SR & USART_SR_TC))
 	{
 		// Check timeout
-		if((MISC_timeoutGetTick() - startTicks) > TIMEOUT)
+		if(MISC_timebaseIsExpired(deadline))
 		{
 			return STATUS_TIMEOUT;
 		}
@@ -277,8 +410,9 @@ USH_peripheryStatus USART_receiveToIdleDMA(USART_TypeDef* usart, uint8_t* data,
 	// Clear interrupt flags
 	DMA_clearFlags(DMA_Stream, DMA_FLAG_ALL);
 
-	// Enable DMA interrupts
-	DMA_Stream->CR |= DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_DMEIE;
+	// Enable DMA interrupts. The half and complete transfer interrupts let the data be read out
+	// before the circular buffer wraps around, even if there is no IDLE event for a long time.
+	DMA_Stream->CR |= DMA_SxCR_TCIE | DMA_SxCR_HTIE | DMA_SxCR_TEIE | DMA_SxCR_DMEIE;
 
 	USART_clearFlags(usart, USART_FLAG_ORE);
 
@@ -298,6 +432,8 @@ USH_peripheryStatus USART_receiveToIdleDMA(USART_TypeDef* usart, uint8_t* data,
 
 /**
  * @brief	This function transmits data using DMA.
+ * @note	The function doesn't wait for the previous data to leave the shift register, only for the DMA stream
+ * 			to be free. So it can be called from the DMA transfer complete interrupt to chain the next transfer.
  * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
  * @param 	data - The data to be transmitted.
  * @param 	size - The data transfer size.
@@ -305,29 +441,33 @@ USH_peripheryStatus USART_receiveToIdleDMA(USART_TypeDef* usart, uint8_t* data,
  */
 USH_peripheryStatus USART_transmitDMA(USART_TypeDef* usart, uint8_t* data, uint16_t size)
 {
-	uint32_t startTicks = MISC_timeoutGetTick();
+	uint32_t deadline = MISC_timebaseDeadline(TIMEOUT);
 
 	// check parameters
 	assert_param(IS_USART_ALL_INSTANCE(usart));
 	assert_param(IS_USART_MESSAGE_SIZE(size));
 
-	while(!(usart->SR & USART_SR_TC))
+	// Get DMA stream
+	DMA_Stream_TypeDef* DMA_Stream = USART_getDmaStream(usart, USART_MODE_TX);
+
+	while(DMA_Stream->CR & DMA_SxCR_EN)
 	{
 		// Check timeout
-		if((MISC_timeoutGetTick() - startTicks) > TIMEOUT)
+		if(MISC_timebaseIsExpired(deadline))
 		{
 			return STATUS_TIMEOUT;
 		}
 	}
 
-	// Get DMA stream
-	DMA_Stream_TypeDef* DMA_Stream = USART_getDmaStream(usart, USART_MODE_TX);
-
 	// Fill DMA registers
 	DMA_Stream->NDTR = size;					// Set data size
 	DMA_Stream->PAR = (uint32_t)&usart->DR;		// Set peripheral address
 	DMA_Stream->M0AR = (uint32_t)data;			// Set memory address
 
+	// A word is read from memory for every 4 bytes when the data allows it, the FIFO unpacks it
+	DMA_Stream->CR &= ~DMA_SxCR_MSIZE;
+	if((((uint32_t)data | size) & 0x03U) == 0U) DMA_Stream->CR |= DMA_MEMORY_SIZE_WORD;
+
 	// Clear interrupt flags
 	DMA_clearFlags(DMA_Stream, DMA_FLAG_ALL);
 
@@ -380,36 +520,14 @@ void USART_clearFlags(USART_TypeDef* usart, USH_USART_flags flags)
  */
 DMA_Stream_TypeDef* USART_getDmaStream(USART_TypeDef* usart, USH_USART_mode mode)
 {
-	DMA_Stream_TypeDef* DMA_Stream;
+	int8_t index = USART_getIndex(usart);
 
-	if(mode == USART_MODE_RX_TX) mode = USART_MODE_TX;
+	// Check parameters
+	assert_param(IS_USART_ALL_INSTANCE(usart));
 
-	if(usart == USART1)
-	{
-		DMA_Stream = (mode == USART_MODE_TX) ? DMA2_Stream7 : DMA2_Stream2;
-	} else if(usart == USART2)
-		   {
-		   	   DMA_Stream = (mode == USART_MODE_TX) ? DMA1_Stream6 : DMA1_Stream5;
-		   } else if(usart == USART3)
-		   	   	  {
-			   	  	  DMA_Stream = (mode == USART_MODE_TX) ? DMA1_Stream3 : DMA1_Stream1;
-		   	   	  } else if(usart == UART4)
-		   	   	  	  	 {
-		   	   		  	 	 DMA_Stream = (mode == USART_MODE_TX) ? DMA1_Stream4 : DMA1_Stream2;
-		   	   	  	  	 } else if(usart == UART5)
-		   	   	  	  	 	 	{
-		   	   	  	  		 		DMA_Stream = (mode == USART_MODE_TX) ? DMA1_Stream7 : DMA1_Stream0;
-		   	   	  	  	 	 	} else if(usart == USART6)
-		   	   	  	  	 	 		   {
-		   	   	  	  	 	 		   	   DMA_Stream = (mode == USART_MODE_TX) ? DMA2_Stream6 : DMA2_Stream1;
-		   	   	  	  	 	 		   } else if(usart == UART7)
-		   	   	  	  	 	 		   	   	  {
-		   	   	  	  	 	 			   	   	  DMA_Stream = (mode == USART_MODE_TX) ? DMA1_Stream1 : DMA1_Stream3;
-		   	   	  	  	 	 		   	   	  } else	// UART8
-		   	   	  	  	 	 		   	   	  {
-		   	   	  	  	 	 		   	   		  DMA_Stream = (mode == USART_MODE_TX) ? DMA1_Stream0 : DMA1_Stream6;
-		   	   	  	  	 	 		   	   	  }
-	return DMA_Stream;
+	if(index < 0) return NULL;
+
+	return (mode == USART_MODE_RX) ? usartHardware[index].rxStream : usartHardware[index].txStream;
 }
 
 /**
@@ -424,15 +542,23 @@ void USART_IRQHandler(USH_USART_initTypeDef *initStructure)
 	uint32_t CR1reg 	= initStructure->USARTx->CR1;
 	uint32_t CR3reg		= initStructure->USARTx->CR3;
 	uint32_t errors 	= (isrFlags & (uint32_t)(USART_SR_PE | USART_SR_FE | USART_SR_ORE | USART_SR_NE));
+	int8_t index		= USART_getIndex(initStructure->USARTx);
 
-	if(errors == RESET)
+	// The errors are counted whichever interrupt came, because clearing IDLE clears them too
+	if(errors != RESET)
 	{
-		// if RXNE call something
-	}
+		if(index >= 0)
+		{
+			if(errors & USART_SR_PE)	usartStates[index].errors.parity++;
+			if(errors & USART_SR_FE)	usartStates[index].errors.framing++;
+			if(errors & USART_SR_NE)	usartStates[index].errors.noise++;
+			if(errors & USART_SR_ORE)	usartStates[index].errors.overrun++;
+		}
 
-	if(errors != RESET && (initStructure->USARTx->CR3 & USART_CR3_EIE))
-	{
-		// Call ErrorCallBack
+		// SR has been read, reading DR clears the error flags. The symbol is already taken by DMA or lost.
+		USART_clearFlags(initStructure->USARTx, USART_FLAG_ORE);
+
+		USART_errorCallback(initStructure->USARTx, errors);
 	}
 
 	if((isrFlags & USART_SR_IDLE) && (CR1reg & USART_CR1_IDLEIE))
@@ -447,10 +573,179 @@ void USART_IRQHandler(USH_USART_initTypeDef *initStructure)
 	}
 }
 
+/**
+ * @brief 	This function returns the error counters of the U(S)ART.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval	A pointer to the error counters, NULL if the U(S)ART isn't supported.
+ */
+const USH_USART_errorsTypeDef* USART_getErrors(USART_TypeDef* usart)
+{
+	int8_t index = USART_getIndex(usart);
+
+	// Check parameters
+	assert_param(IS_USART_ALL_INSTANCE(usart));
+
+	return (index >= 0) ? &usartStates[index].errors : NULL;
+}
+
+/**
+ * @brief 	This function routes the U(S)ART global interrupt to the init structure of the instance.
+ * @note	It is called from the U(S)ART interrupt handlers in stm32f4xx_it.c.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval	None.
+ */
+void USART_instanceIRQHandler(USART_TypeDef* usart)
+{
+	int8_t index = USART_getIndex(usart);
+
+	if((index >= 0) && (usartStates[index].init != NULL)) USART_IRQHandler(usartStates[index].init);
+}
+
 //---------------------------------------------------------------------------
 // Static Functions
 //---------------------------------------------------------------------------
 
+/**
+ * @brief 	This function returns the index of the U(S)ART in the hardware table.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval	The index or -1 if the U(S)ART isn't found.
+ */
+static int8_t USART_getIndex(USART_TypeDef* usart)
+{
+	for(uint8_t index = 0; index < USART_COUNT; index++)
+	{
+		if(usartHardware[index].USARTx == usart) return (int8_t)index;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief 	This function enables the clock of the GPIO port and configures the U(S)ART pin.
+ * @param 	pin - A pointer to the pin description.
+ * @param 	alternate - The alternate function of the pin.
+ * @retval	None.
+ */
+static void USART_initPin(const USART_pinTypeDef *pin, USH_GPIO_alternate alternate)
+{
+	USH_GPIO_initTypeDef initGpioStructure = {0,};
+
+	if(pin->port == NULL) return;
+
+	// GPIO ports follow each other with the same step, as do their clock bits
+	RCC->AHB1ENR |= (1UL << (((uint32_t)pin->port - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE)));
+
+	initGpioStructure.GPIOx			= pin->port;
+	initGpioStructure.Pin			= pin->pin;
+	initGpioStructure.Mode			= GPIO_MODE_ALTERNATE_PP;
+	initGpioStructure.Pull			= GPIO_PULLUP;
+	initGpioStructure.Speed			= GPIO_SPEED_VERY_HIGH;
+	initGpioStructure.Alternate		= alternate;
+	GPIO_init(&initGpioStructure);
+}
+
+/**
+ * @brief 	This function claims the DMA streams which the U(S)ART needs in the mode.
+ * @note	If one of the streams is owned by another driver, none of them is claimed.
+ * @param 	hardware - A pointer to the hardware description of the U(S)ART.
+ * @param 	state - A pointer to the state of the U(S)ART, it is the context of the stream callbacks.
+ * @param 	mode - The mode of the U(S)ART. This parameter can be a value of @ref USH_USART_mode.
+ * @retval	The periphery status.
+ */
+static USH_peripheryStatus USART_claimDmaStreams(const USART_hardwareTypeDef *hardware, USART_stateTypeDef *state, USH_USART_mode mode)
+{
+	if((mode & USART_MODE_TX) && (DMA_claimStream(hardware->txStream, &usartTxCallbacks, state) != STATUS_OK))
+	{
+		return STATUS_BUSY;
+	}
+
+	if((mode & USART_MODE_RX) && (DMA_claimStream(hardware->rxStream, &usartRxCallbacks, state) != STATUS_OK))
+	{
+		if(mode & USART_MODE_TX) DMA_releaseStream(hardware->txStream, state);
+		return STATUS_BUSY;
+	}
+
+	return STATUS_OK;
+}
+
+/**
+ * @brief 	These functions route the DMA stream interrupts to the callbacks of the U(S)ART.
+ * @param 	DMAy_Streamx - A pointer to Stream peripheral to be used where y is 1 or 2 and x is from 0 to 7.
+ * @param 	context - A pointer to the state of the U(S)ART.
+ * @retval	None.
+ */
+static void USART_txCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	USART_stateTypeDef *state = (USART_stateTypeDef*)context;
+
+	(void)DMAy_Streamx;
+	if(state->init != NULL) USART_txCompleteCallback(state->init->USARTx);
+}
+
+static void USART_txErrorHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	USART_stateTypeDef *state = (USART_stateTypeDef*)context;
+
+	(void)DMAy_Streamx;
+	if(state->init != NULL) USART_txErrorCallback(state->init->USARTx);
+}
+
+static void USART_rxHalfCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	USART_stateTypeDef *state = (USART_stateTypeDef*)context;
+
+	(void)DMAy_Streamx;
+	if(state->init != NULL) USART_rxHalfCompleteCallback(state->init->USARTx);
+}
+
+static void USART_rxCompleteHandler(DMA_Stream_TypeDef *DMAy_Streamx, void *context)
+{
+	USART_stateTypeDef *state = (USART_stateTypeDef*)context;
+
+	(void)DMAy_Streamx;
+	if(state->init != NULL) USART_rxCompleteCallback(state->init->USARTx);
+}
+
+/**
+ * @brief 	This function configures the DMA stream of the U(S)ART.
+ * @param 	dmaStructure - A pointer to the DMA init structure of the stream.
+ * @param 	hardware - A pointer to the hardware description of the U(S)ART.
+ * @param 	mode - USART_MODE_TX or USART_MODE_RX.
+ * @retval	None.
+ */
+static void USART_initDmaStream(USH_DMA_initTypeDef *dmaStructure, const USART_hardwareTypeDef *hardware, USH_USART_mode mode)
+{
+	if(mode == USART_MODE_TX)
+	{
+		dmaStructure->DMAy_Streamx			= hardware->txStream;
+		dmaStructure->Direction				= DMA_MEMORY_TO_PERIPH;
+		dmaStructure->Mode					= DMA_NORMAL_MODE;
+		dmaStructure->Priority				= DMA_PRIORITY_LOW;
+
+		// The FIFO packs the bytes of the aligned requests, so memory is read by words (see USART_transmitDMA)
+		dmaStructure->FIFOMode				= DMA_FIFO_MODE_ENABLE;
+		dmaStructure->FIFOThreshold			= DMA_FIFO_THRESHOLD_HALF;
+	} else
+	{
+		dmaStructure->DMAy_Streamx			= hardware->rxStream;
+		dmaStructure->Direction				= DMA_PERIPH_TO_MEMORY;
+		dmaStructure->Mode					= DMA_CIRCULAR_MODE;
+		dmaStructure->Priority				= DMA_PRIORITY_HIGH;	// RX can't wait at high baud rates
+
+		// Every byte has to reach memory at once, the parser reads the buffer up to the position at IDLE
+		dmaStructure->FIFOMode				= DMA_FIFO_MODE_DISABLE;
+	}
+
+	dmaStructure->Channel 					= hardware->channel;
+	dmaStructure->PeriphInc 				= DMA_PINC_DISABLE;
+	dmaStructure->MemInc 			  		= DMA_MINC_ENABLE;
+	dmaStructure->PeriphDataAlignment 		= DMA_PERIPH_SIZE_BYTE;
+	dmaStructure->MemDataAlignment    		= DMA_MEMORY_SIZE_BYTE;
+	dmaStructure->MemBurst					= DMA_MBURST_SINGLE;
+	dmaStructure->PeriphBurst				= DMA_PBURST_SINGLE;
+	DMA_init(dmaStructure);
+}
+
 /**
  * @brief 	This function calculates BRR value.
  * @note	Most of the numbers are needed in order not to use float. 50 - for rounding.
@@ -469,7 +764,40 @@ static uint16_t USART_BRRSampling16(uint32_t pclk, uint32_t baudrate)
 	// get fraction
 	uint32_t fraction = (((usartDiv - (mantissa * 100U)) * 16U) + 50U) / 100U;
 
-	return ((uint16_t)(mantissa << 4U) | fraction);
+	// The rounded fraction can reach 16, the carry goes to the mantissa
+	return (uint16_t)((mantissa << 4U) + fraction);
+}
+
+/**
+ * @brief 	This function calculates BRR value for oversampling by 8.
+ * @note	The fraction has only 3 bits, BRR[3] has to be kept cleared.
+ * @param 	pclk - PCLK frequency.
+ * @param 	baudrate - The desired baudrate.
+ * @return	BRR value.
+ */
+static uint16_t USART_BRRSampling8(uint32_t pclk, uint32_t baudrate)
+{
+	// usartDiv in 1/8 units, rounded to the nearest
+	uint32_t usartDiv = (pclk + (baudrate / 2U)) / baudrate;
+
+	// get mantissa
+	uint32_t mantissa = usartDiv >> 3U;
+
+	// get fraction
+	uint32_t fraction = usartDiv & 0x07U;
+
+	return (uint16_t)((mantissa << 4U) | fraction);
+}
+
+/**
+ * @brief	This function returns PCLK frequency of the U(S)ART.
+ * @param 	usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+ * @retval	PCLK frequency.
+ */
+static uint32_t USART_getPCLKFreq(USART_TypeDef* usart)
+{
+	// USART1 and USART6 are on APB2, the rest are on APB1
+	return ((usart == USART1) || (usart == USART6)) ? USART_getPCLK2Freq() : USART_getPCLK1Freq();
 }
 
 /**
@@ -507,3 +835,65 @@ __WEAK void USART_idleCallback(USART_TypeDef* usart)
 {
 	(void)usart;
 }
+
+/**
+  * @brief  Error callbacks. It is called when parity, framing, noise or overrun error is detected.
+  * 		NOTE: This function should not be modified, when the callback is needed,
+           	   	  the USART_errorCallback could be implemented in the user file.
+  * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+  * @param  errors - The error flags of SR register (USART_SR_PE, USART_SR_FE, USART_SR_NE, USART_SR_ORE).
+  * @retval None.
+  */
+__WEAK void USART_errorCallback(USART_TypeDef* usart, uint32_t errors)
+{
+	(void)usart;
+	(void)errors;
+}
+
+/**
+  * @brief  TX transfer complete callbacks. It is called when DMA has passed all the data to the U(S)ART.
+  * 		NOTE: This function should not be modified, when the callback is needed,
+           	   	  the USART_txCompleteCallback could be implemented in the user file.
+  * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+  * @retval None.
+  */
+__WEAK void USART_txCompleteCallback(USART_TypeDef* usart)
+{
+	(void)usart;
+}
+
+/**
+  * @brief  TX transfer error callbacks.
+  * 		NOTE: This function should not be modified, when the callback is needed,
+           	   	  the USART_txErrorCallback could be implemented in the user file.
+  * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+  * @retval None.
+  */
+__WEAK void USART_txErrorCallback(USART_TypeDef* usart)
+{
+	(void)usart;
+}
+
+/**
+  * @brief  RX half transfer complete callbacks. It is called when DMA has filled the first half of the RX buffer.
+  * 		NOTE: This function should not be modified, when the callback is needed,
+           	   	  the USART_rxHalfCompleteCallback could be implemented in the user file.
+  * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+  * @retval None.
+  */
+__WEAK void USART_rxHalfCompleteCallback(USART_TypeDef* usart)
+{
+	(void)usart;
+}
+
+/**
+  * @brief  RX transfer complete callbacks. It is called when DMA has filled the RX buffer and wrapped around.
+  * 		NOTE: This function should not be modified, when the callback is needed,
+           	   	  the USART_rxCompleteCallback could be implemented in the user file.
+  * @param  usart - A pointer to U(S)ART peripheral to be used where x is between 1 to 8.
+  * @retval None.
+  */
+__WEAK void USART_rxCompleteCallback(USART_TypeDef* usart)
+{
+	(void)usart;
+}
@@ -30,7 +30,8 @@
 typedef enum
 {
 	STATUS_TIMEOUT		= 0,				/* Periphery status timeout */
-	STATUS_OK	 		= !STATUS_TIMEOUT	/* Periphery status ok */
+	STATUS_OK	 		= !STATUS_TIMEOUT,	/* Periphery status ok */
+	STATUS_BUSY			= 2					/* The resource is used by another driver */
 } USH_peripheryStatus;
 
 //---------------------------------------------------------------------------
@@ -41,6 +42,7 @@ typedef enum
 #include "ush_stm32f4xx_dma.h"
 #include "ush_stm32f4xx_spi.h"
 #include "ush_stm32f4xx_uart.h"
+#include "ush_stm32f4xx_crc.h"
 
 //---------------------------------------------------------------------------
 // Function's parameters check.
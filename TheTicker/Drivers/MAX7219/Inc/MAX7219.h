@@ -23,10 +23,14 @@
 //---------------------------------------------------------------------------
 // General parameters of the matrix
 //---------------------------------------------------------------------------
-#define MATRIX_DIGITS								((uint8_t)4)
+#define MATRIX_DIGITS								((uint8_t)4)		// Used when the chain length isn't detected
+#define MATRIX_MAX_DIGITS							((uint8_t)32)
 #define MATRIX_HIGH									((uint8_t)8)
 
-#define DELAY_TEST_MODE								((uint16_t)2000)
+// Chain length detection. It requires MISO to be connected to DOUT of the last module.
+// Comment out MATRIX_AUTODETECT to always use MATRIX_DIGITS.
+#define MATRIX_AUTODETECT
+#define MATRIX_PROBE_MARKER							((uint16_t)0xA05A)	// The address bits are 0 (no-op)
 
 #define MATRIX_SPI									(SPI1)
 #define MATRIX_CS_PORT								(GPIOA)
@@ -156,13 +160,30 @@ typedef enum
 void MAX7219_init(SPI_TypeDef* spi, USH_SPI_pinsPack pinsPack, USH_SPI_baudRatePrescaler prescaler);
 
 /**
- * @brief 	This function starts a test mode with a duration of delay (ms)
+ * @brief	This function detects the number of cascaded modules.
+ * @note	The marker is shifted into the chain and the number of 16-bit words is counted until the marker
+ * 			comes back on MISO from DOUT of the last module. The marker and the words around it have the no-op
+ * 			address, so nothing is written to the modules. If the marker isn't found, MATRIX_DIGITS is used.
+ * @retval	The number of detected modules or 0 if the marker isn't found.
+ */
+uint8_t MAX7219_detectChainLength(void);
+
+/**
+ * @brief	This function returns the number of cascaded modules which is used by the driver.
+ * @retval	The number of modules.
+ */
+uint8_t MAX7219_getDigits(void);
+
+/**
+ * @brief 	This function switches the display test mode without waiting.
+ * @note	It doesn't block the caller. The test mode has to be switched off by the second call
+ * 			with NORMAL_OPERATION.
  * @param 	numDigit - The digit indicates which digit of the matrix driver to transfer data to.
  * 					   This parameter can be any value of @ref USH_MAX7219_digits.
- * @param 	delay - The delay in ms.
+ * @param 	mode - The display test mode. This parameter can be any value of @ref USH_MAX7219_REG_DISPLAY_TEST.
  * @retval	None.
  */
-void MAX7219_testMode(USH_MAX7219_digits numDigit, uint16_t delay);
+void MAX7219_displayTest(USH_MAX7219_digits numDigit, USH_MAX7219_REG_DISPLAY_TEST mode);
 
 /**
  * @brief 	This function cleans matrix's digits.
@@ -230,4 +251,16 @@ void MAX7219_sendDataWithLatch(USH_MAX7219_digits numDigit, USH_MAX7219_register
   */
 void MAX7219_sendDataWithoutLatch(USH_MAX7219_digits numDigit, USH_MAX7219_registers reg, uint8_t data);
 
+/**
+  * @brief  This function starts sending the digit registers of all the modules through DMA.
+  * @note	Row r holds the words (register << 8 | data) for the digit register r + 1 of every module, the word of
+  * 		the farthest module first. The rows are sent one by one, every row is latched as soon as it has left
+  * 		the SPI and the next one is started from the interrupt. When the last row is latched, the signal is
+  * 		set to the calling thread. Without the DMA stream the rows are sent by polling before the function returns.
+  * @param	rows - The MATRIX_HIGH rows. They mustn't be changed until the signal is set.
+  * @param	signal - The signal flag of the calling thread.
+  * @retval None.
+  */
+void MAX7219_sendRowsDMA(const uint16_t rows[][MATRIX_MAX_DIGITS], int32_t signal);
+
 #endif /* __MAX7219_H */
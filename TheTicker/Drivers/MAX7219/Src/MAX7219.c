@@ -15,6 +15,15 @@
 #include "MAX7219.h"
 #include "cmsis_os.h"
 
+//---------------------------------------------------------------------------
+// Variables
+//---------------------------------------------------------------------------
+static uint8_t matrixDigits = MATRIX_DIGITS;
+static const uint16_t (*dmaRows)[MATRIX_MAX_DIGITS];	// The rows which are being sent through DMA
+static volatile uint8_t dmaRow;
+static osThreadId dmaThread;
+static int32_t dmaSignal;
+
 //---------------------------------------------------------------------------
 // Initialization functions
 //---------------------------------------------------------------------------
@@ -38,12 +47,15 @@ void MAX7219_init(SPI_TypeDef* spi, USH_SPI_pinsPack pinsPack, USH_SPI_baudRateP
 	initStructure.Mode 					= SPI_MODE_1;
 	SPI_init(&initStructure);
 
+#ifdef MATRIX_AUTODETECT
+	MAX7219_detectChainLength();
+#endif
+
 	MAX7219_state(ALL_DIGITS, NORMAL_MODE);
 	MAX7219_decodeMode(ALL_DIGITS, NO_DECODE_FOR_ALL);
 	MAX7219_intensity(ALL_DIGITS, INTENSITY_13_32);
 	MAX7219_scanLimit(ALL_DIGITS, SCAN_LIMIT_0_7);
 	MAX7219_clean(ALL_DIGITS);
-	MAX7219_testMode(ALL_DIGITS, DELAY_TEST_MODE);
 }
 
 //---------------------------------------------------------------------------
@@ -51,17 +63,65 @@ void MAX7219_init(SPI_TypeDef* spi, USH_SPI_pinsPack pinsPack, USH_SPI_baudRateP
 //---------------------------------------------------------------------------
 
 /**
- * @brief 	This function starts a test mode with a duration of delay (ms)
- * @param 	digit - The digit indicates which digit of the matrix driver to transfer data to.
- * 					This parameter can be any value of @ref USH_MAX7219_digits.
- * @param 	delay - The delay in ms.
+ * @brief	This function detects the number of cascaded modules.
+ * @note	The marker is shifted into the chain and the number of 16-bit words is counted until the marker
+ * 			comes back on MISO from DOUT of the last module. The marker and the words around it have the no-op
+ * 			address, so nothing is written to the modules. If the marker isn't found, MATRIX_DIGITS is used.
+ * @retval	The number of detected modules or 0 if the marker isn't found.
+ */
+uint8_t MAX7219_detectChainLength(void)
+{
+	uint8_t digits = 0;
+
+	SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, LOW);
+
+	// Flush the chain with no-op words
+	for(uint8_t word = 0; word < MATRIX_MAX_DIGITS; word++)
+	{
+		SPI_transmitReceiveData(MATRIX_SPI, REG_NO_OP);
+	}
+
+	// Every module delays data by one word, so the marker comes back after as many words as there are modules
+	SPI_transmitReceiveData(MATRIX_SPI, MATRIX_PROBE_MARKER);
+
+	for(uint8_t word = 1; word <= MATRIX_MAX_DIGITS; word++)
+	{
+		if(SPI_transmitReceiveData(MATRIX_SPI, REG_NO_OP) == MATRIX_PROBE_MARKER)
+		{
+			digits = word;
+			break;
+		}
+	}
+
+	// The chain is left filled with no-op words, so the latch doesn't change anything
+	SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, HIGH);
+
+	matrixDigits = (digits != 0) ? digits : MATRIX_DIGITS;
+
+	return digits;
+}
+
+/**
+ * @brief	This function returns the number of cascaded modules which is used by the driver.
+ * @retval	The number of modules.
+ */
+uint8_t MAX7219_getDigits(void)
+{
+	return matrixDigits;
+}
+
+/**
+ * @brief 	This function switches the display test mode without waiting.
+ * @note	It doesn't block the caller. The test mode has to be switched off by the second call
+ * 			with NORMAL_OPERATION.
+ * @param 	numDigit - The digit indicates which digit of the matrix driver to transfer data to.
+ * 					   This parameter can be any value of @ref USH_MAX7219_digits.
+ * @param 	mode - The display test mode. This parameter can be any value of @ref USH_MAX7219_REG_DISPLAY_TEST.
  * @retval	None.
  */
-void MAX7219_testMode(uint8_t numDigit, uint16_t delay)
+void MAX7219_displayTest(USH_MAX7219_digits numDigit, USH_MAX7219_REG_DISPLAY_TEST mode)
 {
-	MAX7219_sendDataWithLatch(numDigit, REG_DISPLAY_TEST, DISPLAY_TEST_MODE);
-	osDelay(delay);	// from FreeRTOS
-	MAX7219_sendDataWithLatch(numDigit, REG_DISPLAY_TEST, NORMAL_OPERATION);
+	MAX7219_sendDataWithLatch(numDigit, REG_DISPLAY_TEST, mode);
 }
 
 /**
@@ -155,11 +215,14 @@ void MAX7219_sendDataWithoutLatch(USH_MAX7219_digits numDigit, USH_MAX7219_regis
 {
 	uint8_t digitPos, pos, currentDigit, NoOp = 0;
 
-	for(digitPos = 0; digitPos < MATRIX_DIGITS; digitPos++)
+	for(digitPos = 0; digitPos < matrixDigits; digitPos++)
 	{
 		if(numDigit == ALL_DIGITS)
 		{
 			SPI_writeData(MATRIX_SPI, reg, data);
+		} else if(digitPos >= 8U)	// Only the first 8 digits can be selected separately
+		{
+			SPI_writeData(MATRIX_SPI, NoOp, NoOp);
 		} else
 		{
 			pos = (uint8_t)0x01 << digitPos;
@@ -175,3 +238,68 @@ void MAX7219_sendDataWithoutLatch(USH_MAX7219_digits numDigit, USH_MAX7219_regis
 		}
 	}
 }
+
+/**
+  * @brief  This function starts sending the digit registers of all the modules through DMA.
+  * @note	Row r holds the words (register << 8 | data) for the digit register r + 1 of every module, the word of
+  * 		the farthest module first. The rows are sent one by one, every row is latched as soon as it has left
+  * 		the SPI and the next one is started from the interrupt. When the last row is latched, the signal is
+  * 		set to the calling thread. Without the DMA stream the rows are sent by polling before the function returns.
+  * @param	rows - The MATRIX_HIGH rows. They mustn't be changed until the signal is set.
+  * @param	signal - The signal flag of the calling thread.
+  * @retval None.
+  */
+void MAX7219_sendRowsDMA(const uint16_t rows[][MATRIX_MAX_DIGITS], int32_t signal)
+{
+	dmaRows = rows;
+	dmaRow = 0;
+	dmaThread = osThreadGetId();
+	dmaSignal = signal;
+
+	SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, LOW);
+
+	if(SPI_transmitDMA(MATRIX_SPI, rows[0], matrixDigits) == STATUS_OK) return;
+
+	for(uint8_t row = 0; row < MATRIX_HIGH; row++)
+	{
+		SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, LOW);
+
+		for(uint8_t digit = 0; digit < matrixDigits; digit++)
+		{
+			SPI_transmitReceiveData(MATRIX_SPI, rows[row][digit]);
+		}
+
+		SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, HIGH);
+	}
+
+	osSignalSet(dmaThread, dmaSignal);
+}
+
+//---------------------------------------------------------------------------
+// Callbacks
+//---------------------------------------------------------------------------
+
+/**
+  * @brief  SPI TX transfer complete callback. The row is latched and the next one is started.
+  * @note	The MAX7219 chain is the only user of the SPI in this project. CS stays high for the time of two
+  * 		function calls, which is longer than the 50 ns the chip needs.
+  * @param  SPIx - A pointer to SPIx peripheral to be used where x is between 1 to 6.
+  * @retval None.
+  */
+void SPI_txCompleteCallback(SPI_TypeDef *SPIx)
+{
+	if(SPIx != MATRIX_SPI) return;
+
+	SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, HIGH);
+
+	if(++dmaRow < MATRIX_HIGH)
+	{
+		SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, LOW);
+		if(SPI_transmitDMA(MATRIX_SPI, dmaRows[dmaRow], matrixDigits) == STATUS_OK) return;
+
+		// The rest of the rows is lost, the thread mustn't wait for them
+		SPI_csPin(MATRIX_CS_PORT, MATRIX_CS_PIN, HIGH);
+	}
+
+	osSignalSet(dmaThread, dmaSignal);
+}
@@ -0,0 +1,103 @@
+"""The latency of the messages from the line to the matrix, see the latency regions in TheTicker/Core/Inc/profile.h.
+
+The display stamps a message at the RX event which brought its end, when the parser queues it, when it's copied
+into the text and when the first frame with its beginning is latched by the matrix. This script sends the synthetic
+price lines at the given rate and prints p50 and p99 of every stage in microseconds.
+
+The histograms have power of two buckets, so p50 and p99 are the upper bounds of their buckets, cut down to the
+longest run. A message replaced by the next one before a frame shows it has no display stamp, so the stages
+after the parser count fewer runs than were sent.
+
+    latency.py --port PORT [--messages N] [--rate PER_SECOND]
+"""
+
+import argparse
+import random
+import time
+
+import ticker
+
+STAGES = [("parse", ticker.REGION_LATENCY_PARSE), ("decode", ticker.REGION_LATENCY_DECODE),
+          ("display", ticker.REGION_LATENCY_DISPLAY), ("total", ticker.REGION_LATENCY_TOTAL)]
+
+SYMBOLS = ["EUR/USD", "GBP/USD", "USD/JPY", "BTC/USD", "NASDAQ", "DOW", "S&P 500", "Gold", "Oil"]
+SETTLE_TIME = 0.5           # s, the last message reaches the matrix at the next shift
+
+
+def price_line(generator):
+    """A ticker line of 2..5 prices, it fits into a request."""
+    line = ""
+
+    for symbol in generator.sample(SYMBOLS, generator.randint(2, 5)):
+        item = "%s %.4f %+.2f%%" % (symbol, generator.uniform(0.5, 40000.0), generator.uniform(-5.0, 5.0))
+        if len(line) + len(item) + 3 > ticker.PAYLOAD_MAX_SIZE:
+            break
+        line = (line + " | " + item) if line else item
+
+    return line.encode("latin-1")
+
+
+def load(device, count, rate, generator):
+    """Sends the messages at the rate, the ones without credits wait for them. Returns the number of waits."""
+    waits = 0
+    period = 1.0 / rate
+    deadline = time.monotonic()
+
+    for _ in range(count):
+        deadline += period
+        text = price_line(generator)
+
+        status, _ = device.set_message(text)
+        if status == ticker.STATUS_NO_CREDITS:
+            waits += 1
+            device.wait_credits()
+            status, _ = device.set_message(text)
+        if status != ticker.STATUS_OK:
+            raise ticker.ProtocolError("the message is rejected: %s" % ticker.STATUS_NAMES[status])
+
+        pause = deadline - time.monotonic()
+        if pause > 0:
+            time.sleep(pause)
+
+    return waits
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ticker.add_port_arguments(parser)
+    parser.add_argument("--messages", type=int, default=200, help="the number of messages to send")
+    parser.add_argument("--rate", type=float, default=20.0, help="the messages per second")
+    parser.add_argument("--seed", type=int, default=1, help="the seed of the price lines")
+    arguments = parser.parse_args()
+
+    if (arguments.messages < 1) or (arguments.rate <= 0):
+        parser.error("the messages and the rate have to be positive")
+
+    device = ticker.Ticker(arguments.port, arguments.baudrate)
+
+    try:
+        for _, region in STAGES:
+            device.query_profile(region, reset=True)
+
+        started = time.monotonic()
+        waits = load(device, arguments.messages, arguments.rate, random.Random(arguments.seed))
+        elapsed = time.monotonic() - started
+
+        device.wait_credits(ticker.MESSAGE_QUEUE_SIZE)
+        time.sleep(SETTLE_TIME)
+
+        print("%d messages in %.1f s, %d waited for credits" % (arguments.messages, elapsed, waits))
+        print("%-8s %6s %8s %8s %8s %8s" % ("stage", "runs", "min", "p50", "p99", "max"))
+
+        for name, region in STAGES:
+            statistics = device.query_profile(region)
+            print("%-8s %6d %8d %8d %8d %8d" % (name, statistics["count"], statistics["min"],
+                                               min(ticker.percentile(statistics["buckets"], 0.5), statistics["max"]),
+                                               min(ticker.percentile(statistics["buckets"], 0.99), statistics["max"]),
+                                               statistics["max"]))
+    finally:
+        device.close()
+
+
+if __name__ == "__main__":
+    main()
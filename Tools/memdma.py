@@ -0,0 +1,85 @@
+"""The benchmark of memdma, see TheTicker/Core/Inc/memdma.h.
+
+For every size the display copies or fills the block by CPU and by the DMA2 stream, PROTOCOL_CMD_BENCH_MEMDMA, and
+the memdma regions of the profile give the mean cycles of every part:
+
+    cpu         memcpy or memset of the block
+    start       the programming of the stream, paid by the thread
+    isr         the completion interrupt, paid by whatever thread it breaks into
+    transfer    from the start of the stream to the interrupt, the thread is free meanwhile
+
+The stream pays off when cpu > start + isr. The smallest size from which it does at every bigger size is printed
+against MEMDMA_CPU_THRESHOLD. The frame copies of the display use the same engine, so keep the sizes of the sweep
+apart from the frame size or stop the display by sending it frames.
+
+    memdma.py --port PORT [--runs N] [--sizes 16,32,...]
+"""
+
+import argparse
+
+import ticker
+
+CPU_THRESHOLD = 64          # MEMDMA_CPU_THRESHOLD
+BENCHMARK_MAX_SIZE = 1024   # MEMDMA_BENCHMARK_MAX_SIZE
+
+SIZES = [16, 32, 48, 64, 80, 96, 128, 192, 256, 512, 1024]
+REGIONS = [ticker.REGION_MEMDMA_CPU, ticker.REGION_MEMDMA_START, ticker.REGION_ISR_MEMDMA,
+           ticker.REGION_MEMDMA_TRANSFER]
+
+
+def measure(device, is_fill, size, runs):
+    """The mean cycles of the regions for the size."""
+    for region in REGIONS:
+        device.query_profile(region, reset=True)
+
+    device.bench_memdma(is_fill, size, runs)
+
+    return [device.query_profile(region)["mean"] for region in REGIONS]
+
+
+def sweep(device, is_fill, sizes, runs):
+    """Prints the table of the operation and returns the smallest size the stream pays off from."""
+    crossover = None
+
+    print("%-4s %6s %8s %8s %8s %8s %8s" % ("fill" if is_fill else "copy", "size", "cpu", "start", "isr",
+                                            "transfer", "saved"))
+
+    for size in sizes:
+        cpu, start, isr, transfer = measure(device, is_fill, size, runs)
+        saved = cpu - (start + isr)
+
+        if saved <= 0:
+            crossover = None
+        elif crossover is None:
+            crossover = size
+
+        print("%-4s %6d %8d %8d %8d %8d %8d" % ("", size, cpu, start, isr, transfer, saved))
+
+    return crossover
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ticker.add_port_arguments(parser)
+    parser.add_argument("--runs", type=int, default=32, help="the runs of every path at every size, 1..255")
+    parser.add_argument("--sizes", help="the sizes in bytes separated with commas, up to %d" % BENCHMARK_MAX_SIZE)
+    arguments = parser.parse_args()
+
+    sizes = [int(size) for size in arguments.sizes.split(",")] if arguments.sizes else SIZES
+    if not (1 <= arguments.runs <= 255) or any(not (1 <= size <= BENCHMARK_MAX_SIZE) for size in sizes):
+        parser.error("the runs or the sizes are out of range")
+
+    device = ticker.Ticker(arguments.port, arguments.baudrate, timeout=5.0)
+
+    try:
+        for is_fill in (False, True):
+            crossover = sweep(device, is_fill, sorted(sizes), arguments.runs)
+            print("%s: the stream pays off from %s bytes, MEMDMA_CPU_THRESHOLD is %d" %
+                  ("fill" if is_fill else "copy", crossover if crossover else "none of the", CPU_THRESHOLD))
+            print()
+    finally:
+        device.close()
+
+
+if __name__ == "__main__":
+    main()
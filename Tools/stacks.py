@@ -0,0 +1,88 @@
+"""The stack sizes of the threads from their high-water marks, see TheTicker/Core/Inc/monitor.h.
+
+Run the display through all its features first (the text, the packed text, the frames, the compositing, the
+queries), then PROTOCOL_CMD_QUERY_STACKS gives the smallest number of free words every thread has had. The sizes
+are read from the osThreadDef calls of the firmware and from configMINIMAL_STACK_SIZE for IDLE. The recommended
+size is the size - the free words + MONITOR_STACK_MARGIN, rounded up to STACK_ROUNDING words.
+
+    stacks.py --port PORT [--source DIR]
+"""
+
+import argparse
+import glob
+import os
+import re
+
+import ticker
+
+NAME_SIZE = 8               # TASK_NAME_SIZE of protocol.c, the names in the reply are cut
+STACK_ROUNDING = 8          # words
+SOURCE = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "TheTicker", "Core")
+
+THREAD_DEF = re.compile(r"osThreadDef\(\s*(\w+)\s*,\s*\w+\s*,\s*\w+\s*,\s*\w+\s*,\s*(\w+)\s*\)")
+MINIMAL_STACK = re.compile(r"#define\s+configMINIMAL_STACK_SIZE\s+\(\s*\(uint16_t\)\s*(\d+)\s*\)")
+
+
+def read_sizes(source):
+    """The name of every thread, cut as in the reply, and its size in words with the place it's set at."""
+    sizes = {}
+
+    for path in sorted(glob.glob(os.path.join(source, "Src", "*.c"))):
+        with open(path) as file:
+            for number, line in enumerate(file, 1):
+                match = THREAD_DEF.search(line)
+                if match and match.group(2).isdigit():
+                    sizes[match.group(1)[:NAME_SIZE]] = (int(match.group(2)), "%s:%d" % (os.path.basename(path), number))
+
+    with open(os.path.join(source, "Inc", "FreeRTOSConfig.h")) as file:
+        for number, line in enumerate(file, 1):
+            match = MINIMAL_STACK.search(line)
+            if match:
+                sizes["IDLE"] = (int(match.group(1)), "FreeRTOSConfig.h:%d" % number)
+
+    return sizes
+
+
+def recommend(size, free, margin):
+    used = size - free
+
+    return -(-(used + margin) // STACK_ROUNDING) * STACK_ROUNDING
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ticker.add_port_arguments(parser)
+    parser.add_argument("--source", default=SOURCE, help="the Core directory of the firmware")
+    arguments = parser.parse_args()
+
+    sizes = read_sizes(arguments.source)
+    device = ticker.Ticker(arguments.port, arguments.baudrate)
+
+    try:
+        margin, threads = device.query_stacks()
+    finally:
+        device.close()
+
+    if not threads:
+        raise ticker.ProtocolError("no threads, MONITOR_MAX_TASKS is less than the number of the threads")
+
+    saved = 0
+    print("%-8s %-22s %6s %6s %6s %12s" % ("thread", "defined at", "size", "used", "free", "recommended"))
+
+    for number, free, name in sorted(threads):
+        if name not in sizes:
+            print("%-8s %-22s %6s %6s %6d %12s" % (name, "?", "?", "?", free, "?"))
+            continue
+
+        size, place = sizes[name]
+        best = recommend(size, free, margin)
+        saved += size - best
+        print("%-8s %-22s %6d %6d %6d %12d%s" % (name, place, size, size - free, free, best,
+                                                "  overflowed?" if free == 0 else ""))
+
+    print("%d words (%d bytes) %s with the margin of %d words" % (abs(saved), 4 * abs(saved),
+                                                                  "saved" if saved >= 0 else "more", margin))
+
+
+if __name__ == "__main__":
+    main()
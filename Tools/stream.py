@@ -0,0 +1,120 @@
+"""The streaming test of the U(S)ART at a high baud rate, see SET_BAUDRATE in TheTicker/Core/Inc/protocol.h.
+
+The display is switched to the baud rate (2 Mbaud by default) and the line is kept busy for the given time: the
+whole frames go back to back with WINDOW requests on the way, a text message goes between the windows when the
+display has credits. Then the counters of the display are compared with the ones before the run:
+
+    - no overrun, parity, framing or noise error of the U(S)ART (PROTOCOL_CMD_QUERY_ERRORS)
+    - no dropped line, frame or message and no overwritten message (PROTOCOL_CMD_QUERY_STATS)
+    - every request sent is counted as a received frame, every reply is OK
+
+The display goes back to the starting baud rate at the end. The exit code is 0 if all the checks pass.
+
+    stream.py --port PORT [--baudrate NOW] [--target BAUD] [--duration SECONDS]
+"""
+
+import argparse
+import random
+import sys
+import time
+
+import ticker
+
+MATRIX_HIGH = 8             # The bytes of a module in a frame
+FRAME_HEADER_SIZE = 2       # The flags and the first module
+FRAME_PRESENT = 0x01
+WINDOW = 8                  # The requests on the way, the replies fill the TX queue of the display (8) no further
+
+LOST_STATS = ["dropped_lines", "dropped_frames", "dropped_messages", "rejected_messages", "overwritten_messages"]
+
+
+def frame_payload(generator, modules):
+    """A whole frame, the zeros in it make COBS work too."""
+    data = bytes(generator.choice((0x00, 0xFF, generator.randrange(256))) for _ in range(modules * MATRIX_HIGH))
+
+    return bytes([FRAME_PRESENT, 0]) + data
+
+
+def stream(device, duration, modules, generator):
+    """Keeps the line busy for the duration. Returns the bytes sent, the requests and the failed replies."""
+    size = 0
+    requests = 0
+    failures = 0
+    deadline = time.monotonic() + duration
+    credits = 0
+
+    while time.monotonic() < deadline:
+        for _ in range(WINDOW):
+            payload = frame_payload(generator, modules)
+            device.send(ticker.CMD_SET_FRAME, payload)
+            size += len(ticker.build_frame(ticker.CMD_SET_FRAME, payload))
+
+        for _ in range(WINDOW):
+            status, _ = device.receive(ticker.CMD_SET_FRAME)
+            failures += status != ticker.STATUS_OK
+        requests += WINDOW
+
+        # The text is put only when it can be taken, so none is rejected
+        if credits == 0:
+            credits = device.query_credits()
+            requests += 1
+        if credits != 0:
+            text = ("Stream %d bytes" % size).encode("latin-1")
+            status, credits = device.set_message(text)
+            size += len(ticker.build_frame(ticker.CMD_SET_MESSAGE, text))
+            failures += status != ticker.STATUS_OK
+            requests += 1
+
+    return size, requests, failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ticker.add_port_arguments(parser)
+    parser.add_argument("--target", type=int, default=2000000, help="the baud rate of the test")
+    parser.add_argument("--duration", type=float, default=30.0, help="the seconds of streaming")
+    parser.add_argument("--seed", type=int, default=1, help="the seed of the frames")
+    arguments = parser.parse_args()
+
+    device = ticker.Ticker(arguments.port, arguments.baudrate)
+    checks = []
+
+    try:
+        device.set_baudrate(arguments.target)
+        modules = min(device.query_version()[2], (ticker.PAYLOAD_MAX_SIZE - FRAME_HEADER_SIZE) // MATRIX_HIGH)
+
+        errors = device.query_errors()
+        stats = device.query_stats()
+        first = device.sent         # The query of the stats is counted after its reply
+
+        started = time.monotonic()
+        size, requests, failures = stream(device, arguments.duration, modules, random.Random(arguments.seed))
+        elapsed = time.monotonic() - started
+
+        errors = {name: count - errors[name] for name, count in device.query_errors().items()}
+        last = device.sent
+        stats = {name: count - stats[name] for name, count in device.query_stats().items()}
+
+        print("%d bytes in %.1f s at %d baud, %.0f%% of the line, %d requests" %
+              (size, elapsed, arguments.target, 100.0 * size * 10 / (elapsed * arguments.target), requests))
+        print("errors: " + ", ".join("%s %d" % (name, errors[name]) for name in ticker.ERRORS_NAMES))
+        print("stats:  " + ", ".join("%s %d" % (name, stats[name]) for name in ticker.STATS_NAMES))
+
+        checks.append(("no U(S)ART error", not any(errors.values())))
+        checks.append(("nothing lost on the display", not any(stats[name] for name in LOST_STATS)))
+        checks.append(("every request received", stats["received_frames"] == last - first + 1))
+        checks.append(("every reply OK", failures == 0))
+    finally:
+        try:
+            device.set_baudrate(arguments.baudrate)
+        finally:
+            device.close()
+
+    for name, passed in checks:
+        print("%-28s %s" % (name, "PASS" if passed else "FAIL"))
+
+    sys.exit(0 if checks and all(passed for _, passed in checks) else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,257 @@
+"""The encoder of the packed text, see TheTicker/Core/Inc/textcodec.h.
+
+    code        meaning
+    0x00-0x7F   the symbol itself
+    0x80-0xBF   the entry of the dictionary
+    0xC0-0xFF   the copy of (code - 0xC0 + 3) symbols, the next byte is the distance - 1
+
+The encoder finds the shortest stream of codes for the text: every position is reached by the cheapest of the
+symbol, the dictionary entries which start there and the copies of 3..66 symbols from up to 256 back. The codes are
+packed into requests of PROTOCOL_CMD_SET_MESSAGE_PACKED, a code never crosses the end of a request.
+
+    textcodec.py --bench [FILE]                 the wire bytes of every line of the playlist, plain and packed
+    textcodec.py --port PORT --bench [FILE]     the same, then the lines are shown and PROFILE_REGION_CONVERT
+                                                gives the decoding cycles per byte against the plain copy
+    textcodec.py --port PORT TEXT               shows the packed text
+    textcodec.py --vectors FILE                 the C header for the round-trip test, see Tests/Src/test_textcodec.c
+"""
+
+import argparse
+import os
+import sys
+
+import ticker
+
+#---------------------------------------------------------------------------
+# The format
+#---------------------------------------------------------------------------
+
+# The same table as in textcodec.c, in the same order
+DICTIONARY = [
+    b" USD", b" EUR", b" GBP", b" JPY", b" CHF", b" CNY", b" BTC", b" ETH",
+    b"USD/", b"EUR/", b"GBP/", b"BTC/", b" +", b" -", b"% ", b".00",
+    b"0.", b".5", b", ", b" | ", b" >> ", b" << ", b" ^ ", b" v ",
+    b"NASDAQ ", b"DOW ", b"S&P 500 ", b"FTSE ", b"DAX ", b"NIKKEI ", b"Oil ", b"Gold ",
+    b"Bid ", b"Ask ", b"Open ", b"Close ", b"High ", b"Low ", b"Vol ", b"Change ",
+    b"News: ", b"Weather: ", b" the ", b" and ", b" up ", b" down ", b"    ", b"000",
+]
+
+DICTIONARY_BASE = 0x80
+COPY_BASE = 0xC0
+COPY_MIN_SIZE = 3
+COPY_MAX_SIZE = 0xFF - COPY_BASE + COPY_MIN_SIZE
+COPY_MAX_DISTANCE = 256
+
+REQUEST_MAX_SIZE = ticker.PAYLOAD_MAX_SIZE - 1      # - the flags
+TEXT_SIZE = 4096                                    # The text of LedMatrix.c, the rest is cut off
+
+PLAYLIST = os.path.join(os.path.dirname(os.path.abspath(__file__)), "playlist.txt")
+
+
+def encode(text):
+    """The list of the codes (bytes) of the text."""
+    size = len(text)
+    cost = [0] * (size + 1)
+    choice = [None] * (size + 1)
+
+    for position in range(size - 1, -1, -1):
+        best = None
+
+        if text[position] < DICTIONARY_BASE:
+            best = (1 + cost[position + 1], bytes([text[position]]), 1)
+
+        for entry, word in enumerate(DICTIONARY):
+            if text.startswith(word, position):
+                option = (1 + cost[position + len(word)], bytes([DICTIONARY_BASE + entry]), len(word))
+                if (best is None) or (option[0] < best[0]):
+                    best = option
+
+        # The longest copy for every distance, the copy can overlap the symbols it produces
+        longest = {}
+        for distance in range(1, min(COPY_MAX_DISTANCE, position) + 1):
+            length = 0
+            while (length < COPY_MAX_SIZE) and (position + length < size) and \
+                    (text[position + length] == text[position + length - distance]):
+                length += 1
+            for fit in range(COPY_MIN_SIZE, length + 1):
+                longest.setdefault(fit, distance)
+
+        for length, distance in longest.items():
+            option = (2 + cost[position + length], bytes([COPY_BASE + length - COPY_MIN_SIZE, distance - 1]), length)
+            if (best is None) or (option[0] < best[0]):
+                best = option
+
+        if best is None:
+            raise ValueError("the symbol 0x%02X at %d can't be packed" % (text[position], position))
+
+        cost[position], choice[position] = best[0], best
+
+    codes = []
+    position = 0
+    while position < size:
+        codes.append(choice[position][1])
+        position += choice[position][2]
+
+    return codes
+
+
+def pack(text):
+    """The payloads of the requests which show the text: the flags and the codes."""
+    codes = encode(text[:TEXT_SIZE])
+    requests = []
+    request = bytearray()
+
+    for code in codes:
+        if len(request) + len(code) > REQUEST_MAX_SIZE:
+            requests.append(request)
+            request = bytearray()
+        request += code
+
+    requests.append(request)
+
+    return [bytes([ticker.TEXT_MORE if index < len(requests) - 1 else 0]) + bytes(codes)
+            for index, codes in enumerate(requests)]
+
+
+def decode(requests):
+    """The text of the requests, the way textcodec.c decodes them."""
+    text = bytearray()
+
+    for request in requests:
+        codes = request[1:]
+        index = 0
+        while index < len(codes):
+            code = codes[index]
+            index += 1
+            if code < DICTIONARY_BASE:
+                text.append(code)
+            elif code < COPY_BASE:
+                if code - DICTIONARY_BASE < len(DICTIONARY):
+                    text += DICTIONARY[code - DICTIONARY_BASE]
+            elif index < len(codes):
+                distance = codes[index] + 1
+                index += 1
+                if distance <= len(text):
+                    for _ in range(code - COPY_BASE + COPY_MIN_SIZE):
+                        text.append(text[-distance])
+
+    return bytes(text)
+
+
+def wire_size(command_payloads):
+    """The bytes on the line: the delimiters, COBS, the command and CRC of every request."""
+    return sum(len(ticker.build_frame(command, payload)) for command, payload in command_payloads)
+
+
+def read_playlist(path):
+    with open(path, "rb") as playlist:
+        return [line.rstrip(b"\r\n") for line in playlist if line.strip()]
+
+
+#---------------------------------------------------------------------------
+# The commands
+#---------------------------------------------------------------------------
+def write_vectors(path, output):
+    """The C header: every line of the file, its packed requests and the text they give."""
+    output.write("/* Generated by Tools/textcodec.py --vectors, don't edit. */\n\n")
+    output.write("#define TEXTCODEC_VECTOR_COUNT\t(%dU)\n\n" % len(read_playlist(path)))
+    output.write("static const TEXTCODEC_vectorTypeDef vectors[TEXTCODEC_VECTOR_COUNT] =\n{\n")
+
+    for line in read_playlist(path):
+        requests = pack(line)
+        if decode(requests) != line[:TEXT_SIZE]:
+            raise ValueError("the encoder and the decoder don't agree on %r" % line)
+
+        output.write("\t{\n\t\t\"%s\", %d,\n\t\t{\n" % ("".join("\\x%02x" % byte for byte in line), len(line)))
+        for request in requests:
+            output.write("\t\t\t{\"%s\", %d},\n" % ("".join("\\x%02x" % byte for byte in request), len(request)))
+        output.write("\t\t}, %d\n\t},\n" % len(requests))
+
+    output.write("};\n")
+
+
+def bench(path, device):
+    lines = read_playlist(path)
+    plain_total = 0
+    packed_total = 0
+
+    print("%6s %6s %6s  line" % ("plain", "packed", "saved"))
+
+    for line in lines:
+        plain = wire_size([(ticker.CMD_SET_MESSAGE, line[index:index + ticker.PAYLOAD_MAX_SIZE])
+                           for index in range(0, len(line), ticker.PAYLOAD_MAX_SIZE)])
+        packed = wire_size([(ticker.CMD_SET_MESSAGE_PACKED, request) for request in pack(line)])
+        plain_total += plain
+        packed_total += packed
+        print("%6d %6d %5d%%  %s" % (plain, packed, 100 - (100 * packed) // plain, line[:48].decode("latin-1")))
+
+    print("%6d %6d %5d%%  total" % (plain_total, packed_total, 100 - (100 * packed_total) // plain_total))
+
+    if device is None:
+        return
+
+    # The plain lines are a single request, so the copy runs once per line as the decoding does
+    plain_lines = [line for line in lines if len(line) <= ticker.PAYLOAD_MAX_SIZE]
+    print()
+    print("%-8s %6s %8s %8s %8s %10s" % ("", "runs", "mean", "p50", "p99", "cycles/B"))
+    measure(device, "plain", [[line] for line in plain_lines], ticker.CMD_SET_MESSAGE)
+    measure(device, "packed", [pack(line) for line in lines], ticker.CMD_SET_MESSAGE_PACKED)
+
+
+def measure(device, name, messages, command):
+    """Shows the messages and prints the cycles of PROFILE_REGION_CONVERT per byte of the requests."""
+    size = 0
+
+    device.query_profile(ticker.REGION_CONVERT, reset=True)
+
+    for requests in messages:
+        for request in requests:
+            device.wait_credits()
+            status, _ = (device.set_message(request) if command == ticker.CMD_SET_MESSAGE
+                         else device.set_message_packed(request))
+            if status != ticker.STATUS_OK:
+                raise ticker.ProtocolError("the message is rejected: %s" % ticker.STATUS_NAMES[status])
+            size += len(request) - (1 if command == ticker.CMD_SET_MESSAGE_PACKED else 0)
+
+    # The display takes the last message from the queue
+    device.wait_credits(ticker.MESSAGE_QUEUE_SIZE)
+    statistics = device.query_profile(ticker.REGION_CONVERT)
+    cycles = statistics["mean"] * statistics["count"]
+
+    print("%-8s %6d %8d %8d %8d %10.1f" % (name, statistics["count"], statistics["mean"],
+                                          ticker.percentile(statistics["buckets"], 0.5),
+                                          ticker.percentile(statistics["buckets"], 0.99),
+                                          cycles / size if size else 0.0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", help="the serial port of the display")
+    parser.add_argument("--baudrate", type=int, default=115200, help="the baud rate the display works at now")
+    parser.add_argument("--bench", nargs="?", const=PLAYLIST, metavar="FILE", help="the playlist, a message a line")
+    parser.add_argument("--vectors", metavar="FILE", help="write the round-trip vectors of the playlist")
+    parser.add_argument("text", nargs="?", help="the text to be shown")
+    arguments = parser.parse_args()
+
+    if arguments.vectors:
+        write_vectors(arguments.vectors, sys.stdout)
+        return
+
+    device = ticker.Ticker(arguments.port, arguments.baudrate) if arguments.port else None
+
+    try:
+        if arguments.bench:
+            bench(arguments.bench, device)
+        elif arguments.text and device:
+            for request in pack(arguments.text.encode("latin-1")):
+                device.wait_credits()
+                device.set_message_packed(request)
+        else:
+            parser.error("--bench, --vectors or --port with the text")
+    finally:
+        if device:
+            device.close()
+
+
+if __name__ == "__main__":
+    main()
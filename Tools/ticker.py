@@ -0,0 +1,358 @@
+"""The host side of the binary protocol of TheTicker, see TheTicker/Core/Inc/protocol.h.
+
+Every request is the command, the payload and CRC-32/MPEG-2 of both (MSB first), COBS encoded and put between two
+0x00 delimiters. The reply is the command | 0x80, the status and the payload. The text lines which the firmware
+prints on the same line (the log, the boot report) are skipped while a reply is awaited.
+
+The port is opened with RTS/CTS, the firmware drives RTS when its RX buffer can't take more. pyserial is needed
+only to open the port.
+"""
+
+import struct
+import time
+
+#---------------------------------------------------------------------------
+# The numbers of protocol.h and profile.h
+#---------------------------------------------------------------------------
+CMD_SET_MESSAGE = 0x01
+CMD_SET_SPEED = 0x02
+CMD_SET_INTENSITY = 0x03
+CMD_QUERY_STATS = 0x04
+CMD_QUERY_VERSION = 0x05
+CMD_QUERY_BOOT = 0x06
+CMD_SET_BAUDRATE = 0x07
+CMD_QUERY_CREDITS = 0x08
+CMD_QUERY_ERRORS = 0x09
+CMD_SET_FRAME = 0x0A
+CMD_SET_FRAME_DELTA = 0x0B
+CMD_SET_MESSAGE_PACKED = 0x0C
+CMD_FILL_FRAME = 0x0D
+CMD_COPY_FRAME = 0x0E
+CMD_BLEND_FRAME = 0x0F
+CMD_QUERY_PROFILE = 0x10
+CMD_QUERY_TASKS = 0x11
+CMD_QUERY_STACKS = 0x12
+CMD_QUERY_HEAP = 0x13
+CMD_QUERY_HEAP_TAGS = 0x14
+CMD_BENCH_MEMDMA = 0x15
+
+STATUS_OK = 0
+STATUS_UNKNOWN_COMMAND = 1
+STATUS_WRONG_SIZE = 2
+STATUS_WRONG_VALUE = 3
+STATUS_NO_CREDITS = 4
+STATUS_FAILED = 5
+
+STATUS_NAMES = ["OK", "UNKNOWN_COMMAND", "WRONG_SIZE", "WRONG_VALUE", "NO_CREDITS", "FAILED"]
+
+STATS_NAMES = ["dropped_lines", "received_frames", "dropped_frames", "dropped_messages", "rejected_messages",
+               "overwritten_messages"]
+ERRORS_NAMES = ["parity", "framing", "noise", "overrun"]
+
+PAYLOAD_MAX_SIZE = 128
+MESSAGE_QUEUE_SIZE = 4          # UART_MESSAGE_QUEUE_SIZE, the credits of the idle display
+FRAME_DELIMITER = 0x00
+REPLY_FLAG = 0x80
+TEXT_MORE = 0x01
+PROFILE_RESET = 0x01
+
+REGION_OUTPUT = 0
+REGION_SHIFT = 1
+REGION_CONVERT = 2
+REGION_CAPTURE = 3
+REGION_ISR_USART = 4
+REGION_ISR_USART_DMA = 5
+REGION_ISR_SPI_DMA = 6
+REGION_LATENCY_PARSE = 7
+REGION_LATENCY_DECODE = 8
+REGION_LATENCY_DISPLAY = 9
+REGION_LATENCY_TOTAL = 10
+REGION_MEMDMA_CPU = 11
+REGION_MEMDMA_START = 12
+REGION_MEMDMA_TRANSFER = 13
+REGION_ISR_MEMDMA = 14
+
+
+class ProtocolError(Exception):
+    """The reply didn't come or the command failed."""
+
+
+#---------------------------------------------------------------------------
+# Framing
+#---------------------------------------------------------------------------
+def crc32_mpeg2(data):
+    """CRC-32/MPEG-2, the one the CRC unit of STM32F4 calculates over the bytes."""
+    crc = 0xFFFFFFFF
+
+    for byte in data:
+        crc ^= byte << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x04C11DB7) if (crc & 0x80000000) else (crc << 1)
+            crc &= 0xFFFFFFFF
+
+    return crc
+
+
+def cobs_encode(data):
+    encoded = bytearray([0])
+    code_index = 0
+
+    for byte in data:
+        if byte != 0:
+            encoded.append(byte)
+        if (byte == 0) or (len(encoded) - code_index == 0xFF):
+            encoded[code_index] = len(encoded) - code_index
+            code_index = len(encoded)
+            encoded.append(0)
+
+    encoded[code_index] = len(encoded) - code_index
+
+    return bytes(encoded)
+
+
+def cobs_decode(data):
+    decoded = bytearray()
+    index = 0
+
+    while index < len(data):
+        code = data[index]
+        if (code == 0) or (index + code > len(data)):
+            raise ProtocolError("broken COBS frame")
+
+        decoded += data[index + 1:index + code]
+        index += code
+
+        # The zero is implied after every block except the full one and the last one
+        if (code != 0xFF) and (index < len(data)):
+            decoded.append(0)
+
+    return bytes(decoded)
+
+
+def build_frame(command, payload=b""):
+    """The request with the delimiters, ready for the line."""
+    body = bytes([command]) + bytes(payload)
+
+    return bytes([FRAME_DELIMITER]) + cobs_encode(body + struct.pack(">I", crc32_mpeg2(body))) + \
+        bytes([FRAME_DELIMITER])
+
+
+def parse_frame(encoded):
+    """The command, the status and the payload of the reply, None if the frame is broken."""
+    try:
+        frame = cobs_decode(encoded)
+    except ProtocolError:
+        return None
+
+    if (len(frame) < 6) or (crc32_mpeg2(frame[:-4]) != struct.unpack(">I", frame[-4:])[0]):
+        return None
+
+    return frame[0], frame[1], frame[2:-4]
+
+
+#---------------------------------------------------------------------------
+# Histograms
+#---------------------------------------------------------------------------
+def percentile(buckets, share):
+    """The upper bound of the bucket which holds the share (0..1) of the runs.
+
+    Bucket 0 counts the runs of 0 cycles, bucket k the runs of 2^(k-1)..2^k - 1, see PROFILE_record.
+    """
+    total = sum(buckets)
+    if total == 0:
+        return 0
+
+    runs = 0
+    for bucket, count in enumerate(buckets):
+        runs += count
+        if runs >= share * total:
+            return (1 << bucket) - 1 if bucket else 0
+
+    return (1 << (len(buckets) - 1)) - 1
+
+
+#---------------------------------------------------------------------------
+# The device
+#---------------------------------------------------------------------------
+class Ticker:
+    """The link to the display.
+
+    The replies come in the order of the requests. The frames of other commands and the text between the frames
+    are dropped while the reply is awaited.
+    """
+
+    def __init__(self, port, baudrate=115200, timeout=1.0):
+        import serial
+
+        self.serial = serial.Serial(port, baudrate, timeout=0.05, rtscts=True)
+        self.timeout = timeout
+        self.pending = bytearray()      # The bytes read from the port, but not parsed yet
+        self.received = bytearray()     # The frame being received
+        self.is_frame = False
+        self.sent = 0                   # The requests sent since the port was opened
+
+        self.flush_input()
+
+    def close(self):
+        self.serial.close()
+
+    def send(self, command, payload=b""):
+        self.serial.write(build_frame(command, payload))
+        self.sent += 1
+
+    def flush_input(self):
+        """Drops everything received, the bytes at the old baud rate are garbage at the new one."""
+        self.serial.reset_input_buffer()
+        self.pending.clear()
+        self.received.clear()
+        self.is_frame = False
+
+    def receive(self, command, timeout=None):
+        """Waits for the reply to the command, returns its status and payload."""
+        deadline = time.monotonic() + (self.timeout if timeout is None else timeout)
+
+        while True:
+            for index, byte in enumerate(self.pending):
+                if byte != FRAME_DELIMITER:
+                    if self.is_frame:
+                        self.received.append(byte)
+                    continue
+
+                # A delimiter opens the frame or closes it, the repeated ones are skipped
+                if not self.is_frame or not self.received:
+                    self.is_frame = True
+                    continue
+
+                reply = parse_frame(bytes(self.received))
+                self.received.clear()
+                self.is_frame = False
+
+                if reply and (reply[0] == (command | REPLY_FLAG)):
+                    del self.pending[:index + 1]
+                    return reply[1], reply[2]
+
+            self.pending.clear()
+
+            if time.monotonic() > deadline:
+                raise ProtocolError("no reply to the command 0x%02X" % command)
+
+            self.pending += self.serial.read(max(1, self.serial.in_waiting))
+
+    def request(self, command, payload=b"", check=True):
+        self.send(command, payload)
+        status, reply = self.receive(command)
+
+        if check and (status != STATUS_OK):
+            raise ProtocolError("the command 0x%02X failed: %s" % (command, STATUS_NAMES[status]))
+
+        return status, reply
+
+    def set_message(self, text):
+        """Shows the text, returns the status and the credits left."""
+        status, reply = self.request(CMD_SET_MESSAGE, text, check=False)
+
+        return status, reply[0]
+
+    def set_message_packed(self, payload):
+        """Sends the request of the packed text, see textcodec.py. Returns the status and the credits left."""
+        status, reply = self.request(CMD_SET_MESSAGE_PACKED, payload, check=False)
+
+        return status, reply[0]
+
+    def query_version(self):
+        """The major and minor version of the protocol and the number of modules in the chain."""
+        return tuple(self.request(CMD_QUERY_VERSION)[1][:3])
+
+    def query_stats(self):
+        reply = self.request(CMD_QUERY_STATS)[1]
+
+        return dict(zip(STATS_NAMES, struct.unpack(">%dI" % len(STATS_NAMES), reply)))
+
+    def query_errors(self):
+        reply = self.request(CMD_QUERY_ERRORS)[1]
+
+        return dict(zip(ERRORS_NAMES, struct.unpack(">%dI" % len(ERRORS_NAMES), reply)))
+
+    def set_baudrate(self, baudrate):
+        """Switches the display and the port to the baud rate.
+
+        The display replies at the old baud rate, then confirms the switch at the new one. The confirmation can come
+        before the port is switched, so a query at the new baud rate stands in for it. If the display stays at the
+        old baud rate, the port goes back to it and ProtocolError is raised.
+        """
+        previous = self.serial.baudrate
+
+        self.request(CMD_SET_BAUDRATE, struct.pack(">I", baudrate))
+
+        self.serial.baudrate = baudrate
+        self.flush_input()
+
+        try:
+            status, reply = self.receive(CMD_SET_BAUDRATE)
+            if (status == STATUS_OK) and (reply == struct.pack(">I", baudrate)):
+                return
+        except ProtocolError:
+            pass
+
+        try:
+            self.query_version()
+            return
+        except ProtocolError:
+            pass
+
+        self.serial.baudrate = previous
+        self.flush_input()
+        self.query_version()
+
+        raise ProtocolError("the display stays at %d baud, %d failed" % (previous, baudrate))
+
+    def query_credits(self):
+        return self.request(CMD_QUERY_CREDITS)[1][0]
+
+    def wait_credits(self, credits=1, timeout=5.0):
+        """Waits till the display can take the number of messages, MESSAGE_QUEUE_SIZE - till it takes all."""
+        deadline = time.monotonic() + timeout
+
+        while self.query_credits() < credits:
+            if time.monotonic() > deadline:
+                raise ProtocolError("the display takes no messages")
+            time.sleep(0.005)
+
+    def query_profile(self, region, reset=False):
+        """The statistics of the region: runs, min, max, mean and the histogram."""
+        status, reply = self.request(CMD_QUERY_PROFILE, bytes([region, PROFILE_RESET if reset else 0]), check=False)
+
+        if status == STATUS_UNKNOWN_COMMAND:
+            raise ProtocolError("the firmware is built without PROFILE")
+        if status != STATUS_OK:
+            raise ProtocolError("the region %d doesn't exist" % region)
+
+        numbers = struct.unpack(">%dI" % (len(reply) // 4), reply)
+
+        return {"count": numbers[0], "min": numbers[1], "max": numbers[2], "mean": numbers[3],
+                "buckets": list(numbers[4:])}
+
+    def query_stacks(self):
+        """MONITOR_STACK_MARGIN and the smallest free words of every thread: (number, free words, name)."""
+        reply = self.request(CMD_QUERY_STACKS)[1]
+        threads = []
+
+        for index in range(2, len(reply) - 10, 11):
+            number, free = struct.unpack(">BH", reply[index:index + 3])
+            threads.append((number, free, reply[index + 3:index + 11].rstrip(b"\0").decode("latin-1")))
+
+        return struct.unpack(">H", reply[:2])[0], threads
+
+    def bench_memdma(self, is_fill, size, runs):
+        """Runs the copy or fill of the size by CPU and by the stream, the memdma regions get the runs."""
+        status, _ = self.request(CMD_BENCH_MEMDMA, struct.pack(">BHB", 1 if is_fill else 0, size, runs), check=False)
+
+        if status == STATUS_UNKNOWN_COMMAND:
+            raise ProtocolError("the firmware is built without PROFILE")
+        if status != STATUS_OK:
+            raise ProtocolError("the benchmark of %d bytes failed: %s" % (size, STATUS_NAMES[status]))
+
+
+def add_port_arguments(parser):
+    parser.add_argument("--port", required=True, help="the serial port of the display")
+    parser.add_argument("--baudrate", type=int, default=115200, help="the baud rate the display works at now")